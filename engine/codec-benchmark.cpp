@@ -0,0 +1,374 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+// Codec benchmark. Runs corpora of messages through the value codecs and
+// reports throughput (MB/s of bson), bytes per message and allocations per
+// message, as a baseline for codec changes:
+//
+//   build    the Struct/Array builders (synthetic corpora only)
+//   encode   ValueCompressor::encode, one compressor for the corpus, like a session
+//   decode   ValueDecompressor::decode, one decompressor for the corpus
+//   json-w   write_json
+//   json-r   parse_json
+//
+// The synthetic corpora are generated with the kinds of packets that sessions
+// send: object changes, events, service requests, terrain maps and unit type
+// catalogues. Recorded corpora are saved by warstage-load-generator --record=FILE,
+// or by any runtime with a packet corpus set (see Runtime::setPacketCorpus).
+//
+// warstage-codec-benchmark --duration=2
+// warstage-codec-benchmark --corpus=packets.bin --corpus=other.bin --no-synthetic
+
+#include "value/builder.h"
+#include "value/compressor.h"
+#include "value/corpus.h"
+#include "value/decompressor.h"
+#include "value/json.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+
+
+namespace {
+    std::atomic<std::uint64_t> allocations{};
+}
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+
+namespace {
+    struct Options {
+        std::vector<std::string> corpora{};
+        double duration = 1.0;
+        bool synthetic = true;
+    };
+
+    struct Corpus {
+        std::string name{};
+        std::vector<Value> values{};
+        std::function<std::vector<Value>()> generate{}; // synthetic corpora only
+        std::size_t bytes = 0;
+    };
+
+    struct Result {
+        std::uint64_t passes = 0;
+        std::uint64_t allocations = 0;
+        double seconds = 0.0;
+        std::size_t outputBytes = 0; // per pass, zero if the output is bson
+    };
+
+    /*
+     * Runs the pass over the corpus until the duration has elapsed,
+     * at least once, and counts the allocations made by the passes.
+     */
+    Result measure(double duration, const std::function<std::size_t()>& pass) {
+        Result result{};
+        auto start = std::chrono::steady_clock::now();
+        auto allocationsBefore = allocations.load(std::memory_order_relaxed);
+        do {
+            result.outputBytes = pass();
+            ++result.passes;
+            result.seconds = std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
+        } while (result.seconds < duration);
+        result.allocations = allocations.load(std::memory_order_relaxed) - allocationsBefore;
+        return result;
+    }
+
+    void print(const Corpus& corpus, const char* codec, const Result& result) {
+        auto messages = static_cast<double>(corpus.values.size());
+        auto bytes = static_cast<double>(result.outputBytes != 0 ? result.outputBytes : corpus.bytes);
+        auto passes = static_cast<double>(result.passes);
+        std::printf("%-12s %-8s %10.1f %12.1f %12.2f\n",
+                corpus.name.c_str(), codec,
+                static_cast<double>(corpus.bytes) * passes / result.seconds / 1e6,
+                bytes / messages,
+                static_cast<double>(result.allocations) / (passes * messages));
+    }
+
+    void run(Corpus& corpus, double duration) {
+        corpus.bytes = 0;
+        for (const auto& value : corpus.values) {
+            corpus.bytes += value.size();
+        }
+        if (corpus.values.empty()) {
+            return;
+        }
+
+        if (corpus.generate) {
+            print(corpus, "build", measure(duration, [&corpus]() {
+                auto values = corpus.generate();
+                return std::size_t{0};
+            }));
+        }
+
+        print(corpus, "encode", measure(duration, [&corpus]() {
+            ValueCompressor compressor{};
+            std::size_t size = 0;
+            for (const auto& value : corpus.values) {
+                compressor.encode(value);
+                size += compressor.size();
+            }
+            return size;
+        }));
+
+        std::vector<std::string> encoded{};
+        ValueCompressor compressor{};
+        for (const auto& value : corpus.values) {
+            compressor.encode(value);
+            encoded.emplace_back(static_cast<const char*>(compressor.data()), compressor.size());
+        }
+        print(corpus, "decode", measure(duration, [&encoded]() {
+            ValueDecompressor decompressor{};
+            for (const auto& data : encoded) {
+                if (!decompressor.decode(data.data(), data.size())) {
+                    std::cerr << "decode failed\n";
+                    std::exit(1);
+                }
+            }
+            return std::size_t{0};
+        }));
+
+        std::vector<std::string> json{};
+        print(corpus, "json-w", measure(duration, [&corpus, &json]() {
+            json.clear();
+            std::size_t size = 0;
+            for (const auto& value : corpus.values) {
+                write_json(json.emplace_back(), value);
+                size += json.back().size();
+            }
+            return size;
+        }));
+
+        print(corpus, "json-r", measure(duration, [&json]() {
+            for (const auto& text : json) {
+                auto value = parse_json(text);
+            }
+            return std::size_t{0};
+        }));
+    }
+
+
+    /***/
+
+
+    class Random {
+        std::uint32_t seed_;
+    public:
+        explicit Random(std::uint32_t seed) : seed_{seed} {}
+        std::uint32_t next() {
+            seed_ = seed_ * 1103515245u + 12345u;
+            return seed_ >> 8u;
+        }
+        float uniform(float min, float max) {
+            return min + (max - min) * static_cast<float>(next() & 0xffffu) / 65535.0f;
+        }
+    };
+
+    Value makePacket(int id, const Value& payload) {
+        return Struct{}
+                << "i" << id
+                << "r" << id - 1
+                << "t" << 0
+                << "p" << payload
+                << ValueEnd{};
+    }
+
+    std::vector<Value> generateObjectChanges() {
+        Random random{1};
+        const auto federationId = ObjectId::create();
+        std::vector<ObjectId> objectIds(200);
+        for (auto& objectId : objectIds) {
+            objectId = ObjectId::create();
+        }
+        std::vector<Value> result{};
+        for (int i = 0; i != 500; ++i) {
+            auto changes = Struct{}
+                    << "m" << 6
+                    << "f" << federationId
+                    << "c" << Array{};
+            for (int j = 0; j != 8; ++j) {
+                auto& objectId = objectIds[random.next() % objectIds.size()];
+                changes = std::move(changes) << Struct{}
+                        << "o" << objectId
+                        << "c" << "Unit"
+                        << "t" << 0.04 * i
+                        << "p" << Struct{}
+                            << "center" << glm::vec2{random.uniform(0, 1024), random.uniform(0, 1024)}
+                            << "_facing" << random.uniform(-3.14f, 3.14f)
+                            << "_effectiveMorale" << random.uniform(0, 1)
+                            << "_fightersCount" << static_cast<int>(random.next() % 80)
+                            << ValueEnd{}
+                        << ValueEnd{};
+            }
+            result.push_back(makePacket(i, std::move(changes) << ValueEnd{} << ValueEnd{}));
+        }
+        return result;
+    }
+
+    std::vector<Value> generateEvents() {
+        Random random{2};
+        const auto federationId = ObjectId::create();
+        std::vector<Value> result{};
+        for (int i = 0; i != 500; ++i) {
+            result.push_back(makePacket(i, Struct{}
+                    << "m" << 7
+                    << "f" << federationId
+                    << "e" << "MissileRelease"
+                    << "v" << Struct{}
+                        << "unit" << ObjectId::create()
+                        << "position" << glm::vec3{random.uniform(0, 1024), random.uniform(0, 1024), 1.5f}
+                        << "velocity" << glm::vec3{random.uniform(-50, 50), random.uniform(-50, 50), 10.0f}
+                        << "count" << static_cast<int>(random.next() % 40)
+                        << ValueEnd{}
+                    << ValueEnd{}));
+        }
+        return result;
+    }
+
+    std::vector<Value> generateServiceRequests() {
+        Random random{3};
+        const auto federationId = ObjectId::create();
+        std::vector<Value> result{};
+        for (int i = 0; i != 500; ++i) {
+            result.push_back(makePacket(i, Struct{}
+                    << "m" << 9
+                    << "f" << federationId
+                    << "id" << i
+                    << "s" << "UpdateCommand"
+                    << "v" << Struct{}
+                        << "unit" << ObjectId::create()
+                        << "path" << std::vector<glm::vec2>{
+                                {random.uniform(0, 1024), random.uniform(0, 1024)},
+                                {random.uniform(0, 1024), random.uniform(0, 1024)},
+                                {random.uniform(0, 1024), random.uniform(0, 1024)}}
+                        << "running" << (random.next() % 2 == 0)
+                        << ValueEnd{}
+                    << ValueEnd{}));
+        }
+        return result;
+    }
+
+    std::vector<Value> generateTerrain() {
+        Random random{4};
+        std::vector<Value> result{};
+        for (int i = 0; i != 4; ++i) {
+            std::vector<unsigned char> height(256 * 256);
+            std::vector<unsigned char> woods(256 * 256);
+            for (std::size_t j = 0; j != height.size(); ++j) {
+                auto x = static_cast<float>(j % 256);
+                auto y = static_cast<float>(j / 256);
+                height[j] = static_cast<unsigned char>(128.0f + 60.0f * std::sin(x / 40.0f) * std::cos(y / 30.0f));
+                woods[j] = (static_cast<int>(x / 16) + static_cast<int>(y / 24) + i) % 5 == 0 ? 255 : 0;
+            }
+            result.push_back(makePacket(i, Struct{}
+                    << "m" << 9
+                    << "s" << "Terrain"
+                    << "v" << Struct{}
+                        << "size" << 256
+                        << "height" << Binary{height.data(), height.size()}
+                        << "woods" << Binary{woods.data(), woods.size()}
+                        << ValueEnd{}
+                    << ValueEnd{}));
+        }
+        return result;
+    }
+
+    std::vector<Value> generateCatalogue() {
+        Random random{5};
+        const char* weapons[] = {"bow", "arq", "sword", "pike", "cannon"};
+        std::vector<Value> result{};
+        for (int i = 0; i != 20; ++i) {
+            auto types = Struct{}
+                    << "m" << 9
+                    << "s" << "UnitTypes"
+                    << "v" << Array{};
+            for (int j = 0; j != 50; ++j) {
+                auto name = std::string{"unit-type-"} + weapons[j % 5] + "-" + std::to_string(j);
+                types = std::move(types) << Struct{}
+                        << "name" << name
+                        << "weapon" << weapons[j % 5]
+                        << "speed" << random.uniform(5, 20)
+                        << "range" << random.uniform(0, 300)
+                        << "fighters" << 40 + j % 40
+                        << "marker" << Struct{}
+                            << "texture" << "markers.png"
+                            << "origin" << glm::vec2{static_cast<float>(j % 8), static_cast<float>(j / 8)}
+                            << ValueEnd{}
+                        << ValueEnd{};
+            }
+            result.push_back(makePacket(i, std::move(types) << ValueEnd{} << ValueEnd{}));
+        }
+        return result;
+    }
+
+
+    bool parseOption(const char* arg, const char* name, double& value) {
+        auto length = std::strlen(name);
+        if (std::strncmp(arg, name, length) == 0) {
+            value = std::stod(arg + length);
+            return true;
+        }
+        return false;
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options{};
+    for (int i = 1; i != argc; ++i) {
+        if (std::strncmp(argv[i], "--corpus=", 9) == 0) {
+            options.corpora.emplace_back(argv[i] + 9);
+        } else if (std::strcmp(argv[i], "--no-synthetic") == 0) {
+            options.synthetic = false;
+        } else if (!parseOption(argv[i], "--duration=", options.duration)) {
+            std::cerr << "usage: " << argv[0] << " [--corpus=FILE]... [--no-synthetic] [--duration=SECONDS]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Corpus> corpora{};
+    if (options.synthetic) {
+        corpora.push_back(Corpus{"changes", {}, generateObjectChanges});
+        corpora.push_back(Corpus{"events", {}, generateEvents});
+        corpora.push_back(Corpus{"services", {}, generateServiceRequests});
+        corpora.push_back(Corpus{"terrain", {}, generateTerrain});
+        corpora.push_back(Corpus{"catalogue", {}, generateCatalogue});
+        for (auto& corpus : corpora) {
+            corpus.values = corpus.generate();
+        }
+    }
+    for (const auto& path : options.corpora) {
+        ValueCorpus recorded{};
+        if (!recorded.load(path.c_str())) {
+            std::cerr << "could not load " << path << "\n";
+            return 1;
+        }
+        corpora.push_back(Corpus{path, recorded.values()});
+    }
+
+    std::printf("%-12s %-8s %10s %12s %12s\n", "corpus", "codec", "MB/s", "bytes/msg", "allocs/msg");
+    for (auto& corpus : corpora) {
+        run(corpus, options.duration);
+    }
+    return 0;
+}
@@ -0,0 +1,448 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+// In-process load generator. Runs K runtimes connected in a star through
+// mock endpoints (runtime 0 is the master), with N federates on each runtime.
+// Every federate publishes P objects that are updated at a fixed rate, and
+// dispatches events at a fixed rate. Reports throughput and end-to-end
+// propagation latency, from the publishing federate to each receiving
+// federate, through Session, SessionFederate and Federation without sockets.
+//
+// With --threads=0 (default) everything runs on a single manual strand.
+// With --threads=T every session and federate gets a strand of its own,
+// on an io_context run by T threads, like the server runs sessions,
+// federates, supervisors and player windows on strands of their own.
+// --scaling runs the same load with 1, 2, 4, ... threads below the number
+// of cores and then with all cores, to show how throughput scales with
+// cores; use a rate high enough to saturate a single thread.
+//
+// With --record=FILE the packets sent by the sessions are saved as a corpus
+// for the codec benchmark (see codec-benchmark.cpp).
+//
+// warstage-load-generator --runtimes=3 --federates=2 --objects=200 --rate=10 --events=5 --duration=30
+// warstage-load-generator --runtimes=9 --federates=4 --objects=200 --rate=100 --scaling
+
+#include "async/strand.h"
+#include "runtime/federate.h"
+#include "runtime/metrics.h"
+#include "runtime/mock-endpoint.h"
+#include "runtime/runtime.h"
+#include "value/corpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace {
+    const std::chrono::steady_clock::time_point baseTimePoint = std::chrono::steady_clock::now();
+
+    double elapsedSeconds() {
+        return std::chrono::duration<double>{std::chrono::steady_clock::now() - baseTimePoint}.count();
+    }
+
+    struct Options {
+        int runtimes = 2;
+        int federates = 2;
+        int objects = 100;
+        int properties = 4;
+        double rate = 10.0;
+        double events = 10.0;
+        int eventSize = 32;
+        double duration = 10.0;
+        int threads = 0;
+        bool scaling = false;
+        bool metrics = false;
+        std::string record{};
+    };
+
+    struct Samples {
+        std::vector<double> latencies{};
+        std::uint64_t sent = 0;
+
+        void append(const Samples& other) {
+            latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+            sent += other.sent;
+        }
+
+        [[nodiscard]] double percentile(double p) const {
+            if (latencies.empty()) {
+                return 0.0;
+            }
+            auto index = static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1));
+            return 1000.0 * latencies[index];
+        }
+
+        void print(const char* name, double duration) {
+            std::sort(latencies.begin(), latencies.end());
+            std::printf("%-8s sent %10llu (%9.1f/s)  received %10zu (%9.1f/s)  latency ms p50 %7.3f  p90 %7.3f  p99 %7.3f  max %7.3f\n",
+                    name,
+                    static_cast<unsigned long long>(sent), static_cast<double>(sent) / duration,
+                    latencies.size(), static_cast<double>(latencies.size()) / duration,
+                    percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0));
+        }
+    };
+
+    struct LoadFederate {
+        int index = 0;
+        std::shared_ptr<Strand_base> strand{};
+        std::shared_ptr<Federate> federate{};
+        std::vector<ObjectRef> objects{};
+        std::shared_ptr<IntervalObject> updateInterval{};
+        std::shared_ptr<IntervalObject> eventInterval{};
+        std::atomic_int discovered{};
+        std::unordered_map<ObjectId, double> received{}; // last sent time seen, federate strand
+        Samples updates{}; // federate strand
+        Samples events{}; // federate strand
+        int tick = 0;
+    };
+
+    /*
+     * Either a single manual strand run by the calling thread, or
+     * an io_context run by a number of threads, with a strand for
+     * every session and federate.
+     */
+    class LoadContext {
+        std::shared_ptr<Strand_Manual> manual_{};
+        std::shared_ptr<boost::asio::io_context> ioc_{};
+        std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work_{};
+        std::vector<std::thread> threads_{};
+
+    public:
+        explicit LoadContext(int threads) {
+            if (threads == 0) {
+                manual_ = std::make_shared<Strand_Manual>();
+            } else {
+                ioc_ = std::make_shared<boost::asio::io_context>(threads);
+                work_.emplace(ioc_->get_executor());
+                for (int i = 0; i != threads; ++i) {
+                    threads_.emplace_back([ioc = ioc_]() {
+                        ioc->run();
+                    });
+                }
+            }
+        }
+
+        ~LoadContext() {
+            stop();
+        }
+
+        [[nodiscard]] std::shared_ptr<Strand_base> makeStrand(const char* label) const {
+            if (manual_) {
+                return manual_;
+            }
+            return std::make_shared<Strand_Asio>(ioc_->get_executor(), label);
+        }
+
+        void runFor(double seconds, const std::function<bool()>& done = {}) {
+            double stopTime = elapsedSeconds() + seconds;
+            while (elapsedSeconds() < stopTime && !(done && done())) {
+                if (manual_) {
+                    manual_->run();
+                    if (manual_->isDone()) {
+                        std::this_thread::sleep_for(std::chrono::microseconds{100});
+                    }
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                }
+            }
+        }
+
+        void stop() {
+            if (ioc_) {
+                work_.reset();
+                ioc_->stop();
+                for (auto& thread : threads_) {
+                    thread.join();
+                }
+                threads_.clear();
+            }
+        }
+    };
+
+    struct LoadResult {
+        Samples updates{};
+        Samples events{};
+    };
+
+    void updateObjects(LoadFederate& load, const std::vector<std::string>& propertyNames, std::uint64_t receivers) {
+        Federate::BatchScope batch{*load.federate};
+        auto tick = static_cast<float>(++load.tick);
+        for (auto& object : load.objects) {
+            object["sent"] = elapsedSeconds();
+            object["position"] = glm::vec2{tick, 0.5f * tick};
+            for (auto& propertyName : propertyNames) {
+                object[propertyName.c_str()] = static_cast<double>(tick);
+            }
+        }
+        load.updates.sent += load.objects.size() * receivers;
+    }
+
+    void dispatchEvent(LoadFederate& load, const std::string& payload, std::uint64_t receivers) {
+        load.federate->getEventClass("Load").dispatch(Struct{}
+                << "origin" << load.index
+                << "sent" << elapsedSeconds()
+                << "payload" << payload.c_str()
+                << ValueEnd{});
+        load.events.sent += receivers;
+    }
+
+    Promise<void> shutdownLoad(std::vector<std::unique_ptr<LoadFederate>>& federates,
+            std::vector<std::shared_ptr<MockEndpoint>>& endpoints,
+            std::vector<std::unique_ptr<Runtime>>& runtimes,
+            std::atomic_bool& done) {
+        for (auto& load : federates) {
+            co_await load->federate->shutdown();
+        }
+        for (auto& endpoint : endpoints) {
+            co_await endpoint->shutdown();
+        }
+        for (auto& runtime : runtimes) {
+            co_await runtime->shutdown();
+        }
+        done = true;
+    }
+
+    LoadResult runLoad(const Options& options, Metrics& metrics, ValueCorpus* corpus = nullptr) {
+        LoadContext context{options.threads};
+        auto mainStrand = context.makeStrand("main");
+        PromiseUtils::strand_ = mainStrand;
+        const ObjectId federationId = ObjectId::create();
+
+        std::vector<std::unique_ptr<Runtime>> runtimes{};
+        std::vector<std::shared_ptr<MockEndpoint>> endpoints{};
+        for (int i = 0; i != options.runtimes; ++i) {
+            auto& runtime = *runtimes.emplace_back(std::make_unique<Runtime>(ProcessType::Daemon));
+            runtime.setMetrics(&metrics);
+            runtime.setPacketCorpus(corpus);
+            auto& endpoint = endpoints.emplace_back(std::make_shared<MockEndpoint>(runtime, context.makeStrand("endpoint")));
+            endpoint->setStrandFactory([&context]() {
+                return context.makeStrand("session");
+            });
+        }
+        for (int i = 1; i < options.runtimes; ++i) {
+            endpoints[i]->setMasterEndpoint(*endpoints[0]);
+        }
+        for (auto& runtime : runtimes) {
+            runtime->initiateFederation_safe(federationId, FederationType::Battle);
+        }
+
+        std::vector<std::string> propertyNames{};
+        for (int i = 0; i != options.properties; ++i) {
+            propertyNames.push_back("p" + std::to_string(i));
+        }
+        const std::string payload(static_cast<std::size_t>(std::max(options.eventSize, 0)), 'x');
+
+        std::vector<std::unique_ptr<LoadFederate>> federates{};
+        for (auto& runtime : runtimes) {
+            for (int i = 0; i != options.federates; ++i) {
+                auto& load = *federates.emplace_back(std::make_unique<LoadFederate>());
+                load.index = static_cast<int>(federates.size()) - 1;
+                load.strand = context.makeStrand("federate");
+                auto name = "Load" + std::to_string(load.index);
+                load.federate = std::make_shared<Federate>(*runtime, name.c_str(), load.strand);
+                load.federate->startup(federationId);
+            }
+        }
+        const auto receivers = static_cast<std::uint64_t>(federates.size() - 1);
+
+        for (auto& federate : federates) {
+            federate->strand->setImmediate([&load = *federate, &options]() {
+                auto& objectClass = load.federate->getObjectClass("Load");
+                objectClass.observe([&load](ObjectRef object) {
+                    if (object["origin"_int] == load.index) {
+                        return;
+                    }
+                    if (object.justDiscovered()) {
+                        load.received[object.getObjectId()] = object["sent"_double];
+                        ++load.discovered;
+                    } else if (object["sent"].hasChanged()) {
+                        // delayed values may be notified more than once
+                        double sent = object["sent"_double];
+                        auto& received = load.received[object.getObjectId()];
+                        if (sent != received) {
+                            received = sent;
+                            load.updates.latencies.push_back(elapsedSeconds() - sent);
+                        }
+                    }
+                });
+                load.federate->getEventClass("Load").subscribe([&load](const Value& params) {
+                    if (params["origin"_int] != load.index) {
+                        load.events.latencies.push_back(elapsedSeconds() - params["sent"_double]);
+                    }
+                });
+
+                Federate::BatchScope batch{*load.federate};
+                for (int i = 0; i != options.objects; ++i) {
+                    auto object = objectClass.create();
+                    object["origin"] = load.index;
+                    object["sent"] = elapsedSeconds();
+                    load.objects.push_back(object);
+                }
+            });
+        }
+        const int expected = static_cast<int>(receivers) * options.objects;
+        context.runFor(60.0, [&federates, expected]() {
+            return std::all_of(federates.begin(), federates.end(), [expected](auto& load) {
+                return load->discovered >= expected;
+            });
+        });
+
+        for (auto& load : federates) {
+            if (options.rate > 0.0) {
+                load->updateInterval = load->strand->setInterval([&load = *load, &propertyNames, receivers]() {
+                    updateObjects(load, propertyNames, receivers);
+                }, 1000.0 / options.rate);
+            }
+            if (options.events > 0.0) {
+                load->eventInterval = load->strand->setInterval([&load = *load, &payload, receivers]() {
+                    dispatchEvent(load, payload, receivers);
+                }, 1000.0 / options.events);
+            }
+        }
+
+        context.runFor(options.duration);
+
+        for (auto& load : federates) {
+            if (load->updateInterval) {
+                clearInterval(*load->updateInterval);
+            }
+            if (load->eventInterval) {
+                clearInterval(*load->eventInterval);
+            }
+        }
+        context.runFor(0.5); // let updates in flight arrive
+
+        std::atomic_bool done{};
+        mainStrand->setImmediate([&]() {
+            shutdownLoad(federates, endpoints, runtimes, done).done();
+        });
+        context.runFor(60.0, [&done]() {
+            return done.load();
+        });
+        context.stop();
+
+        LoadResult result{};
+        for (auto& load : federates) {
+            result.updates.append(load->updates);
+            result.events.append(load->events);
+            load->objects.clear();
+        }
+        for (auto& runtime : runtimes) {
+            runtime->setMetrics(nullptr);
+        }
+        PromiseUtils::strand_ = nullptr;
+        return result;
+    }
+
+    bool parseOption(const char* arg, const char* name, double& value) {
+        auto length = std::strlen(name);
+        if (std::strncmp(arg, name, length) == 0) {
+            value = std::stod(arg + length);
+            return true;
+        }
+        return false;
+    }
+
+    bool parseOption(const char* arg, const char* name, std::string& value) {
+        auto length = std::strlen(name);
+        if (std::strncmp(arg, name, length) == 0) {
+            value = arg + length;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseOption(const char* arg, const char* name, int& value) {
+        auto length = std::strlen(name);
+        if (std::strncmp(arg, name, length) == 0) {
+            value = std::stoi(arg + length);
+            return true;
+        }
+        return false;
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options{};
+    for (int i = 1; i != argc; ++i) {
+        if (std::strcmp(argv[i], "--metrics") == 0) {
+            options.metrics = true;
+        } else if (std::strcmp(argv[i], "--scaling") == 0) {
+            options.scaling = true;
+        } else if (!parseOption(argv[i], "--runtimes=", options.runtimes)
+                && !parseOption(argv[i], "--federates=", options.federates)
+                && !parseOption(argv[i], "--objects=", options.objects)
+                && !parseOption(argv[i], "--properties=", options.properties)
+                && !parseOption(argv[i], "--rate=", options.rate)
+                && !parseOption(argv[i], "--events=", options.events)
+                && !parseOption(argv[i], "--event-size=", options.eventSize)
+                && !parseOption(argv[i], "--duration=", options.duration)
+                && !parseOption(argv[i], "--threads=", options.threads)
+                && !parseOption(argv[i], "--record=", options.record)) {
+            std::cerr << "usage: " << argv[0]
+                    << " [--runtimes=K] [--federates=N] [--objects=P] [--properties=M]"
+                    << " [--rate=HZ] [--events=HZ] [--event-size=BYTES] [--duration=SECONDS]"
+                    << " [--threads=T] [--scaling] [--metrics] [--record=FILE]\n";
+            return 1;
+        }
+    }
+    options.runtimes = std::max(options.runtimes, 1);
+    options.federates = std::max(options.federates, 1);
+    options.threads = std::max(options.threads, 0);
+
+    std::cout << "runtimes " << options.runtimes
+            << ", federates " << options.runtimes * options.federates
+            << ", objects " << options.runtimes * options.federates * options.objects
+            << ", running for " << options.duration << " s\n";
+
+    auto metrics = std::make_shared<Metrics>();
+
+    if (options.scaling) {
+        int cores = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        std::vector<int> threadCounts{};
+        for (int threads = 1; threads < cores; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(cores);
+
+        std::printf("%8s %14s %14s %10s %10s\n", "threads", "updates/s", "events/s", "p50 ms", "p99 ms");
+        for (int threads : threadCounts) {
+            options.threads = threads;
+            auto result = runLoad(options, *metrics);
+            std::sort(result.updates.latencies.begin(), result.updates.latencies.end());
+            std::printf("%8d %14.1f %14.1f %10.3f %10.3f\n",
+                    threads,
+                    static_cast<double>(result.updates.latencies.size()) / options.duration,
+                    static_cast<double>(result.events.latencies.size()) / options.duration,
+                    result.updates.percentile(0.5),
+                    result.updates.percentile(0.99));
+        }
+    } else {
+        std::unique_ptr<ValueCorpus> corpus{};
+        if (!options.record.empty()) {
+            corpus = std::make_unique<ValueCorpus>();
+        }
+        auto result = runLoad(options, *metrics, corpus.get());
+        result.updates.print("updates", options.duration);
+        result.events.print("events", options.duration);
+        if (corpus) {
+            if (!corpus->save(options.record.c_str())) {
+                std::cerr << "could not save " << options.record << "\n";
+                return 1;
+            }
+            std::cout << "recorded " << corpus->values().size() << " packets to " << options.record << "\n";
+        }
+    }
+
+    if (options.metrics) {
+        std::cout << metrics->render();
+    }
+
+    return 0;
+}
@@ -2,8 +2,11 @@
 #include "matchmaker/lobby-supervisor.h"
 #include "player/player-window.h"
 #include "player/player-endpoint.h"
+#include "runtime/metrics.h"
+#include "runtime/metrics-endpoint.h"
 #include "utilities/logging.h"
 #include <iostream>
+#include <thread>
 
 #define BOOST_TEST_MODULE warstage engine
 #define BOOST_TEST_NO_MAIN
@@ -12,9 +15,18 @@
 
 int main(int argc, char *argv[]) {
     int port = 0;
+    int metricsPort = 0;
+    bool metricsLog = false;
+    int threads = 1;
     for (int i = 1; i != argc; ++i) {
         if (std::strncmp(argv[i], "--port=", 7) == 0) {
             port = std::stoi(argv[i] + 7);
+        } else if (std::strncmp(argv[i], "--metrics-port=", 15) == 0) {
+            metricsPort = std::stoi(argv[i] + 15);
+        } else if (std::strcmp(argv[i], "--metrics-log") == 0) {
+            metricsLog = true;
+        } else if (std::strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::stoi(argv[i] + 10);
         }
     }
 
@@ -22,7 +34,37 @@ int main(int argc, char *argv[]) {
         return ::boost::unit_test::unit_test_main( &init_unit_test_suite, argc, argv );
     }
 
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+
+    // sessions, session federates, supervisors, battle simulators and
+    // player windows each run on their own strand, so they are spread
+    // over the threads; the main strand only runs work that was not
+    // given a strand of its own
+    PromiseUtils::strand_ = Strand::getMain(); // before any other thread can initialize it
+
+    auto metrics = std::make_shared<Metrics>();
+    int strandCollectorId = metrics->addCollector([](Metrics& m) {
+        m.gauge("warstage_strand_pending", "strand=\"main\"").set(static_cast<std::int64_t>(Strand::getMain()->getPendingCount()));
+    });
+    std::shared_ptr<IntervalObject> metricsInterval{};
+    if (metricsLog) {
+        metricsInterval = Strand::getMain()->setInterval([metrics]() {
+            LOG_I("metrics\n%s", metrics->render().c_str());
+        }, 60 * 1000);
+    }
+
+    std::shared_ptr<MetricsEndpoint> metricsEndpoint{};
+    if (metricsPort != 0) {
+        metricsEndpoint = std::make_shared<MetricsEndpoint>(metrics, Strand::io_context());
+        if (metricsEndpoint->startup_safe(metricsPort) == 0) {
+            std::cout << "metrics endpoint could not listen on port " << metricsPort << "\n";
+        }
+    }
+
     auto playerEndpoint = std::make_shared<PlayerEndpoint>(Strand::io_context());
+    playerEndpoint->setMetrics(metrics);
     playerEndpoint->startup(port);
 
     boost::asio::signal_set signals{*Strand::io_context()};
@@ -30,9 +72,17 @@ int main(int argc, char *argv[]) {
     signals.add(SIGINT);
     signals.add(SIGQUIT);
     signals.add(SIGTERM);
-    signals.async_wait([&playerEndpoint](const boost::system::error_code& error, int signal_number) {
+    signals.async_wait([&playerEndpoint, &metricsEndpoint, &metricsInterval](const boost::system::error_code& error, int signal_number) {
         std::cout << "signal " << signal_number << ", stopping surface endpoint\n";
+        if (metricsInterval) {
+            clearInterval(*metricsInterval);
+        }
         auto promise = Promise<void>{}.resolve();
+        if (metricsEndpoint) {
+            promise = promise.onResolve<Promise<void>>([&metricsEndpoint]() {
+                return metricsEndpoint->shutdown();
+            });
+        }
         if (playerEndpoint) {
             promise = promise.onResolve<Promise<void>>([&playerEndpoint]() {
                 return playerEndpoint->shutdown();
@@ -49,7 +99,9 @@ int main(int argc, char *argv[]) {
         }).done();
     });
 
-    Strand::runUntilStopped(1);
+    std::cout << "running on " << threads << " thread(s)\n";
+    Strand::runUntilStopped(threads);
+    metrics->removeCollector(strandCollectorId);
     std::cout << "done\n";
 
     return 0;
@@ -26,9 +26,9 @@ struct PromiseUtils {
 
   [[nodiscard]] static Promise<void> all(const std::vector<Promise<void>>& promises);
 
-  static void ExecuteImmediate(Strand_base* strand, const std::function<void()>& callback) {
+  template <typename F> static void ExecuteImmediate(Strand_base* strand, F&& callback) {
       if (strand) {
-          strand->setImmediate(callback);
+          strand->post(std::forward<F>(callback));
       } else {
           callback();
       }
@@ -372,7 +372,7 @@ inline Promise<T> Promise<T>::resolve(const ValueType& value) const {
         scope_->value = value;
         for (auto& callback : scope_->callbacks) {
             if (callback.resolve) {
-                PromiseUtils::ExecuteImmediate(callback.strand.get(), [callback = callback.resolve, scope = scope_]() {
+                PromiseUtils::ExecuteImmediate(callback.strand.get(), [callback = std::move(callback.resolve), scope = scope_]() {
                   callback(scope->value);
                 });
             }
@@ -415,7 +415,7 @@ inline Promise<void> Promise<void>::resolve() const {
         scope_->state = PromiseState::Fulfilled;
         for (auto& callback : scope_->callbacks) {
             if (callback.resolve) {
-                PromiseUtils::ExecuteImmediate(callback.strand.get(), [callback = callback.resolve, scope = scope_]() {
+                PromiseUtils::ExecuteImmediate(callback.strand.get(), [callback = std::move(callback.resolve), scope = scope_]() {
                   callback();
                 });
             }
@@ -466,7 +466,7 @@ inline Promise<T> Promise<T>::reject(const std::exception_ptr& reason) const {
         scope_->reason = reason;
         for (auto& callback : scope_->callbacks) {
             if (callback.reject) {
-                PromiseUtils::ExecuteImmediate(callback.strand.get(), [reject = callback.reject, scope = scope_]() {
+                PromiseUtils::ExecuteImmediate(callback.strand.get(), [reject = std::move(callback.reject), scope = scope_]() {
                   reject(scope->reason);
                 });
             }
@@ -484,7 +484,7 @@ inline Promise<void> Promise<void>::reject(const std::exception_ptr& reason) con
         scope_->reason = reason;
         for (auto& callback : scope_->callbacks) {
             if (callback.reject) {
-                PromiseUtils::ExecuteImmediate(callback.strand.get(), [reject = callback.reject, scope = scope_]() {
+                PromiseUtils::ExecuteImmediate(callback.strand.get(), [reject = std::move(callback.reject), scope = scope_]() {
                   reject(scope->reason);
                 });
             }
@@ -42,12 +42,19 @@ void Strand_Asio::Context::runUntilStopped(int threadCount) {
     }
   }
   context_->run();
-  assert(!work_);
-  context_->reset();
+
+  // stop() may be called from any of the threads, so the
+  // threads are joined here rather than in stop()
+  std::vector<std::unique_ptr<std::thread>> threads{};
   {
     std::lock_guard lock{threadsMutex_};
-    assert(threads_.empty());
+    std::swap(threads, threads_);
   }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  assert(!work_);
+  context_->reset();
 }
 
 
@@ -60,11 +67,6 @@ void Strand_Asio::Context::runUntilDone() {
 void Strand_Asio::Context::stop() {
   work_ = nullptr;
   context_->stop();
-  for (auto& thread : threads_) {
-    thread->join();
-  }
-  std::lock_guard lock{threadsMutex_};
-  threads_.clear();
 }
 
 
@@ -113,6 +115,7 @@ std::shared_ptr<ImmediateObject> Strand_Asio::setImmediate(std::function<void()>
 #else
   result->callback_ = std::move(callback);
 #endif
+  pendingCount_.fetch_add(1, std::memory_order_relaxed);
   boost::asio::post(strand_, [weak_, result]() {
     ImmediateObject_Asio::dispatch(weak_, result);
   });
@@ -120,6 +123,35 @@ std::shared_ptr<ImmediateObject> Strand_Asio::setImmediate(std::function<void()>
 }
 
 
+/*
+ * The handler holds the task by value and asio recycles handler memory,
+ * so unlike setImmediate nothing is allocated per post.
+ */
+void Strand_Asio::postTask(StrandTask task) {
+#ifdef WARSTAGE_ENABLE_ASYNC_MONKEY
+  Strand_base::postTask(std::move(task));
+#else
+  pendingCount_.fetch_add(1, std::memory_order_relaxed);
+  boost::asio::post(strand_, [weak_ = weak_from_this(), task = std::move(task)]() mutable {
+    auto strandLock = weak_.lock();
+    if (!strandLock) {
+      LOG_X("Strand_Asio::postTask: deleted strand");
+      return;
+    }
+    strandLock->pendingCount_.fetch_sub(1, std::memory_order_relaxed);
+    try {
+      Strand_base::SetCurrent current{strandLock};
+      task();
+    } catch (std::exception& e) {
+      LOG_EXCEPTION(e);
+    } catch (...) {
+      LOG_EXCEPTION(std::runtime_error("post"));
+    }
+  });
+#endif
+}
+
+
 void TimeoutObject_Asio::dispatch(const std::weak_ptr<Strand_Asio>& strand, const std::shared_ptr<TimeoutObject_Asio>& timeout) {
   auto strandLock = strand.lock();
   if (!strandLock) {
@@ -191,6 +223,7 @@ void ImmediateObject_Asio::dispatch(const std::weak_ptr<Strand_Asio>& strand, co
     LOG_X("ImmediateObject_Asio: deleted strand");
     return;
   }
+  strandLock->pendingCount_.fetch_sub(1, std::memory_order_relaxed);
   std::function<void()> callback;
   std::unique_lock lock{immediate->mutex_};
   callback = std::move(immediate->callback_);
@@ -6,6 +6,7 @@
 
 #include "strand.h"
 #include "strand-base.h"
+#include <atomic>
 #include <mutex>
 #include <boost/asio.hpp>
 
@@ -41,6 +42,7 @@ public:
 
   boost::asio::strand<boost::asio::any_io_executor> strand_;
   std::string label_;
+  std::atomic<std::size_t> pendingCount_{}; // posted immediates and tasks not yet dispatched
 
   struct SetCurrent {
     std::shared_ptr<Strand_Asio> strand_;
@@ -65,6 +67,9 @@ public:
   std::shared_ptr<TimeoutObject> setTimeout(std::function<void()> callback, double delay) override;
   std::shared_ptr<IntervalObject> setInterval(std::function<void()> callback, double delay) override;
   std::shared_ptr<ImmediateObject> setImmediate(std::function<void()> callback) override;
+  void postTask(StrandTask task) override;
+
+  [[nodiscard]] std::size_t getPendingCount() const { return pendingCount_.load(std::memory_order_relaxed); }
 };
 
 class TimeoutObject_Asio : public TimeoutObject {
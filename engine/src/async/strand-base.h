@@ -4,6 +4,7 @@
 #ifndef WARSTAGE__ASYNC__STRAND_BASE_H
 #define WARSTAGE__ASYNC__STRAND_BASE_H
 
+#include "./strand-task.h"
 #include <cassert>
 #include <mutex>
 #include <experimental/coroutine>
@@ -11,14 +12,10 @@
 
 class ImmediateObject;
 class IntervalObject;
-class Strand_Manual;
 class TimeoutObject;
 
 
 class Strand_base {
-    static std::mutex mutex__;
-    static std::shared_ptr<Strand_Manual> render__;
-
 protected:
     static thread_local std::shared_ptr<Strand_base> current__;
 
@@ -43,8 +40,6 @@ public:
     Strand_base() = default;
     virtual ~Strand_base() = default;
 
-    static std::shared_ptr<Strand_Manual> getRender();
-
     [[nodiscard]] static std::shared_ptr<Strand_base> getCurrent() {
         return current__;
     }
@@ -57,6 +52,13 @@ public:
     virtual std::shared_ptr<IntervalObject> setInterval(std::function<void()> callback, double delay) = 0;
     virtual std::shared_ptr<ImmediateObject> setImmediate(std::function<void()> callback) = 0;
 
+    // Like setImmediate, for callbacks that are never cleared, so there
+    // is no ImmediateObject to allocate (see StrandTask)
+    template <typename F> void post(F&& callback) {
+        postTask(StrandTask{std::forward<F>(callback)});
+    }
+    virtual void postTask(StrandTask task);
+
     Strand_base(const Strand_base&) = delete;
     Strand_base& operator=(const Strand_base&) = delete;
     Strand_base(Strand_base&&) = default;
@@ -71,7 +73,7 @@ public:
     template <typename P>
     void await_suspend(std::experimental::coroutine_handle<P> handle) noexcept {
         assert(!isCurrent());
-        setImmediate([address = handle.address()]() {
+        post([address = handle.address()]() {
             std::experimental::coroutine_handle<P>::from_address(address).resume();
         });
     }
@@ -0,0 +1,119 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__ASYNC__STRAND_TASK_H
+#define WARSTAGE__ASYNC__STRAND_TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// A move-only callable for Strand_base::post(). Callables that fit in
+// InlineSize bytes, e.g. a lambda capturing a shared_ptr and a Value,
+// are stored inline so posting them does not allocate, larger ones are
+// stored on the heap.
+
+class StrandTask {
+public:
+  static constexpr std::size_t InlineSize = 96;
+
+private:
+  struct Operations {
+    void (*invoke)(void* storage);
+    void (*relocate)(void* target, void* source) noexcept; // moves and destroys source
+    void (*destroy)(void* storage) noexcept;
+  };
+
+  template <typename F> static constexpr bool IsInline = sizeof(F) <= InlineSize
+      && alignof(F) <= alignof(std::max_align_t)
+      && std::is_nothrow_move_constructible_v<F>;
+
+  template <typename F> struct InlineOperations {
+    static void invoke(void* storage) {
+      (*static_cast<F*>(storage))();
+    }
+    static void relocate(void* target, void* source) noexcept {
+      ::new (target) F{std::move(*static_cast<F*>(source))};
+      static_cast<F*>(source)->~F();
+    }
+    static void destroy(void* storage) noexcept {
+      static_cast<F*>(storage)->~F();
+    }
+    static constexpr Operations operations{invoke, relocate, destroy};
+  };
+
+  template <typename F> struct HeapOperations {
+    static void invoke(void* storage) {
+      (**static_cast<F**>(storage))();
+    }
+    static void relocate(void* target, void* source) noexcept {
+      *static_cast<F**>(target) = *static_cast<F**>(source);
+    }
+    static void destroy(void* storage) noexcept {
+      delete *static_cast<F**>(storage);
+    }
+    static constexpr Operations operations{invoke, relocate, destroy};
+  };
+
+  alignas(std::max_align_t) unsigned char storage_[InlineSize];
+  const Operations* operations_{};
+
+public:
+  StrandTask() = default;
+
+  template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, StrandTask>>>
+  StrandTask(F&& callable) {
+    using T = std::decay_t<F>;
+    if constexpr (IsInline<T>) {
+      ::new (static_cast<void*>(storage_)) T{std::forward<F>(callable)};
+      operations_ = &InlineOperations<T>::operations;
+    } else {
+      *reinterpret_cast<T**>(storage_) = new T{std::forward<F>(callable)};
+      operations_ = &HeapOperations<T>::operations;
+    }
+  }
+
+  StrandTask(StrandTask&& other) noexcept : operations_{other.operations_} {
+    if (operations_) {
+      operations_->relocate(storage_, other.storage_);
+      other.operations_ = nullptr;
+    }
+  }
+
+  StrandTask& operator=(StrandTask&& other) noexcept {
+    if (this != &other) {
+      reset();
+      if ((operations_ = other.operations_)) {
+        operations_->relocate(storage_, other.storage_);
+        other.operations_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  StrandTask(const StrandTask&) = delete;
+  StrandTask& operator=(const StrandTask&) = delete;
+
+  ~StrandTask() {
+    reset();
+  }
+
+  explicit operator bool() const { return operations_ != nullptr; }
+
+  void operator()() {
+    operations_->invoke(storage_);
+  }
+
+private:
+  void reset() noexcept {
+    if (operations_) {
+      operations_->destroy(storage_);
+      operations_ = nullptr;
+    }
+  }
+};
+
+
+#endif
@@ -4,6 +4,7 @@
 #include <boost/test/unit_test.hpp>
 #include "async/promise.h"
 #include "async/strand.h"
+#include <array>
 #include <random>
 
 namespace {
@@ -29,6 +30,78 @@ BOOST_AUTO_TEST_SUITE(async_strand)
         BOOST_CHECK_EQUAL(counter.load(), 1);
     }
 
+    BOOST_AUTO_TEST_CASE(asio_should_serialize_strands_on_many_threads) {
+        Strand_Asio::Context context{};
+        std::vector<std::shared_ptr<Strand>> strands(4);
+        std::generate(strands.begin(), strands.end(), [&context](){ return context.makeStrand(""); });
+        std::vector<std::atomic_bool> running(strands.size());
+        std::vector<int> counters(strands.size());
+        std::atomic_int remaining = static_cast<int>(strands.size()) * 1000;
+        std::atomic_int overlapping = 0;
+        for (std::size_t i = 0; i != strands.size(); ++i) {
+            for (int j = 0; j != 1000; ++j) {
+                strands[i]->setImmediate([&, i]() {
+                    if (running[i].exchange(true)) {
+                        ++overlapping;
+                    }
+                    ++counters[i];
+                    running[i] = false;
+                    if (--remaining == 0) {
+                        context.stop(); // from any of the threads
+                    }
+                });
+            }
+        }
+        context.runUntilStopped(4);
+        BOOST_CHECK_EQUAL(overlapping.load(), 0);
+        for (auto counter : counters) {
+            BOOST_CHECK_EQUAL(counter, 1000);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(asio_should_post_in_order_with_immediates) {
+        Strand_Asio::Context context{};
+        auto strand = context.makeStrand("");
+        std::vector<int> order{};
+        for (int i = 0; i != 100; ++i) {
+            if (i % 2) {
+                strand->post([strand, &order, i]() {
+                    BOOST_CHECK(strand->isCurrent());
+                    order.push_back(i);
+                });
+            } else {
+                strand->setImmediate([&order, i]() {
+                    order.push_back(i);
+                });
+            }
+        }
+        BOOST_CHECK_EQUAL(100, strand->getPendingCount());
+        context.runUntilDone();
+        BOOST_CHECK_EQUAL(0, strand->getPendingCount());
+        BOOST_REQUIRE_EQUAL(100, order.size());
+        for (int i = 0; i != 100; ++i) {
+            BOOST_CHECK_EQUAL(i, order[i]);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(strand_task_should_move_inline_and_heap_callables) {
+        auto shared = std::make_shared<int>(0);
+        StrandTask small{[shared]() { ++*shared; }};
+        StrandTask moved{std::move(small)};
+        BOOST_CHECK(!small);
+        moved();
+        BOOST_CHECK_EQUAL(1, *shared);
+
+        std::array<char, StrandTask::InlineSize + 1> data{};
+        StrandTask large{[shared, data]() { *shared += 1 + data[0]; }};
+        moved = std::move(large);
+        moved();
+        BOOST_CHECK_EQUAL(2, *shared);
+        BOOST_CHECK_EQUAL(2, shared.use_count());
+        moved = StrandTask{};
+        BOOST_CHECK_EQUAL(1, shared.use_count());
+    }
+
     /***/
 
     BOOST_AUTO_TEST_CASE(asio_should_execute_immediate_on_correct_strand) {
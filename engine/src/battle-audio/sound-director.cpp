@@ -17,6 +17,11 @@ SoundDirector::SoundDirector(std::shared_ptr<Federate> systemFederate) :
 }
 
 
+const std::shared_ptr<Strand_base>& SoundDirector::getStrand() const {
+    return systemFederate_->getStrand();
+}
+
+
 void SoundDirector::PlaySound(SoundSampleID sample, bool loop, SoundCookieID cookie) {
   systemFederate_->getServiceClass("PlaySound").request(Struct{}
       << "sample" << static_cast<int>(sample)
@@ -48,7 +53,7 @@ void SoundDirector::StopSound(SoundChannelID channel, SoundCookieID cookie) {
 
 
 void SoundDirector::StopAll() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     infantryWalking_ = false;
     infantryRunning_ = false;
     cavalryWalking_ = false;
@@ -64,7 +69,7 @@ void SoundDirector::StopAll() {
 
 
 void SoundDirector::Tick(double secondsSinceLastTick) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
 
     TickHorse(secondsSinceLastTick);
     TickSword(secondsSinceLastTick);
@@ -93,13 +98,13 @@ void SoundDirector::TickSword(double secondsSinceLastTick) {
 
 
 void SoundDirector::PlayBackground() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     PlaySound(SoundSampleID::Background, true);
 }
 
 
 void SoundDirector::UpdateInfantryWalking(bool value) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     if (value && !infantryWalking_)
         PlaySound(SoundSampleID::InfantryWalking, true);
     else if (!value && infantryWalking_)
@@ -109,7 +114,7 @@ void SoundDirector::UpdateInfantryWalking(bool value) {
 
 
 void SoundDirector::UpdateInfantryRunning(bool value) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     if (value && !infantryRunning_)
         PlaySound(SoundSampleID::InfantryRunning, true);
     else if (!value && infantryRunning_)
@@ -119,7 +124,7 @@ void SoundDirector::UpdateInfantryRunning(bool value) {
 
 
 void SoundDirector::UpdateCavalryWalking(bool value) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     if (value && !cavalryWalking_)
         PlaySound(SoundSampleID::CavalryWalking, true);
     else if (!value && cavalryWalking_)
@@ -129,7 +134,7 @@ void SoundDirector::UpdateCavalryWalking(bool value) {
 
 
 void SoundDirector::UpdateCavalryRunning(bool value) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     if (value && !cavalryRunning_)
         PlaySound(SoundSampleID::CavalryRunning, true);
     else if (!value && cavalryRunning_)
@@ -139,13 +144,13 @@ void SoundDirector::UpdateCavalryRunning(bool value) {
 
 
 void SoundDirector::UpdateCavalryCount(int value) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     cavalryCount_ = value;
 }
 
 
 void SoundDirector::UpdateMeleeCavalry(bool value) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     if (value && !meleeCavalry_)
         PlaySound(SoundSampleID::MeleeCavalry, true);
     else if (!value && meleeCavalry_)
@@ -155,7 +160,7 @@ void SoundDirector::UpdateMeleeCavalry(bool value) {
 
 
 void SoundDirector::UpdateMeleeInfantry(bool value) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     if (value && !meleeInfantry_)
         PlaySound(SoundSampleID::MeleeInfantry, true);
     else if (!value && meleeInfantry_)
@@ -165,7 +170,7 @@ void SoundDirector::UpdateMeleeInfantry(bool value) {
 
 
 void SoundDirector::UpdateMeleeCharging() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     bool isMelee = meleeCavalry_ || meleeInfantry_;
     if (!meleeCharging_ && isMelee) {
         if (std::chrono::system_clock::now() > meleeChargeTimer_) {
@@ -180,32 +185,32 @@ void SoundDirector::UpdateMeleeCharging() {
 
 
 void SoundDirector::PlayMissileArrows(SoundCookieID cookie) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     PlaySound(SoundSampleID::MissileArrows, false, cookie);
 }
 
 
 void SoundDirector::PlayMissileImpact() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     PlaySound(RandomMissileImpactSample(), false);
 }
 
 
 void SoundDirector::PlayMissileMatchlock() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     SoundSampleID soundSample = RandomMatchlockSample();
     PlaySound(soundSample, false);
 }
 
 
 void SoundDirector::PlayMissileCannon() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     PlaySound(SoundSampleID::MissileCannon1, false);
 }
 
 
 void SoundDirector::PlayCasualty() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     auto now = std::chrono::system_clock::now();
     if (now > casualtyTimer_) {
         SoundSampleID soundSample = RandomCasualtySample();
@@ -216,7 +221,7 @@ void SoundDirector::PlayCasualty() {
 
 
 void SoundDirector::PlayUserInterfaceSound(SoundSampleID soundSampleID) {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(getStrand()->isCurrent());
     PlaySound(soundSampleID, false);
 }
 
@@ -111,6 +111,10 @@ public:
     SoundDirector(const SoundDirector&) = delete;
     SoundDirector& operator=(const SoundDirector&) = delete;
 
+    // the strand of the system federate, all other methods but
+    // PlaySound and StopSound must be called on it
+    [[nodiscard]] const std::shared_ptr<Strand_base>& getStrand() const;
+
     void PlaySound(SoundSampleID sample, bool loop, SoundCookieID cookie = SoundCookieID::None);
     void StopSound(SoundChannelID channel);
     void StopSound(SoundChannelID channel, SoundCookieID cookie);
@@ -18,7 +18,7 @@ CameraGesture::CameraGesture(Surface* gestureSurface, UnitController* unitContro
 
 
 void CameraGesture::Animate() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(unitController_->getStrand()->isCurrent());
 
     auto now = std::chrono::system_clock::now();
 
@@ -50,7 +50,7 @@ void CommandGesture::ObserveUnit(ObjectRef& unit) {
 
 
 void CommandGesture::Animate() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(unitController_->getStrand()->isCurrent());
 
     if (unitController_->acquireTerrainMap()) {
         UpdateUnitGesture();
@@ -78,7 +78,7 @@ void EditorGesture::PointerWasCancelled(Pointer* pointer) {
 void EditorGesture::StartInterval() {
     if (!interval_) {
         auto weak_ = weak_from_this();
-        interval_ = Strand::getMain()->setInterval([weak_]() {
+        interval_ = unitController_->getStrand()->setInterval([weak_]() {
           if (auto this_ = weak_.lock()) {
             if (this_->HasCapturedPointer()) {
               if (this_->unitController_->acquireTerrainMap()) {
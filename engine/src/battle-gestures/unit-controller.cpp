@@ -14,8 +14,8 @@
 #define SNAP_TO_UNIT_TRESHOLD 22 // meters
 
 
-UnitController::UnitController(Runtime* runtime, Surface* gestureSurface, Viewport& viewport, EditorObserver* editorObserver, SoundDirector* soundDirector) :
-        strand_{Strand::getMain()},
+UnitController::UnitController(Runtime* runtime, std::shared_ptr<Strand_base> strand, Surface* gestureSurface, Viewport& viewport, EditorObserver* editorObserver, SoundDirector* soundDirector) :
+        strand_{std::move(strand)},
         gestureSurface_{gestureSurface},
         viewport_{&viewport},
         runtime_{runtime},
@@ -439,10 +439,9 @@ void UnitController::UpdateCameraObject() {
 
 
 void UnitController::UpdateRuntimeObjects() {
-  battleFederate_->enterBlock_strand();
-    UpdateUnitGestureMarkerObjects();
-    UpdateUnitGestureGroupObjects();
-  battleFederate_->leaveBlock_strand();
+  Federate::BatchScope batch{*battleFederate_};
+  UpdateUnitGestureMarkerObjects();
+  UpdateUnitGestureGroupObjects();
 }
 
 
@@ -26,7 +26,7 @@ class UnitController :
         public Shutdownable,
         public std::enable_shared_from_this<UnitController>
 {
-    std::shared_ptr<Strand> strand_{};
+    std::shared_ptr<Strand_base> strand_{};
     Surface* gestureSurface_{};
     Viewport* viewport_{};
     std::mutex terrainMapMutex_{};
@@ -66,9 +66,11 @@ public:
     EditorObserver* editorObserver_{};
 
 public:
-    UnitController(Runtime* runtime, Surface* gestureSurface, Viewport& viewport, EditorObserver* editorObserver, SoundDirector* soundDirector);
+    UnitController(Runtime* runtime, std::shared_ptr<Strand_base> strand, Surface* gestureSurface, Viewport& viewport, EditorObserver* editorObserver, SoundDirector* soundDirector);
     ~UnitController() override;
 
+    [[nodiscard]] const std::shared_ptr<Strand_base>& getStrand() const { return strand_; }
+
     void Startup(ObjectId battleFederationId, const std::string& playerId);
 
 protected: // Shutdownable
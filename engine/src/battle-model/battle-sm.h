@@ -7,6 +7,7 @@
 #include "geometry/quad-tree.h"
 #include "utilities/memory.h"
 #include "runtime/runtime.h"
+#include "./unit-object.h"
 #include <array>
 #include <string>
 #include <vector>
@@ -289,6 +290,7 @@ namespace BattleSM {
 
   struct Unit {
     ObjectRef object{};
+    TypedObject<UnitObjectState> objectState{};
     ObjectId unitId{};
     ObjectId allianceId{};
 
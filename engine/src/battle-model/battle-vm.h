@@ -7,6 +7,7 @@
 #include "runtime/runtime.h"
 #include "battle-audio/sound-director.h"
 #include "battle-simulator/battle-objects.h"
+#include "./unit-object.h"
 #include <unordered_map>
 
 class TerrainMap;
@@ -179,6 +180,7 @@ namespace BattleVM {
   class Unit {
   public:
     ObjectRef object = {};
+    TypedObject<UnitObjectState> objectState = {};
     ObjectId unitId = {};
     ObjectId allianceId = {};
 
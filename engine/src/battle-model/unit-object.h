@@ -0,0 +1,43 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__BATTLE_MODEL__UNIT_OBJECT_H
+#define WARSTAGE__BATTLE_MODEL__UNIT_OBJECT_H
+
+#include "runtime/typed-object.h"
+#include <glm/glm.hpp>
+
+
+// The properties of Unit objects that the simulator updates every time
+// step, and that the battle view reads every frame
+
+struct UnitObjectState {
+  glm::vec2 position{};
+  glm::vec2 destination{};
+  bool standing{};
+  bool moving{};
+  float angleStart{};
+  float angleLength{};
+  bool loading{};
+  float loadingProgress{};
+  float effectiveMorale{};
+  bool routing{};
+  int fighterCount{};
+};
+
+template <> struct TypedSchema<UnitObjectState> {
+  static constexpr auto properties = std::make_tuple(
+      typedProperty("_position", &UnitObjectState::position),
+      typedProperty("_destination", &UnitObjectState::destination),
+      typedProperty("_standing", &UnitObjectState::standing),
+      typedProperty("_moving", &UnitObjectState::moving),
+      typedProperty("_angleStart", &UnitObjectState::angleStart),
+      typedProperty("_angleLength", &UnitObjectState::angleLength),
+      typedProperty("_loading", &UnitObjectState::loading),
+      typedProperty("_loadingProgress", &UnitObjectState::loadingProgress),
+      typedProperty("_effectiveMorale", &UnitObjectState::effectiveMorale),
+      typedProperty("_routing", &UnitObjectState::routing),
+      typedProperty("_fighterCount", &UnitObjectState::fighterCount));
+};
+
+#endif
@@ -3,6 +3,10 @@
 
 #include "./battle-simulator.h"
 #include "./convert-value.h"
+#include "runtime/interest-policy.h"
+#include "runtime/metrics.h"
+#include "runtime/object-schema.h"
+#include <algorithm>
 #include <cstdlib>
 #include <glm/gtc/random.hpp>
 #include <sstream>
@@ -70,6 +74,76 @@ glm::vec2 BattleModel::GetFrontLeft(const Formation& formation, glm::vec2 center
 }
 
 
+/*
+ * Positions are on the 1024 m terrain map with centimetre precision
+ * or better, morale is shown as a bar and needs only 8 bits.
+ */
+const ObjectSchema& BattleSimulator::getObjectSchema() {
+  static const ObjectSchema schema = []() {
+    ObjectSchema result{};
+    for (auto property : {"center", "_position", "_destination", "path", "_path"}) {
+      result.define("Unit", property, ValueEncoding::fixed(0.0f, 1024.0f, 17));
+    }
+    result.define("Unit", "_effectiveMorale", ValueEncoding::fixed(-2.0f, 2.0f, 8));
+    return result;
+  }();
+  return schema;
+}
+
+
+namespace {
+  /*
+   * Units far from the player's camera are rate limited, and sent
+   * without their fighters, unless they belong to the player's
+   * commander or alliance. The player's commander is the one with
+   * the player's subject id.
+   */
+  class BattleInterestPolicy : public InterestPolicy {
+    static constexpr float InterestDistance = 512.0f;
+
+  public:
+    [[nodiscard]] std::optional<glm::vec2> getCameraPosition(ObjectRef object) const override {
+      if (object.getObjectClass() != "_Camera") {
+        return std::nullopt;
+      }
+      return glm::vec2{object["value"_value]["position"_vec3]};
+    }
+
+    void updateInterest(SessionInterest& interest, ObjectRef object, const std::string& subjectId) const override {
+      if (object.getObjectClass() == "Commander") {
+        const char* playerId = object["playerId"_c_str];
+        if (playerId && subjectId == playerId) {
+          interest.objectIds = {object.getObjectId(), object["alliance"_ObjectId]};
+        }
+      }
+    }
+
+    [[nodiscard]] bool shouldFilterObject(ObjectRef object) const override {
+      return object.getObjectClass() == "Unit";
+    }
+
+    [[nodiscard]] bool isWithinInterest(const SessionInterest& interest, ObjectRef object) const override {
+      for (auto objectId : {object["commander"_ObjectId], object["alliance"_ObjectId]}) {
+        if (objectId && std::find(interest.objectIds.begin(), interest.objectIds.end(), objectId) != interest.objectIds.end()) {
+          return true;
+        }
+      }
+      return glm::distance(object["center"_vec2], interest.cameraPosition) <= InterestDistance;
+    }
+
+    [[nodiscard]] bool isLowPriority(const Property& property) const override {
+      return property.getName() == "fighters";
+    }
+  };
+}
+
+
+const InterestPolicy& BattleSimulator::getInterestPolicy() {
+  static const BattleInterestPolicy policy{};
+  return policy;
+}
+
+
 BattleSimulator::BattleSimulator(Runtime& runtime) {
   simulatorStrand_ = Strand::makeStrand("simulator");
   battleFederate_ = std::make_shared<Federate>(runtime, "Battle/Simulator", simulatorStrand_);
@@ -333,6 +407,7 @@ RootPtr<Unit> BattleSimulator::MakeUnit(const ObjectRef& unitObject) {
   auto unit = RootPtr<Unit>{new Unit{}};
 
   unit->object = unitObject;
+  unit->objectState = TypedObject<UnitObjectState>{unitObject};
 
   float minimumRange = 0.0f;
   float maximumRange = 0.0f;
@@ -484,6 +559,9 @@ void BattleSimulator::SimulateTimeStep() {
   if (battleFederate_) {
     battleFederate_->updateCurrentTime_strand();
     if (interval_) {
+      auto metrics = battleFederate_->getRuntime().getMetrics();
+      auto start = metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+      Federate::BatchScope batch{*battleFederate_};
       UpdateUnitEntityFromObject();
 
       // RebuildQuadTree
@@ -758,6 +836,13 @@ void BattleSimulator::SimulateTimeStep() {
         battleStatistics_["countCavalryInMelee"] = model_->CountCavalryInMelee();
         battleStatistics_["countInfantryInMelee"] = model_->CountInfantryInMelee();
       }
+
+      if (metrics) {
+        if (!tickDuration_) {
+          tickDuration_ = &metrics->histogram("warstage_simulator_tick_seconds");
+        }
+        tickDuration_->observe(std::chrono::steady_clock::now() - start);
+      }
     }
   }
     releaseTerrainMap();
@@ -1505,28 +1590,27 @@ void BattleSimulator::UpdateUnitObjectsFromEntities() {
 
 
 void BattleSimulator::UpdateUnitObjectFromEntity_Local(Unit& unit) {
-  unit.object["_position"] = unit.state.formation.center;
-  unit.object["_destination"] = unit.command.path.empty() ? unit.state.formation.center : unit.command.path.back();
-  unit.object["_standing"] = unit.state.formation.unitMode == UnitMode::Standing;
-  unit.object["_moving"] = unit.state.formation.unitMode == UnitMode::Moving;
-  unit.object["_formation"] = FormationToBson(unit.formation);
-  unit.object["_path"] = unit.command.path;
-
-  unit.object["_angleStart"] = unit.missileRange.angleStart;
-  unit.object["_angleLength"] = unit.missileRange.angleLength;
-  unit.object["_rangeValues"] = unit.missileRange.actualRanges;
-
   auto loadingProgress = unit.state.missile.loadingDuration != 0
       ? std::make_pair(true, unit.state.missile.loadingTimer / unit.state.missile.loadingDuration)
       : std::make_pair(false, 0.0f);
-  unit.object["_loading"] = loadingProgress.first;
-  unit.object["_loadingProgress"] = loadingProgress.second;
-
-  unit.object["_effectiveMorale"] = unit.state.emotion.GetEffectiveMorale();
-  unit.object["_routing"] = unit.state.emotion.IsRouting();
 
+  unit.objectState.set(UnitObjectState{
+      .position = unit.state.formation.center,
+      .destination = unit.command.path.empty() ? unit.state.formation.center : unit.command.path.back(),
+      .standing = unit.state.formation.unitMode == UnitMode::Standing,
+      .moving = unit.state.formation.unitMode == UnitMode::Moving,
+      .angleStart = unit.missileRange.angleStart,
+      .angleLength = unit.missileRange.angleLength,
+      .loading = loadingProgress.first,
+      .loadingProgress = loadingProgress.second,
+      .effectiveMorale = unit.state.emotion.GetEffectiveMorale(),
+      .routing = unit.state.emotion.IsRouting(),
+      .fighterCount = static_cast<int>(unit.elements.size())
+  });
 
-  unit.object["_fighterCount"] = static_cast<int>(unit.elements.size());
+  unit.object["_formation"] = FormationToBson(unit.formation);
+  unit.object["_path"] = unit.command.path;
+  unit.object["_rangeValues"] = unit.missileRange.actualRanges;
 
   std::vector<glm::vec3> elements{};
   for (auto& element : unit.elements) {
@@ -11,6 +11,9 @@
 #include <random>
 #include <string>
 
+class InterestPolicy;
+class MetricsHistogram;
+class ObjectSchema;
 class TerrainMap;
 
 
@@ -25,6 +28,7 @@ class BattleSimulator :
     std::shared_ptr<Strand> simulatorStrand_;
     std::shared_ptr<Federate> battleFederate_{};
     std::shared_ptr<IntervalObject> interval_{};
+    MetricsHistogram* tickDuration_{};
 
     std::vector<std::pair<float, BattleSM::Shooting>> shootings_{};
     std::unordered_map<ObjectId, int> allianceCasualtyCount_{};
@@ -45,6 +49,12 @@ class BattleSimulator :
 public:
     explicit BattleSimulator(Runtime& runtime);
 
+    // the precision of unit properties sent to other processes
+    [[nodiscard]] static const ObjectSchema& getObjectSchema();
+
+    // the units that are rate limited when sent to players
+    [[nodiscard]] static const InterestPolicy& getInterestPolicy();
+
     void Startup(ObjectId battleFederationId);
 
 protected: // Shutdownable
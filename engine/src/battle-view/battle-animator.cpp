@@ -48,17 +48,17 @@ void BattleAnimator::AddProjectile(BattleVM::Volley& volley, glm::vec3 position1
 
 void BattleAnimator::PlayVolleyReleaseSound(const BattleVM::MissileStats& missileStats, float delay, SoundCookieID soundCookieId) {
   if (missileStats.trajectoryShape == "bullet") {
-    Strand::getMain()->setImmediate([soundDirector = soundDirector_]() {
+    soundDirector_->getStrand()->setImmediate([soundDirector = soundDirector_]() {
       soundDirector->PlayMissileMatchlock();
     });
   }
   if (missileStats.trajectoryShape == "arrow") {
-    Strand::getMain()->setImmediate([soundDirector = soundDirector_, soundCookie = soundCookieId]() {
+    soundDirector_->getStrand()->setImmediate([soundDirector = soundDirector_, soundCookie = soundCookieId]() {
       soundDirector->PlayMissileArrows(soundCookie);
     });
   }
   if (missileStats.trajectoryShape == "cannonball") {
-    Strand::getMain()->setTimeout([soundDirector = soundDirector_]() {
+    soundDirector_->getStrand()->setTimeout([soundDirector = soundDirector_]() {
       soundDirector->PlayMissileCannon();
     }, delay * 1000);
   }
@@ -112,14 +112,14 @@ bool BattleAnimator::AnimateVolley(BattleVM::Volley& volley, float seconds) {
     }
 
     if (volley.missileStats.trajectoryShape == "arrow") {
-      Strand::getMain()->setImmediate([soundDirector = soundDirector_]() {
+      soundDirector_->getStrand()->setImmediate([soundDirector = soundDirector_]() {
         soundDirector->PlayMissileImpact();
       });
     }
   }
 
   if (!alive && volley.soundCookie != SoundCookieID::None) {
-    Strand::getMain()->setImmediate([soundDirector = soundDirector_, soundCookie = volley.soundCookie]() {
+    soundDirector_->getStrand()->setImmediate([soundDirector = soundDirector_, soundCookie = volley.soundCookie]() {
       soundDirector->StopSound(SoundChannelID::MissileArrows, soundCookie);
     });
   }
@@ -38,9 +38,10 @@ namespace {
 }
 
 
-BattleView::BattleView(Runtime& runtime, Viewport& viewport, std::shared_ptr<SoundDirector> soundDirector) :
+BattleView::BattleView(Runtime& runtime, Viewport& viewport, std::shared_ptr<Strand_base> renderStrand, std::shared_ptr<SoundDirector> soundDirector) :
         viewport_{&viewport},
         graphics_{viewport.getGraphics()},
+        renderStrand_{std::move(renderStrand)},
         soundDirector_{soundDirector},
         cameraState_{std::make_shared<CameraState>(static_cast<bounds2f>(viewport.getViewportBounds()), viewport.getScaling())},
         battleAnimator_{viewModel_, soundDirector},
@@ -57,7 +58,7 @@ BattleView::BattleView(Runtime& runtime, Viewport& viewport, std::shared_ptr<Sou
     renderTerrain_ = new TerrainRenderer(this);
     renderWater_ = new WaterRenderer(*graphics_);
 
-    battleFederate_ = std::make_shared<Federate>(runtime, "Battle/BattleView", Strand::getRender());
+    battleFederate_ = std::make_shared<Federate>(runtime, "Battle/BattleView", renderStrand_);
 }
 
 
@@ -130,7 +131,7 @@ void BattleView::startup(ObjectId battleFederationId, const std::string& playerI
             }
             this_->releaseTerrainMap_();
 
-            Strand::getMain()->setImmediate([soundDirector = this_->soundDirector_]() {
+            this_->soundDirector_->getStrand()->setImmediate([soundDirector = this_->soundDirector_]() {
                 soundDirector->PlayCasualty();
             });
         }
@@ -176,7 +177,7 @@ void BattleView::startup(ObjectId battleFederationId, const std::string& playerI
 
 
 Promise<void> BattleView::shutdown_() {
-    co_await *Strand::getRender();
+    co_await *renderStrand_;
 
     viewModel_.units.clear();
 
@@ -223,6 +224,7 @@ Viewport& BattleView::getViewport() {
 void BattleView::handleUnitDiscovered_(ObjectRef object) {
     auto* unitVM = new BattleVM::Unit{
             .object = object,
+            .objectState = TypedObject<UnitObjectState>{object},
             .unitId = object.getObjectId()
     };
     viewModel_.units.emplace_back(unitVM);
@@ -702,7 +704,7 @@ void BattleView::animate_(double secondsSinceLastUpdate) {
 
         updateSoundPlayer_();
 
-        Strand::getMain()->setImmediate([soundDirector = soundDirector_, secondsSinceLastUpdate]() {
+        soundDirector_->getStrand()->setImmediate([soundDirector = soundDirector_, secondsSinceLastUpdate]() {
             soundDirector->Tick(secondsSinceLastUpdate);
         });
 
@@ -782,7 +784,7 @@ void BattleView::updateSoundPlayer_() {
         //winnerAllianceId = _battleStatistics["winnerAlliance"_ObjectId];
     }
 
-    Strand::getMain()->setImmediate([soundDirector = soundDirector_,
+    soundDirector_->getStrand()->setImmediate([soundDirector = soundDirector_,
             cavalryWalking, cavalryRunning, cavalryCount,
             infantryWalking, infantryRunning,
             meleeInfantry, meleeCavalry,
@@ -36,6 +36,7 @@ class BattleView :
 public:
     Viewport* viewport_;
     Graphics* graphics_{};
+    std::shared_ptr<Strand_base> renderStrand_{};
     std::shared_ptr<SoundDirector> soundDirector_{};
 
     std::string playerId_{};
@@ -71,7 +72,7 @@ public:
     BattleAnimator battleAnimator_;
 
 public:
-    BattleView(Runtime& runtime, Viewport& viewport, std::shared_ptr<SoundDirector> soundDirector);
+    BattleView(Runtime& runtime, Viewport& viewport, std::shared_ptr<Strand_base> renderStrand, std::shared_ptr<SoundDirector> soundDirector);
     ~BattleView() override;
 
     ObjectId getFederationId() const;
@@ -14,8 +14,8 @@ void FacingVertices::update(const BattleView& battleView) {
     for (const auto& unitVM : battleView.getUnits_()) {
         if (const auto& unitObject = unitVM->object) {
             if (battleView.isCommandable_(unitObject)
-                    && unitObject["_standing"_bool]
-                    && !unitObject["_routing"_bool]
+                    && unitVM->objectState.get<&UnitObjectState::standing>()
+                    && !unitVM->objectState.get<&UnitObjectState::routing>()
                     && !unitObject["meleeTarget"_ObjectId]) {
                 appendUnitFacingMarker(battleView, *unitVM);
             }
@@ -24,7 +24,7 @@ void FacingVertices::update(const BattleView& battleView) {
 
     for (const auto& unitVM : battleView.getUnits_()) {
         if (const auto& unitObject = unitVM->object) {
-            if (battleView.shouldShowMovementPath_(unitObject) && unitObject["_moving"_bool]) {
+            if (battleView.shouldShowMovementPath_(unitObject) && unitVM->objectState.get<&UnitObjectState::moving>()) {
                 appendMovementFacingMarker(battleView, *unitVM);
             }
         }
@@ -49,8 +49,8 @@ void FacingVertices::appendUnitFacingMarker(const BattleView& battleView, const
         } else*/ if (unitObject["missileTarget"_ObjectId] == unitObject.getObjectId()) {
             xindex = 11;
         } else {
-            if (unitObject["_loading"_bool]) {
-                xindex = 2 + (int)glm::round(9.0f * unitObject["_loadingProgress"_float]);
+            if (const auto& state = unitVM.objectState.get(); state.loading) {
+                xindex = 2 + (int)glm::round(9.0f * state.loadingProgress);
                 xindex = glm::min(10, xindex);
             }
         }
@@ -70,7 +70,7 @@ void FacingVertices::appendUnitFacingMarker(const BattleView& battleView, const
 
         float facing = unitObject["facing"_float];
 
-        bounds2f bounds = battleView.getCameraState().GetUnitFacingMarkerBounds(unitObject["_position"_vec2], facing);
+        bounds2f bounds = battleView.getCameraState().GetUnitFacingMarkerBounds(unitVM.objectState.get<&UnitObjectState::position>(), facing);
         glm::vec2 p = bounds.mid();
         float size = bounds.y().size();
         float direction = xindex >= 2 || yindex != 0 ? -glm::half_pi<float>() : (facing - cameraState->GetCameraFacing());
@@ -94,7 +94,7 @@ void FacingVertices::appendMovementFacingMarker(const BattleView& battleView, co
     if (const auto& unitObject = unitVM.object) {
         CameraState* cameraState = &battleView.getCameraState();
 
-        bounds2f b = battleView.getCameraState().GetUnitFacingMarkerBounds(unitObject["_destination"_vec2], unitObject["facing"_float]);
+        bounds2f b = battleView.getCameraState().GetUnitFacingMarkerBounds(unitVM.objectState.get<&UnitObjectState::destination>(), unitObject["facing"_float]);
         glm::vec2 p = b.mid();
         float size = b.y().size();
         float direction = unitObject["facing"_float] - cameraState->GetCameraFacing();
@@ -46,7 +46,7 @@ BattleVM::MarkerState MarkerVertices::getMarkerState(BattleView* battleView_, co
     auto result = BattleVM::MarkerState::None;
 
     const float routingBlinkTime = unitVM.GetRoutingBlinkTime();
-    const bool routingIndicator = unitVM.object["_routing"_bool]
+    const bool routingIndicator = unitVM.objectState.get<&UnitObjectState::routing>()
             || (routingBlinkTime != 0 && bounds1f{0.0f, 0.2f}.contains(unitVM.routingTimer));
 
     if (routingIndicator) {
@@ -76,7 +76,7 @@ void MarkerVertices::renderUnitMarker(BattleView* battleView_, const BattleVM::U
     if (!unitVM.object) {
         return;
     }
-    const auto position = battleView_->getHeightMap().getPosition(unitVM.object["_position"_vec2], 0);
+    const auto position = battleView_->getHeightMap().getPosition(unitVM.objectState.get<&UnitObjectState::position>(), 0);
     const auto state = getMarkerState(battleView_, unitVM);
     addVerticesMarker(position, unitVM.marker, state, 1.0f);
 }
@@ -100,9 +100,9 @@ void MarkerVertices::renderDestinationMarker(BattleView* battleView_, const Batt
     if (!unitVM.object || unitVM.object["meleeTarget"_ObjectId] || !battleView_->shouldShowMovementPath_(unitVM.object)) {
         return;
     }
-    const auto destination = unitVM.object["_destination"_vec2];
+    const auto destination = unitVM.objectState.get<&UnitObjectState::destination>();
     const auto path = DecodeArrayVec2(unitVM.object["_path"_value]);
-    if (path.size() <= 2 && glm::length(unitVM.object["_position"_vec2] - destination) < 25.0f) {
+    if (path.size() <= 2 && glm::length(unitVM.objectState.get<&UnitObjectState::position>() - destination) < 25.0f) {
         return;
     }
     const auto position = battleView_->getHeightMap().getPosition(destination, 0.5f);
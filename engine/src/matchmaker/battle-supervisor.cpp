@@ -2,9 +2,10 @@
 
 
 BattleSupervisor::BattleSupervisor(Runtime& runtime, const char* federateName, std::shared_ptr<Strand> strand) :
-    runtime_{&runtime} {
-    battleFederate_ = std::make_shared<Federate>(runtime, federateName, strand);
-    lobbyFederate_ = std::make_shared<Federate>(runtime, federateName, strand);
+    runtime_{&runtime},
+    strand_{std::move(strand)} {
+    battleFederate_ = std::make_shared<Federate>(runtime, federateName, strand_);
+    lobbyFederate_ = std::make_shared<Federate>(runtime, federateName, strand_);
 }
 
 
@@ -62,7 +63,7 @@ void BattleSupervisor::Startup(ObjectId lobbyFederationId, ObjectId battleFedera
     
     /***/
     
-    interval_ = Strand::getMain()->setInterval([weak_]() {
+    interval_ = strand_->setInterval([weak_]() {
       if (auto this_ = weak_.lock()) {
         this_->DeleteDeadUnits();
 
@@ -9,6 +9,7 @@ class BattleSupervisor :
         public std::enable_shared_from_this<BattleSupervisor>
 {
     Runtime* runtime_{};
+    std::shared_ptr<Strand> strand_{};
     ObjectId matchId_{};
     std::shared_ptr<Federate> lobbyFederate_{};
     std::shared_ptr<Federate> battleFederate_{};
@@ -139,12 +139,12 @@ void LobbySupervisor::Startup(ObjectId federationId) {
         });
     }
 
-    auto processFederations = federate_->getRuntime().addRuntimeObserver_safe(*this);
+    auto processFederations = federate_->getRuntime().addRuntimeObserver_safe(*this, strand_);
     for (auto& i : processFederations) {
         if (i.federationId == federationId) {
-            PromiseUtils::Strand()->setImmediate([weak_, processId = i.processId, processType = i.processType, federationId = i.federationId]() {
+            strand_->setImmediate([weak_, processId = i.processId, processType = i.processType, federationId = i.federationId]() {
                 if (auto this_ = weak_.lock()) {
-                  this_->onProcessAdded_main(federationId, processId, processType);
+                  this_->onProcessAdded_strand(federationId, processId, processType);
                 }
             });
         }
@@ -177,7 +177,7 @@ Promise<void> LobbySupervisor::shutdown_() {
 /***/
 
 
-void LobbySupervisor::onProcessAdded_main(ObjectId federationId, ObjectId processId, ProcessType processType) {
+void LobbySupervisor::onProcessAdded_strand(ObjectId federationId, ObjectId processId, ProcessType processType) {
     switch (processType) {
         case ProcessType::Player: {
             if (federationId == federate_->getFederationId()) {
@@ -217,7 +217,7 @@ void LobbySupervisor::onProcessAdded_main(ObjectId federationId, ObjectId proces
 }
 
 
-void LobbySupervisor::onProcessRemoved_main(ObjectId federationId, ObjectId processId) {
+void LobbySupervisor::onProcessRemoved_strand(ObjectId federationId, ObjectId processId) {
     LOG_X("OnProcessLeaveFederation %s - %s",
             processId.debug_str().c_str(),
             federationId.debug_str().c_str());
@@ -228,7 +228,7 @@ void LobbySupervisor::onProcessRemoved_main(ObjectId federationId, ObjectId proc
 }
 
 
-void LobbySupervisor::onProcessAuthenticated_main(ObjectId processId, const ProcessAuth& processAuth) {
+void LobbySupervisor::onProcessAuthenticated_strand(ObjectId processId, const ProcessAuth& processAuth) {
     if (processId == federate_->getRuntime().getProcessId()
             && federate_->getRuntime().getProcessType() == ProcessType::Player
             && module_) {
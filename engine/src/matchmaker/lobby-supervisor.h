@@ -13,7 +13,7 @@ class LobbySupervisor :
 {
 protected: // should be private
     const std::shared_ptr<Federate> federate_{};
-    const std::shared_ptr<Strand_base> strand_; // Strand::getMain()
+    const std::shared_ptr<Strand_base> strand_;
     const std::string moduleUrl_;
     std::unordered_map<ObjectId, Federation*> battleFederations_{};
     std::shared_ptr<IntervalObject> housekeepingInterval_{};
@@ -34,9 +34,9 @@ protected: // Shutdownable
     [[nodiscard]] Promise<void> shutdown_() override;
 
 protected: // RuntimeObserver
-    void onProcessAdded_main(ObjectId federationId, ObjectId processId, ProcessType processType) override;
-    void onProcessRemoved_main(ObjectId federationId, ObjectId processId) override;
-    void onProcessAuthenticated_main(ObjectId processId, const ProcessAuth& processAuth) override;
+    void onProcessAdded_strand(ObjectId federationId, ObjectId processId, ProcessType processType) override;
+    void onProcessRemoved_strand(ObjectId federationId, ObjectId processId) override;
+    void onProcessAuthenticated_strand(ObjectId processId, const ProcessAuth& processAuth) override;
 
 protected: // should be private:
     void OwnershipCallback(const ObjectRef& object, Property& property, OwnershipNotification notification);
@@ -6,7 +6,7 @@ MasterSupervisionPolicy::MasterSupervisionPolicy() {
 
 std::shared_ptr<Shutdownable> MasterSupervisionPolicy::makeSupervisor(Runtime& runtime, FederationType federationType, ObjectId federationId) {
     if (federationType == FederationType::Lobby) {
-          auto result = std::make_shared<LobbySupervisor>(runtime, "Supervisor", Strand::getMain(), "");
+          auto result = std::make_shared<LobbySupervisor>(runtime, "Supervisor", Strand::makeStrand("LobbySupervisor"), "");
           result->Startup(federationId);
           return result;
     }
@@ -9,7 +9,9 @@
 #include "matchmaker/lobby-supervisor.h"
 
 
-PlayerBackend::PlayerBackend(Runtime &runtime) : runtime_{&runtime} {
+PlayerBackend::PlayerBackend(Runtime &runtime, std::shared_ptr<Strand_base> strand) :
+    runtime_{&runtime},
+    strand_{std::move(strand)} {
 }
 
 
@@ -24,7 +26,7 @@ PlayerBackend::~PlayerBackend() {
 void PlayerBackend::startup() {
   auto weak_ = weak_from_this();
 
-  systemFederate_ = std::make_shared<Federate>(*runtime_, "PlayerBackend", Strand::getMain());
+  systemFederate_ = std::make_shared<Federate>(*runtime_, "PlayerBackend", strand_);
 
   systemFederate_->getObjectClass("Launcher").observe([weak_](ObjectRef launcher) {
     if (auto this_ = weak_.lock()) {
@@ -85,7 +87,7 @@ Promise<Value> PlayerBackend::processCreateLobby(const Value& params) {
 
   lobbySupervisor_ = std::make_shared<LobbySupervisor>(*runtime_,
       "LobbyServices",
-      Strand::getMain(),
+      Strand::makeStrand("LobbySupervisor"),
       moduleUrl);
   lobbySupervisor_->Startup(federationId);
 
@@ -135,7 +137,7 @@ void PlayerBackend::tryUpdateCurrentBattle() {
       battleSimulator_->Startup(currentBattleId_);
 
       if (const auto lobbyId = getLauncherLobbyId()) {
-        battleSupervisor_ = std::make_shared<BattleSupervisor>(*runtime_, "BattleSupervisor", Strand::getMain());
+        battleSupervisor_ = std::make_shared<BattleSupervisor>(*runtime_, "BattleSupervisor", Strand::makeStrand("BattleSupervisor"));
         battleSupervisor_->Startup(lobbyId, currentBattleId_);
       }
     }
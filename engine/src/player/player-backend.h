@@ -16,6 +16,7 @@ class PlayerBackend :
     public std::enable_shared_from_this<PlayerBackend>
 {
   Runtime* runtime_{};
+  std::shared_ptr<Strand_base> strand_{};
   std::shared_ptr<Federate> systemFederate_{};
   ObjectRef launcher_{};
 
@@ -25,7 +26,7 @@ class PlayerBackend :
   ObjectId currentBattleId_{};
 
 public:
-  explicit PlayerBackend(Runtime& runtime);
+  PlayerBackend(Runtime& runtime, std::shared_ptr<Strand_base> strand);
   ~PlayerBackend() override;
 
   void startup();
@@ -23,10 +23,6 @@ PlayerEndpoint::PlayerEndpoint(std::shared_ptr<boost::asio::io_context> ioc) :
     socket_{*ioc}
 {
   LOG_LIFECYCLE("%p PlayerEndpoint + %d", this, ++debugCounter);
-
-  renderInterval_ = Strand::getMain()->setInterval([]() {
-    Strand::getRender()->run();
-  }, 100);
 }
 
 
@@ -36,8 +32,6 @@ PlayerEndpoint::~PlayerEndpoint() {
   std::lock_guard lock{mutex_};
   LOG_ASSERT(!acceptor_.is_open());
   LOG_ASSERT(sessions_.empty());
-
-  clearInterval(*renderInterval_);
 }
 
 
@@ -13,6 +13,7 @@
 #include <mutex>
 #include <thread>
 
+class Metrics;
 class PlayerSession;
 
 
@@ -32,7 +33,7 @@ class PlayerEndpoint :
   std::vector<std::shared_ptr<PlayerSession>> sessions_{};
   std::mutex mutex_{};
 
-  std::shared_ptr<IntervalObject> renderInterval_{};
+  std::shared_ptr<Metrics> metrics_{};
 
 public:
   explicit PlayerEndpoint(std::shared_ptr<boost::asio::io_context> ioc);
@@ -40,6 +41,9 @@ public:
 
   unsigned short startup(unsigned short port = 0);
 
+  [[nodiscard]] Metrics* getMetrics() const { return metrics_.get(); }
+  void setMetrics(std::shared_ptr<Metrics> value) { metrics_ = std::move(value); }
+
 protected: // Shutdownable
   [[nodiscard]] Promise<void> shutdown_() override;
 
@@ -20,12 +20,14 @@ std::shared_ptr<T> lockOrThrow(std::weak_ptr<T> p) {
 }
 
 
-PlayerFrontend::PlayerFrontend(Runtime& runtime, Surface& gestureSurface, Viewport& viewport) :
+PlayerFrontend::PlayerFrontend(Runtime& runtime, std::shared_ptr<Strand_base> strand, std::shared_ptr<Strand_base> renderStrand, Surface& gestureSurface, Viewport& viewport) :
     runtime_{&runtime},
+    strand_{std::move(strand)},
+    renderStrand_{std::move(renderStrand)},
     gestureSurface_{&gestureSurface},
     viewport_{&viewport}
 {
-  runtime_->addRuntimeObserver_safe(*this);
+  runtime_->addRuntimeObserver_safe(*this, strand_);
 }
 
 
@@ -45,7 +47,7 @@ void PlayerFrontend::startup() {
   lastAnimateSurface_ = std::chrono::system_clock::now();
   backgroundView_ = std::make_unique<BackgroundView>(*viewport_);
 
-  systemFederate_ = std::make_shared<Federate>(*runtime_, "PlayerFrontend", Strand::getMain());
+  systemFederate_ = std::make_shared<Federate>(*runtime_, "PlayerFrontend", strand_);
 
   systemFederate_->getObjectClass("Launcher").observe([weak_](ObjectRef launcher) {
     if (auto this_ = weak_.lock()) {
@@ -69,7 +71,7 @@ void PlayerFrontend::startup() {
 
 
 Promise<void> PlayerFrontend::shutdown_() {
-  LOG_ASSERT(Strand::getMain()->isCurrent());
+  LOG_ASSERT(strand_->isCurrent());
 
   MutexLock lock = co_await serviceMutex_.lock();
 
@@ -112,7 +114,7 @@ void PlayerFrontend::animateSurface(bounds2i bounds, float scaling) {
   }
 
   auto weak_ = weak_from_this();
-  Strand::getMain()->setImmediate([weak_, bounds, scaling]() {
+  strand_->setImmediate([weak_, bounds, scaling]() {
     if (auto this_ = weak_.lock()) {
       if (auto cameraState = this_->getUnitControllerCameraState())
         cameraState->SetViewportBounds(static_cast<bounds2f>(bounds), scaling);
@@ -152,7 +154,7 @@ void PlayerFrontend::OnTerrainChanged(TerrainFeature terrainFeature, bounds2f bo
 }
 
 
-void PlayerFrontend::onProcessAuthenticated_main(ObjectId processId, const ProcessAuth& processAuth) {
+void PlayerFrontend::onProcessAuthenticated_strand(ObjectId processId, const ProcessAuth& processAuth) {
   if (processId == runtime_->getProcessId()) {
     // if (auto analytics = runtime_->getAnalytics()) {
     //   if (analytics->getViewState() == Analytics::ViewState::None)
@@ -236,7 +238,7 @@ Promise<void> PlayerFrontend::joinLobbyFederation(ObjectId federationId) {
   }
 
   if (federationId) {
-    lobbyFederate_ = std::make_shared<Federate>(*runtime_, "PlayerFrontend", Strand::getMain());
+    lobbyFederate_ = std::make_shared<Federate>(*runtime_, "PlayerFrontend", strand_);
     lobbyFederate_->getObjectClass("Session").observe([weak_ = weak_from_this()](ObjectRef session) {
       if (auto this_ = weak_.lock()) {
         this_->serviceMutex_.lock<void>([this_, session]() {
@@ -257,7 +259,7 @@ Promise<void> PlayerFrontend::joinLobbyFederation(ObjectId federationId) {
 
 
 Promise<void> PlayerFrontend::tryUpdateCurrentBattle() {
-  LOG_ASSERT(Strand::getMain()->isCurrent());
+  LOG_ASSERT(strand_->isCurrent());
 
   const auto wantedBattleId = getLauncherBattleId();
   const auto currentBattleId = battleView_ ? battleView_->getFederationId() : ObjectId{};
@@ -274,10 +276,10 @@ Promise<void> PlayerFrontend::tryUpdateCurrentBattle() {
     soundDirector_->StopAll();
 
     if (wantedBattleId) {
-      battleView_ = std::make_shared<BattleView>(*runtime_, *viewport_, soundDirector_);
+      battleView_ = std::make_shared<BattleView>(*runtime_, *viewport_, renderStrand_, soundDirector_);
         battleView_->startup(wantedBattleId, runtime_->getSubjectId_safe());
 
-      unitController_ = std::make_shared<UnitController>(runtime_, gestureSurface_, *viewport_, this, soundDirector_.get());
+      unitController_ = std::make_shared<UnitController>(runtime_, strand_, gestureSurface_, *viewport_, this, soundDirector_.get());
       unitController_->Startup(wantedBattleId, runtime_->getSubjectId_safe());
 
       soundDirector_->PlayBackground();
@@ -25,6 +25,8 @@ class PlayerFrontend :
     public std::enable_shared_from_this<PlayerFrontend>
 {
   Runtime* runtime_{};
+  std::shared_ptr<Strand_base> strand_{};
+  std::shared_ptr<Strand_base> renderStrand_{};
   Surface* gestureSurface_{};
   Viewport* viewport_{};
 
@@ -42,7 +44,7 @@ public: std::shared_ptr<Federate> systemFederate_; private: // android
   Mutex serviceMutex_;
 
 public:
-  PlayerFrontend(Runtime& runtime, Surface& gestureSurface, Viewport& viewport);
+  PlayerFrontend(Runtime& runtime, std::shared_ptr<Strand_base> strand, std::shared_ptr<Strand_base> renderStrand, Surface& gestureSurface, Viewport& viewport);
   ~PlayerFrontend() override;
 
   void startup();
@@ -64,7 +66,7 @@ public:
   void renderSurface(Framebuffer* frameBuffer); // render thread
 
 protected:
-  void onProcessAuthenticated_main(ObjectId processId, const ProcessAuth& processAuth) override;
+  void onProcessAuthenticated_strand(ObjectId processId, const ProcessAuth& processAuth) override;
 
 private:
   Promise<void> handleLauncherChanged(ObjectRef launcher);
@@ -19,6 +19,7 @@ PlayerSession::PlayerSession(PlayerEndpoint& endpoint, std::shared_ptr<boost::as
         ioc_{std::move(ioc)},
         stream_{std::move(socket)},
         strand_{std::make_shared<Strand_Asio>(stream_.get_executor(), "WebSocketSurfaceSession")},
+        windowStrand_{Strand::makeStrand("PlayerWindow")},
         pingTimer_{*ioc_, std::chrono::steady_clock::time_point::max()}
 {
     LOG_LIFECYCLE("%p PlayerSession + %d", this, ++debugCounter);
@@ -61,8 +62,8 @@ Promise<void> PlayerSession::shutdown_() {
         co_await deferred;
     }
 
-    co_await *Strand::getMain();
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    co_await *windowStrand_;
+    LOG_ASSERT(windowStrand_->isCurrent());
     if (surfaceAdapter_) {
         co_await surfaceAdapter_->shutdown();
         surfaceAdapter_ = nullptr;
@@ -287,9 +288,10 @@ void PlayerSession::logError(PlayerSession::error_code_t ec, const char* op) {
 
 Promise<void> PlayerSession::createSurfaceAdapter() {
     Promise<void> deferred{};
-    Strand::getMain()->setImmediate([this_ = shared_from_this(), deferred]() {
-        this_->surfaceAdapter_ = std::make_unique<PlayerWindow>();
-        this_->surfaceAdapter_->startup(this_->ioc_, *this_);
+    windowStrand_->setImmediate([this_ = shared_from_this(), deferred]() {
+        auto endpoint = this_->endpoint_.lock();
+        this_->surfaceAdapter_ = std::make_unique<PlayerWindow>(this_->windowStrand_);
+        this_->surfaceAdapter_->startup(this_->ioc_, *this_, endpoint ? endpoint->getMetrics() : nullptr);
         deferred.resolve().done();
     });
     return deferred;
@@ -299,14 +301,14 @@ Promise<void> PlayerSession::createSurfaceAdapter() {
 void PlayerSession::enqueueMessage(const Value& message) {
     std::lock_guard lock{messageMutex_};
     messageQueue_.push_back(message);
-    Strand::getMain()->setImmediate([this_ = shared_from_this()]() {
+    windowStrand_->setImmediate([this_ = shared_from_this()]() {
         this_->processMessageQueue();
     });
 }
 
 
 void PlayerSession::processMessageQueue() {
-    LOG_ASSERT(Strand::getMain()->isCurrent());
+    LOG_ASSERT(windowStrand_->isCurrent());
     if (!surfaceAdapter_) {
         return;
     }
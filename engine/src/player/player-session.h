@@ -43,7 +43,8 @@ class PlayerSession :
   boost::asio::steady_timer pingTimer_;
   char pingState_{};
 
-  // main thread
+  // window strand
+  std::shared_ptr<Strand_base> windowStrand_;
   std::unique_ptr<PlayerWindow> surfaceAdapter_{};
 
   // any thread
@@ -7,6 +7,7 @@
 #include "./player-frontend.h"
 
 #include "async/strand.h"
+#include "battle-simulator/battle-simulator.h"
 #include "gesture/surface.h"
 #include "gesture/gesture.h"
 #include "graphics/framebuffer.h"
@@ -26,7 +27,10 @@
 static std::atomic_int debugCounter = 0;
 
 
-PlayerWindow::PlayerWindow() {
+PlayerWindow::PlayerWindow(std::shared_ptr<Strand_base> strand) :
+    strand_{std::move(strand)},
+    renderStrand_{std::make_shared<Strand_Manual>()}
+{
     LOG_LIFECYCLE("%p WorkshopSurfaceAdapter + %d", this, ++debugCounter);
 }
 
@@ -37,8 +41,17 @@ PlayerWindow::~PlayerWindow() {
 }
 
 
-void PlayerWindow::startup(std::shared_ptr<boost::asio::io_context> ioc, PlayerSession& surfaceSession) {
+void PlayerWindow::startup(std::shared_ptr<boost::asio::io_context> ioc, PlayerSession& surfaceSession, Metrics* metrics) {
+    LOG_ASSERT(strand_->isCurrent());
+
+    renderInterval_ = strand_->setInterval([renderStrand = renderStrand_]() {
+        renderStrand->run();
+    }, 100);
+
     runtime_ = std::make_shared<Runtime>(ProcessType::Player);
+    runtime_->setMetrics(metrics);
+    runtime_->setObjectSchema(&BattleSimulator::getObjectSchema());
+    runtime_->setInterestPolicy(&BattleSimulator::getInterestPolicy());
     runtime_->registerProcessAuth_safe(runtime_->getProcessId(), {"_"});
 
     runtime_->registerProcess_safe(ObjectId{}, ProcessType::Headup, nullptr);
@@ -50,7 +63,7 @@ void PlayerWindow::startup(std::shared_ptr<boost::asio::io_context> ioc, PlayerS
     });
     int port = endpoint_->startup_safe(0);
 
-    playerBackend_ = std::make_shared<PlayerBackend>(*runtime_);
+    playerBackend_ = std::make_shared<PlayerBackend>(*runtime_, strand_);
     playerBackend_->startup();
 
     surfaceSession_ = &surfaceSession;
@@ -64,7 +77,7 @@ void PlayerWindow::startup(std::shared_ptr<boost::asio::io_context> ioc, PlayerS
 
     viewport_ = std::make_shared<Viewport>(graphics_.get(), 1);
     gestureSurface_ = std::make_shared<Surface>(*viewport_);
-    playerFrontend_ = std::make_shared<PlayerFrontend>(*runtime_, *gestureSurface_, *viewport_);
+    playerFrontend_ = std::make_shared<PlayerFrontend>(*runtime_, strand_, renderStrand_, *gestureSurface_, *viewport_);
     playerFrontend_->startup();
 
     buffer_.push_back(build_array() << "Startup" << port << ValueEnd{});
@@ -87,6 +100,10 @@ Promise<void> PlayerWindow::shutdown_() {
     co_await playerBackend_->shutdown();
     co_await endpoint_->shutdown();
     co_await runtime_->shutdown();
+    runtime_->setMetrics(nullptr);
+
+    co_await *strand_;
+    clearInterval(*renderInterval_);
 }
 
 
@@ -96,8 +113,8 @@ void PlayerWindow::setServerUrl(const char* url) {
 
 
 void PlayerWindow::renderFrame(int width, int height) {
-    Strand::getRender()->run();
-    Strand::getRender()->setImmediate([this, width, height]() {
+    renderStrand_->run();
+    renderStrand_->setImmediate([this, width, height]() {
         rendering_ = true;
         graphics_->getGraphicsApi().beginFrame(0);
         viewport_->setViewportBounds(bounds2i{0, 0, width, height});
@@ -108,8 +125,8 @@ void PlayerWindow::renderFrame(int width, int height) {
         if (shouldFlushBuffer())
             flushBuffer();
     });
-    Strand::getRender()->run();
-    Strand::getMain()->setImmediate([gestures_weak = std::weak_ptr<Surface>(gestureSurface_)]() {
+    renderStrand_->run();
+    strand_->setImmediate([gestures_weak = std::weak_ptr<Surface>(gestureSurface_)]() {
         if (auto gestures = gestures_weak.lock())
             for (auto gestureRecognizer : gestures->GetGestures())
                 gestureRecognizer->Animate();
@@ -15,6 +15,7 @@ class PlayerFrontend;
 class Surface;
 class Federate;
 class Framebuffer;
+class Metrics;
 class PlayerBackend;
 class Renderbuffer;
 class PlayerSession;
@@ -25,6 +26,12 @@ class PlayerWindow :
     public Shutdownable,
     public std::enable_shared_from_this<PlayerWindow>
 {
+  // the window, its frontend and backend run on a strand of their own,
+  // and the battle view on a render strand that is run on that strand
+  std::shared_ptr<Strand_base> strand_{};
+  std::shared_ptr<Strand_Manual> renderStrand_{};
+  std::shared_ptr<IntervalObject> renderInterval_{};
+
   std::unique_ptr<GraphicsApi> graphicsApi_{};
   std::unique_ptr<Graphics> graphics_{};
   std::shared_ptr<Runtime> runtime_{};
@@ -43,10 +50,10 @@ class PlayerWindow :
   std::vector<Value> buffer_{};
 
 public:
-  PlayerWindow();
+  explicit PlayerWindow(std::shared_ptr<Strand_base> strand);
   ~PlayerWindow() override;
 
-  void startup(std::shared_ptr<boost::asio::io_context> ioc, PlayerSession& surfaceSession);
+  void startup(std::shared_ptr<boost::asio::io_context> ioc, PlayerSession& surfaceSession, Metrics* metrics = nullptr);
 
 protected: // Shutdownable
   [[nodiscard]] Promise<void> shutdown_() override;
@@ -63,7 +63,7 @@ void Endpoint::requestHostMatch_safe(ObjectId lobbyId, ObjectId matchId) {
   lock.unlock();
 
   if (session) {
-    session->strand_->setImmediate([session, lobbyId, matchId]() {
+    session->strand_->post([session, lobbyId, matchId]() {
       session->sendHostRequest_strand(lobbyId, matchId);
     });
   }
@@ -105,7 +105,7 @@ void Endpoint::broadcastFederationProcessAdded_safe(ObjectId federationId, Objec
     if (session->getProcessType() != ProcessType::None) {
       if (!origin || shouldRelayFederationProcessAdded(*origin, *session)) {
         if (processId != session->getProcessId()) {
-          session->getStrand().setImmediate([session = session->shared_from_this(), packet]() {
+          session->getStrand().post([session = session->shared_from_this(), packet]() {
             session->sendPacket_strand(packet);
           });
         }
@@ -125,7 +125,7 @@ void Endpoint::broadcastFederationProcessRemoved_safe(ObjectId federationId, Obj
   std::lock_guard lock{mutex_};
   for (auto session : sessions_) {
     if (session->getProcessType() != ProcessType::None) {
-      session->getStrand().setImmediate([session = session->shared_from_this(), packet]() {
+      session->getStrand().post([session = session->shared_from_this(), packet]() {
         session->sendPacket_strand(packet);
       });
     }
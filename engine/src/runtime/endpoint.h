@@ -8,6 +8,7 @@
 #include "async/shutdownable.h"
 #include "async/strand.h"
 #include "value/object-id.h"
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -33,8 +34,13 @@ private:
   std::shared_ptr<TimeoutObject> masterConnectObject_{};
   int masterConnectDelay_{};
   std::function<void(const Session& session)> sessionClosedHandler_{};
+  std::size_t outgoingByteBudget_{DefaultOutgoingByteBudget};
+  std::chrono::milliseconds serviceRequestTimeout_{DefaultServiceRequestTimeout};
 
 public:
+  static constexpr std::size_t DefaultOutgoingByteBudget = 256 * 1024;
+  static constexpr std::chrono::milliseconds DefaultServiceRequestTimeout{30 * 1000};
+
   explicit Endpoint(Runtime& runtime);
   ~Endpoint() override;
 
@@ -48,6 +54,14 @@ public:
     sessionClosedHandler_ = std::move(value);
   }
 
+  // bytes queued for sending before sessions created by
+  // this endpoint start coalescing object updates
+  void setOutgoingByteBudget(std::size_t value) { outgoingByteBudget_ = value; }
+
+  // time before service requests sent by sessions created by this
+  // endpoint are rejected if no fulfill or reject has been received
+  void setServiceRequestTimeout(std::chrono::milliseconds value) { serviceRequestTimeout_ = value; }
+
 protected:
   virtual std::shared_ptr<Session> makeSession_safe(const std::string& url) = 0;
 
@@ -3,6 +3,7 @@
 
 #include "./federate.h"
 #include "./federation.h"
+#include "./metrics.h"
 #include "./object.h"
 #include "./ownership.h"
 #include "./runtime.h"
@@ -55,16 +56,18 @@ void Federate::startup(ObjectId federationId) {
 
   federationId_ = federationId;
   setFederation_safe(federation);
-
-  std::lock_guard federate_lock{mutex_};
-  tryScheduleImmediateSynchronize_unsafe();
+  tryScheduleImmediateSynchronize_safe();
 }
 
 
 Promise<void> Federate::shutdown_() {
   LOG_LIFECYCLE("%p Federate Shutdown %s", this, federateName_.c_str());
 
-  std::lock_guard startupShutdownLock{startupShutdownMutex_};
+  {
+    // waits for a startup in progress, later startups see shutdownStarted(),
+    // the lock is not held across co_await as it may resume on another thread
+    std::lock_guard startupShutdownLock{startupShutdownMutex_};
+  }
 
   co_await *strand_;
   LOG_ASSERT(isFederateStrandCurrent());
@@ -296,6 +299,8 @@ void Federate::synchronize_strand() {
     federation = federation_;
   }
   if (federation) {
+    auto metrics = runtime_->getMetrics();
+    auto start = metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
     enterBlock_strand();
     updateCurrentTime_strand();
     {
@@ -319,23 +324,42 @@ void Federate::synchronize_strand() {
       removeDeletedByMaster();
     }
     leaveBlock_strand();
+    if (metrics) {
+      if (!syncDuration_) {
+        syncDuration_ = &metrics->histogram("warstage_federate_sync_seconds", makeString("federate=\"%s\"", federateName_.c_str()));
+      }
+      syncDuration_->observe(std::chrono::steady_clock::now() - start);
+    }
   }
 }
 
 
 void Federate::enterBlock_strand() {
   LOG_ASSERT(isFederateStrandCurrent());
-  std::lock_guard federate_lock{mutex_};
+  ++batchCounter_;
+  std::lock_guard synchronize_lock{synchronizeMutex_};
   ++blockCounter_;
 }
 
 
 void Federate::leaveBlock_strand() {
   LOG_ASSERT(isFederateStrandCurrent());
-  std::lock_guard federate_lock{mutex_};
-  if (--blockCounter_ == 0 && deferredSynchronize_) {
-    deferredSynchronize_ = false;
-    tryScheduleImmediateSynchronize_unsafe();
+  LOG_ASSERT(batchCounter_ > 0);
+  --batchCounter_;
+  bool schedule = false;
+  {
+    std::lock_guard synchronize_lock{synchronizeMutex_};
+    if (batchCounter_ == 0 && batchChanged_) {
+      batchChanged_ = false;
+      deferredSynchronize_ = true;
+    }
+    if (--blockCounter_ == 0 && deferredSynchronize_) {
+      deferredSynchronize_ = false;
+      schedule = true;
+    }
+  }
+  if (schedule) {
+    tryScheduleImmediateSynchronize_safe();
   }
 }
 
@@ -378,12 +402,12 @@ Federation* Federate::clearFederation_safe() {
 
 
 void Federate::postAsyncTask(std::function<void()> task) {
-  strand_->setImmediate(std::move(task));
+  strand_->post(std::move(task));
 }
 
 
 void Federate::clearImmediateSyncrhonize_safe() {
-  std::lock_guard federate_lock{mutex_};
+  std::lock_guard synchronize_lock{synchronizeMutex_};
   if (immediateSynchronize_) {
     clearImmediate(*immediateSynchronize_);
     immediateSynchronize_ = nullptr;
@@ -391,7 +415,12 @@ void Federate::clearImmediateSyncrhonize_safe() {
 }
 
 
-void Federate::tryScheduleImmediateSynchronize_unsafe() {
+/* May be called from any thread, including other federates' strands
+ * and while holding the federation or federate mutex, so the scheduling
+ * state has a lock of its own that is never held while taking another.
+ */
+void Federate::tryScheduleImmediateSynchronize_safe() {
+  std::lock_guard synchronize_lock{synchronizeMutex_};
   if (blockCounter_) {
     deferredSynchronize_ = true;
   } else if (!immediateSynchronize_) {
@@ -400,7 +429,7 @@ void Federate::tryScheduleImmediateSynchronize_unsafe() {
       try {
         if (auto this_ = weak_.lock()) {
           {
-            std::lock_guard federate_lock{this_->mutex_};
+            std::lock_guard synchronize_lock{this_->synchronizeMutex_};
             this_->immediateSynchronize_ = nullptr;
           }
           this_->synchronize_strand();
@@ -413,6 +442,19 @@ void Federate::tryScheduleImmediateSynchronize_unsafe() {
 }
 
 
+/* Called on the federate strand whenever an object has been marked for
+ * synchronization. Inside a block only the strand-local batch flag is set,
+ * the synchronize is scheduled once when the outermost block is left.
+ */
+void Federate::scheduleSynchronize_strand() {
+  if (batchCounter_) {
+    batchChanged_ = true;
+  } else {
+    tryScheduleImmediateSynchronize_safe();
+  }
+}
+
+
 bool Federate::synchronizeChangesFromFederateToFederation_strand(Federation* federation) {
   assert(federation);
   // assert(!federation->_mutex.try_lock()); // ??
@@ -477,45 +519,40 @@ bool Federate::synchronizeChangesFromFederateToFederation_strand(Federation* fed
 
           if (objectProperty->version3_ > masterProperty->version_) {
             auto& instanceOwnership = objectProperty->instanceOwnership_;
-            if (instanceOwnership.first & OwnershipStateFlag::Owned) {
+            if (!(instanceOwnership.first & OwnershipStateFlag::Owned)) {
+              LOG_W("no ownership %s", objectProperty->propertyName_.c_str());
+              objectProperty->assign(*masterProperty);
+            } else if (masterProperty->owner_ && (masterProperty->owner_ == objectProperty.get() || instanceOwnership.second == OwnershipOperation::ForcedOwnershipAcquisition)) {
+              // the owner's change, the ownership map is left as is
+              masterProperty->assign(*objectProperty);
+              changed = true;
+            } else {
               auto& ownershipMap = objectProperty->masterProperty_->ownershipMap_;
               assertValidateOwnership(ownershipMap, __FILE__, __LINE__);
+              if (objectProperty->masterOwnership_.first == OwnershipState{}) {
+                ownershipMap.push_back(objectProperty.get());
+              }
               if (!masterProperty->owner_) {
-                if (objectProperty->masterOwnership_.first == OwnershipState{}) {
-                  ownershipMap.push_back(objectProperty.get());
-                }
                 objectProperty->masterOwnership_ = std::make_pair(instanceOwnership.first, OwnershipNotification::None);
                 assertValidateOwnership(ownershipMap, __FILE__, __LINE__);
                 objectProperty->masterProperty_->owner_ = findOwnerFederate(ownershipMap);
                 masterProperty->assign(*objectProperty);
                 changed = true;
-              } else if (masterProperty->owner_ == objectProperty.get() || instanceOwnership.second == OwnershipOperation::ForcedOwnershipAcquisition) {
-                masterProperty->assign(*objectProperty);
-                changed = true;
               } else {
-                if (objectProperty->masterOwnership_.first == OwnershipState{}) {
-                  ownershipMap.push_back(objectProperty.get());
-                }
                 objectProperty->masterOwnership_ = std::make_pair(instanceOwnership.first, OwnershipNotification::ForcedOwnershipDivestitureNotification);
                 assertValidateOwnership(ownershipMap, __FILE__, __LINE__);
                 objectProperty->masterProperty_->owner_ = findOwnerFederate(ownershipMap);
                 objectProperty->assign(*masterProperty);
               }
-            } else {
-              LOG_W("no ownership %s", objectProperty->propertyName_.c_str());
-              objectProperty->assign(*masterProperty);
+              objectInstance->ownershipPending_ = true;
             }
           }
         }
       }
       objectInstance->synchronize_ = false;
 
-      for (auto& objectProperty : objectInstance->properties_.Values()) {
-        if (objectProperty && shouldUpdateOwnership(*objectProperty)) {
-          if (updateOwnership(objectInstance, *objectProperty)) {
-            changed = true;
-          }
-        }
+      if (updateInstanceOwnership(objectInstance)) {
+        changed = true;
       }
     }
   }
@@ -571,7 +608,7 @@ bool Federate::synchronizeChangesFromFederationToFederate_strand(Federation* fed
               LOG_ASSERT(!objectProperty->masterProperty_);
               auto masterProperty = &objectInstance->masterInstance_->getProperty(*objectProperty);
               objectProperty->masterProperty_ = masterProperty;
-              objectProperty->version3_ = masterProperty->buffer_ ? masterProperty->version_ - 1 : masterProperty->version_;
+              objectProperty->version3_ = masterProperty->hasValue() ? masterProperty->version_ - 1 : masterProperty->version_;
               bool owned = objectProperty->canSetValue();
               auto ownershipState = objectProperty->getOwnershipState() & OwnershipStateFlag::AbleToAcquire
                   ? OwnershipState{}
@@ -589,6 +626,7 @@ bool Federate::synchronizeChangesFromFederationToFederate_strand(Federation* fed
               objectProperty->ownershipVersion_ = 0;
             }
           }
+          objectInstance->ownershipPending_ = true;
         } else {
           auto objectClass = getObjectClass_unsafe(masterInstance->objectClassName_.c_str());
           objectInstance = std::make_shared<ObjectInstance>(objectClass);
@@ -645,12 +683,8 @@ bool Federate::synchronizeChangesFromFederationToFederate_strand(Federation* fed
           masterProperty->syncFlag_ = false;
         }
 
-        for (auto& objectProperty : objectInstance->properties_.Values()) {
-          if (objectProperty && shouldUpdateOwnership(*objectProperty)) {
-            if (updateOwnership(objectInstance, *objectProperty)) {
-              changed = true;
-            }
-          }
+        if (updateInstanceOwnership(objectInstance)) {
+          changed = true;
         }
       }
     }
@@ -659,6 +693,35 @@ bool Federate::synchronizeChangesFromFederationToFederate_strand(Federation* fed
 }
 
 
+/*
+ * The properties of an instance are visited only when an ownership
+ * operation or notification is pending, or when the ownership of any
+ * property of the master instance has changed, so the many objects with
+ * a stable owner are skipped on each synchronize.
+ */
+bool Federate::updateInstanceOwnership(const std::shared_ptr<ObjectInstance>& objectInstance) {
+  auto masterInstance = objectInstance->masterInstance_;
+  if (!objectInstance->ownershipPending_ && objectInstance->ownershipVersion_ == masterInstance->ownershipVersion_) {
+    return false;
+  }
+
+  bool changed = false;
+  objectInstance->ownershipPending_ = false;
+  for (auto& objectProperty : objectInstance->properties_.Values()) {
+    if (objectProperty) {
+      if (shouldUpdateOwnership(*objectProperty) && updateOwnership(objectInstance, *objectProperty)) {
+        changed = true;
+      }
+      if (isOwnershipPending(*objectProperty)) {
+        objectInstance->ownershipPending_ = true;
+      }
+    }
+  }
+  objectInstance->ownershipVersion_ = masterInstance->ownershipVersion_;
+  return changed;
+}
+
+
 bool Federate::shouldUpdateOwnership(const Property& property) {
   if (auto masterProperty = property.masterProperty_) {
     return property.instanceOwnership_.second != OwnershipOperation::None
@@ -669,6 +732,14 @@ bool Federate::shouldUpdateOwnership(const Property& property) {
 }
 
 
+bool Federate::isOwnershipPending(const Property& property) {
+  return !property.masterProperty_
+      || property.masterOwnership_.first == OwnershipState{}
+      || property.masterOwnership_.second != OwnershipNotification::None
+      || property.instanceOwnership_.second != OwnershipOperation::None;
+}
+
+
 bool Federate::updateOwnership(const std::shared_ptr<ObjectInstance>& objectInstance, Property& objectProperty) {
   bool masterOwnershipChanged = false;
   auto masterProperty = objectProperty.masterProperty_;
@@ -721,6 +792,7 @@ bool Federate::updateOwnership(const std::shared_ptr<ObjectInstance>& objectInst
       }
       afterUpdateOwnership(ownershipMap, objectProperty, instanceOwnership.second, __FILE__, __LINE__);
       ++masterProperty->ownershipVersion_;
+      ++objectInstance->masterInstance_->ownershipVersion_;
       assertValidateOwnership(ownershipMap, __FILE__, __LINE__);
       masterProperty->owner_ = findOwnerFederate(ownershipMap);
       instanceOwnership.second = OwnershipOperation::None;
@@ -790,6 +862,7 @@ void Federate::unpublishAndRemoveObjectInstanceFromOwnershipMap(ObjectInstance&
         }
         afterUpdateOwnership(ownershipMap, *objectProperty, OwnershipOperation::Unpublish, __FILE__, __LINE__);
         ++masterProperty->ownershipVersion_;
+        ++objectInstance.masterInstance_->ownershipVersion_;
         ownershipMap.erase(
             std::remove(ownershipMap.begin(), ownershipMap.end(), objectProperty.get()),
             ownershipMap.end());
@@ -17,6 +17,7 @@
 #include <mutex>
 
 class Federation;
+class MetricsHistogram;
 class Runtime;
 
 
@@ -51,6 +52,9 @@ class Federate :
   double eventDelay_{};
   double eventLatency_{};
   double currentTime_{};
+  int batchCounter_{};
+  bool batchChanged_{};
+  MetricsHistogram* syncDuration_{};
 
   // multiple threads
   ObjectId federationId_{};
@@ -65,6 +69,7 @@ class Federate :
   std::function<void(const char*, const Value&)> eventCallback_{};
   std::function<Promise<Value>(const char*, const Value&, const std::string&)> serviceCallback_{};
   std::function<void(ObjectRef object, Property& property, OwnershipNotification notification)> ownershipCallback_{Federate::defaultOwnershipCallback};
+  std::mutex synchronizeMutex_{}; // innermost lock, guards the three below
   std::shared_ptr<ImmediateObject> immediateSynchronize_{};
   int blockCounter_{};
   bool deferredSynchronize_{};
@@ -90,6 +95,7 @@ public:
   [[nodiscard]] std::string getDescription() const;
 
   [[nodiscard]] Runtime& getRuntime() const { return *runtime_; }
+  [[nodiscard]] const std::shared_ptr<Strand_base>& getStrand() const { return strand_; }
 
   [[nodiscard]] ObjectRef getObject(ObjectId objectId) const; // AssertFederateStrand
   [[nodiscard]] ObjectClass& getObjectClass(const char* name);
@@ -113,6 +119,18 @@ public:
   virtual void enterBlock_strand();
   virtual void leaveBlock_strand();
 
+  // Groups all changes made on the federate strand during the lifetime
+  // of the scope into a single synchronize. Changes made inside the
+  // scope only mark objects as dirty, without taking the federate lock.
+  class BatchScope {
+    Federate& federate_;
+  public:
+    explicit BatchScope(Federate& federate) : federate_{federate} { federate_.enterBlock_strand(); }
+    ~BatchScope() { federate_.leaveBlock_strand(); }
+    BatchScope(const BatchScope&) = delete;
+    BatchScope& operator=(const BatchScope&) = delete;
+  };
+
   void updateCurrentTime_strand();
 
   [[nodiscard]] double getEventDelay() const { LOG_ASSERT(isFederateStrandCurrent()); return eventDelay_; }
@@ -129,12 +147,15 @@ private:
   void postAsyncTask(std::function<void()> task);
 
   void clearImmediateSyncrhonize_safe();
-  void tryScheduleImmediateSynchronize_unsafe();
+  void tryScheduleImmediateSynchronize_safe();
+  void scheduleSynchronize_strand();
 
   [[nodiscard]] bool synchronizeChangesFromFederateToFederation_strand(Federation* federation);
   [[nodiscard]] bool synchronizeChangesFromFederationToFederate_strand(Federation* federation);
 
+  bool updateInstanceOwnership(const std::shared_ptr<ObjectInstance>& objectInstance);
   [[nodiscard]] static bool shouldUpdateOwnership(const Property& property);
+  [[nodiscard]] static bool isOwnershipPending(const Property& property);
   bool updateOwnership(const std::shared_ptr<ObjectInstance>& objectInstance, Property& objectProperty);
 
   void unpublishAndRemoveObjectInstanceFromOwnershipMap(ObjectInstance& objectInstance);
@@ -165,8 +165,7 @@ void Federation::tryScheduleImmediateSynchronizeOthers_unsafe(Federate* exceptio
 
   for (auto federate : federates_) {
     if (federate != exception) {
-      std::lock_guard federate_lock{federate->mutex_};
-      federate->tryScheduleImmediateSynchronize_unsafe();
+      federate->tryScheduleImmediateSynchronize_safe();
     }
   }
 }
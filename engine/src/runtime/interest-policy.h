@@ -0,0 +1,46 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__RUNTIME__INTEREST_POLICY_H
+#define WARSTAGE__RUNTIME__INTEREST_POLICY_H
+
+#include "./object.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+
+// Area of interest of a remote player, used to rate limit updates of
+// objects that are of little relevance to the player.
+struct SessionInterest {
+  glm::vec2 cameraPosition{};
+  bool hasCameraPosition{};
+  std::vector<ObjectId> objectIds{}; // objects of the player, set by the policy
+};
+
+
+// Decides which objects are of interest to a remote player, so that
+// the runtime can rate limit the rest without knowing the application's
+// object classes. Set on the runtime by the application, with
+// Runtime::setInterestPolicy(), before any sessions are created.
+
+class InterestPolicy {
+public:
+  virtual ~InterestPolicy() = default;
+
+  // player side, the camera position to forward to the daemon, if the object is the camera
+  [[nodiscard]] virtual std::optional<glm::vec2> getCameraPosition(ObjectRef object) const = 0;
+
+  // daemon side, updates the interest of the player with the given subject id
+  virtual void updateInterest(SessionInterest& interest, ObjectRef object, const std::string& subjectId) const = 0;
+
+  // objects that are not filtered are always sent immediately
+  [[nodiscard]] virtual bool shouldFilterObject(ObjectRef object) const = 0;
+  [[nodiscard]] virtual bool isWithinInterest(const SessionInterest& interest, ObjectRef object) const = 0;
+
+  // low priority properties are not sent for objects outside the area of interest
+  [[nodiscard]] virtual bool isLowPriority(const Property& property) const = 0;
+};
+
+
+#endif
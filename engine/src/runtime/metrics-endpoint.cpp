@@ -0,0 +1,174 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./metrics-endpoint.h"
+#include "./metrics.h"
+#include "utilities/logging.h"
+#include <boost/asio.hpp>
+
+namespace http = boost::beast::http;
+
+
+namespace {
+  struct MetricsRequest {
+    boost::asio::ip::tcp::socket socket;
+    boost::asio::strand<boost::asio::ip::tcp::socket::executor_type> strand;
+    boost::asio::steady_timer timer;
+    boost::beast::flat_buffer buffer{};
+    http::request<http::string_body> request{};
+    http::response<http::string_body> response{};
+
+    explicit MetricsRequest(boost::asio::ip::tcp::socket s) :
+        socket{std::move(s)},
+        strand{boost::asio::make_strand(socket.get_executor())},
+        timer{strand} {}
+  };
+}
+
+
+MetricsEndpoint::MetricsEndpoint(std::shared_ptr<Metrics> metrics, std::shared_ptr<boost::asio::io_context> ioc) :
+    metrics_{std::move(metrics)},
+    ioc_{std::move(ioc)},
+    acceptor_{*ioc_},
+    socket_{*ioc_}
+{
+  LOG_LIFECYCLE("%p MetricsEndpoint +", this);
+}
+
+
+MetricsEndpoint::~MetricsEndpoint() {
+  LOG_LIFECYCLE("%p MetricsEndpoint ~", this);
+  std::lock_guard lock{mutex_};
+  LOG_ASSERT(!acceptor_.is_open());
+}
+
+
+unsigned short MetricsEndpoint::startup_safe(unsigned short port) {
+  {
+    std::lock_guard lock{mutex_};
+    boost::system::error_code ec;
+
+    auto const address = boost::asio::ip::make_address("127.0.0.1");
+    auto const ep = boost::asio::ip::tcp::endpoint{address, port};
+
+    acceptor_.open(ep.protocol(), ec);
+    if (ec) {
+      logError(ec, "open");
+      return 0;
+    }
+
+    acceptor_.set_option(boost::asio::socket_base::reuse_address{true}, ec);
+    if (ec) {
+      logError(ec, "set_option(reuse_address)");
+    }
+
+    acceptor_.bind(ep, ec);
+    if (ec) {
+      logError(ec, "bind");
+      return 0;
+    }
+
+    acceptor_.listen(boost::asio::socket_base::max_listen_connections, ec);
+    if (ec) {
+      logError(ec, "listen");
+      return 0;
+    }
+
+    port = acceptor_.local_endpoint().port();
+  }
+
+  doAccept_safe();
+  return port;
+}
+
+
+Promise<void> MetricsEndpoint::shutdown_() {
+  LOG_LIFECYCLE("%p MetricsEndpoint Shutdown", this);
+
+  std::lock_guard lock{mutex_};
+  boost::system::error_code ec;
+  acceptor_.close(ec);
+  if (ec) {
+    logError(ec, "acceptor.close");
+  }
+  co_return;
+}
+
+
+/***/
+
+
+void MetricsEndpoint::doAccept_safe() {
+  std::lock_guard lock{mutex_};
+  acceptor_.async_accept(socket_, [this_ = shared_from_this()](auto ec) {
+    this_->onAccept_safe(ec);
+  });
+}
+
+
+void MetricsEndpoint::onAccept_safe(boost::system::error_code ec) {
+  std::unique_lock lock{mutex_};
+  if (shutdownStarted() || !acceptor_.is_open()) {
+    socket_.close(ec);
+    return;
+  }
+  if (ec) {
+    if (ec != boost::asio::error::operation_aborted) {
+      logError(ec, "async_accept");
+    }
+    socket_.close(ec);
+  } else {
+    doRequest(std::move(socket_));
+  }
+  lock.unlock();
+
+  doAccept_safe();
+}
+
+
+/*
+ * A client that connects and sends no request is closed when the read
+ * timeout expires, the timer and the socket handlers run on the strand
+ * of the request.
+ */
+void MetricsEndpoint::doRequest(socket s) {
+  auto state = std::make_shared<MetricsRequest>(std::move(s));
+  state->timer.expires_after(ReadTimeout);
+  state->timer.async_wait([state](boost::system::error_code ec) {
+    if (ec != boost::asio::error::operation_aborted) {
+      state->socket.close(ec);
+    }
+  });
+  http::async_read(state->socket, state->buffer, state->request, boost::asio::bind_executor(state->strand, [this_ = shared_from_this(), state](boost::system::error_code ec, std::size_t) {
+    state->timer.cancel();
+    if (ec) {
+      return logError(ec, "async_read");
+    }
+
+    auto& response = state->response;
+    response.version(state->request.version());
+    response.keep_alive(false);
+    if (state->request.method() != http::verb::get || state->request.target() != "/metrics") {
+      response.result(http::status::not_found);
+      response.set(http::field::content_type, "text/plain");
+      response.body() = "not found\n";
+    } else {
+      response.result(http::status::ok);
+      response.set(http::field::content_type, "text/plain; version=0.0.4");
+      response.body() = this_->metrics_->render();
+    }
+    response.prepare_payload();
+
+    http::async_write(state->socket, response, boost::asio::bind_executor(state->strand, [state](boost::system::error_code ec, std::size_t) {
+      if (ec) {
+        logError(ec, "async_write");
+      }
+      state->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_send, ec);
+    }));
+  }));
+}
+
+
+void MetricsEndpoint::logError(boost::system::error_code ec, const char* op) {
+  LOG_W("MetricsEndpoint, error: %s: %s", ec.message().c_str(), op);
+}
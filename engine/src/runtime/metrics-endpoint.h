@@ -0,0 +1,52 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__RUNTIME__METRICS_ENDPOINT_H
+#define WARSTAGE__RUNTIME__METRICS_ENDPOINT_H
+
+#include "async/shutdownable.h"
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <memory>
+#include <mutex>
+
+class Metrics;
+
+
+// Serves the metrics as plain text on GET /metrics, for scraping
+// by a local monitoring agent. Listens on the loopback interface only.
+class MetricsEndpoint :
+    public Shutdownable,
+    public std::enable_shared_from_this<MetricsEndpoint>
+{
+  using acceptor = boost::asio::ip::tcp::acceptor;
+  using socket = boost::asio::ip::tcp::socket;
+
+  static constexpr std::chrono::duration ReadTimeout = std::chrono::seconds{5};
+
+  std::shared_ptr<Metrics> metrics_;
+  std::shared_ptr<boost::asio::io_context> ioc_;
+  acceptor acceptor_;
+  socket socket_;
+  std::mutex mutex_{};
+
+public:
+  MetricsEndpoint(std::shared_ptr<Metrics> metrics, std::shared_ptr<boost::asio::io_context> ioc);
+  ~MetricsEndpoint() override;
+
+  unsigned short startup_safe(unsigned short port = 0);
+
+protected: // Shutdownable
+  [[nodiscard]] Promise<void> shutdown_() override;
+
+private:
+  void doAccept_safe();
+  void onAccept_safe(boost::system::error_code ec);
+  void doRequest(socket s);
+
+  static void logError(boost::system::error_code ec, const char* op);
+};
+
+
+#endif
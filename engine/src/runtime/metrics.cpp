@@ -0,0 +1,190 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./metrics.h"
+#include "utilities/logging.h"
+#include <algorithm>
+#include <cstdio>
+
+
+MetricsHistogram::MetricsHistogram(std::vector<double> bounds) :
+    bounds_{std::move(bounds)},
+    buckets_{new std::atomic<std::uint64_t>[bounds_.size() + 1]{}}
+{
+  LOG_ASSERT(std::is_sorted(bounds_.begin(), bounds_.end()));
+}
+
+
+void MetricsHistogram::observe(double value) {
+  auto i = std::lower_bound(bounds_.begin(), bounds_.end(), value);
+  buckets_[i - bounds_.begin()].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  double sum = sum_.load(std::memory_order_relaxed);
+  while (!sum_.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+  }
+}
+
+
+void MetricsHistogram::observe(std::chrono::steady_clock::duration duration) {
+  observe(std::chrono::duration<double>{duration}.count());
+}
+
+
+/***/
+
+
+const std::vector<double>& Metrics::durationBounds() {
+  static const std::vector<double> bounds{
+      0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0
+  };
+  return bounds;
+}
+
+
+MetricsCounter& Metrics::counter(const std::string& name, const std::string& labels) {
+  std::lock_guard lock{mutex_};
+  auto& series = getFamily_unsafe(name, Type::Counter).counters[labels];
+  if (!series) {
+    series = std::make_unique<MetricsCounter>();
+  }
+  return *series;
+}
+
+
+MetricsGauge& Metrics::gauge(const std::string& name, const std::string& labels) {
+  std::lock_guard lock{mutex_};
+  auto& series = getFamily_unsafe(name, Type::Gauge).gauges[labels];
+  if (!series) {
+    series = std::make_unique<MetricsGauge>();
+  }
+  return *series;
+}
+
+
+MetricsHistogram& Metrics::histogram(const std::string& name, const std::string& labels, const std::vector<double>& bounds) {
+  std::lock_guard lock{mutex_};
+  auto& series = getFamily_unsafe(name, Type::Histogram).histograms[labels];
+  if (!series) {
+    series = std::make_unique<MetricsHistogram>(bounds);
+  }
+  return *series;
+}
+
+
+/*
+ * Removing a series invalidates pointers to it, only the owner of
+ * the labels (e.g. a session removing its own series on shutdown)
+ * should remove a series.
+ */
+void Metrics::remove(const std::string& name, const std::string& labels) {
+  std::lock_guard lock{mutex_};
+  auto i = families_.find(name);
+  if (i != families_.end()) {
+    i->second.counters.erase(labels);
+    i->second.gauges.erase(labels);
+    i->second.histograms.erase(labels);
+  }
+}
+
+
+void Metrics::removeLabels(const std::string& labels) {
+  auto matches = [&labels](const auto& series) {
+    return series.first.compare(0, labels.size(), labels) == 0;
+  };
+  std::lock_guard lock{mutex_};
+  for (auto& family : families_) {
+    std::erase_if(family.second.counters, matches);
+    std::erase_if(family.second.gauges, matches);
+    std::erase_if(family.second.histograms, matches);
+  }
+}
+
+
+int Metrics::addCollector(std::function<void(Metrics&)> collector) {
+  std::lock_guard lock{collectorsMutex_};
+  int collectorId = ++lastCollectorId_;
+  collectors_[collectorId] = std::move(collector);
+  return collectorId;
+}
+
+
+void Metrics::removeCollector(int collectorId) {
+  std::lock_guard lock{collectorsMutex_};
+  collectors_.erase(collectorId);
+}
+
+
+static void appendSample(std::string& result, const std::string& name, const char* suffix, const std::string& labels, const char* extra, double value) {
+  result += name;
+  result += suffix;
+  if (!labels.empty() || extra) {
+    result += '{';
+    result += labels;
+    if (extra) {
+      if (!labels.empty()) {
+        result += ',';
+      }
+      result += extra;
+    }
+    result += '}';
+  }
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), " %.12g\n", value);
+  result += buffer;
+}
+
+
+std::string Metrics::render() {
+  {
+    std::lock_guard lock{collectorsMutex_};
+    for (auto& collector : collectors_) {
+      collector.second(*this);
+    }
+  }
+
+  std::string result{};
+  std::lock_guard lock{mutex_};
+  for (const auto& [name, family] : families_) {
+    switch (family.type) {
+      case Type::Counter:
+        result += "# TYPE " + name + " counter\n";
+        for (const auto& [labels, series] : family.counters) {
+          appendSample(result, name, "", labels, nullptr, static_cast<double>(series->value()));
+        }
+        break;
+      case Type::Gauge:
+        result += "# TYPE " + name + " gauge\n";
+        for (const auto& [labels, series] : family.gauges) {
+          appendSample(result, name, "", labels, nullptr, static_cast<double>(series->value()));
+        }
+        break;
+      case Type::Histogram:
+        result += "# TYPE " + name + " histogram\n";
+        for (const auto& [labels, series] : family.histograms) {
+          std::uint64_t cumulative = 0;
+          char le[32];
+          for (std::size_t i = 0; i != series->bounds().size(); ++i) {
+            cumulative += series->bucket(i);
+            std::snprintf(le, sizeof(le), "le=\"%g\"", series->bounds()[i]);
+            appendSample(result, name, "_bucket", labels, le, static_cast<double>(cumulative));
+          }
+          cumulative += series->bucket(series->bounds().size());
+          appendSample(result, name, "_bucket", labels, "le=\"+Inf\"", static_cast<double>(cumulative));
+          appendSample(result, name, "_sum", labels, nullptr, series->sum());
+          appendSample(result, name, "_count", labels, nullptr, static_cast<double>(cumulative));
+        }
+        break;
+    }
+  }
+  return result;
+}
+
+
+Metrics::Family& Metrics::getFamily_unsafe(const std::string& name, Type type) {
+  auto& family = families_[name];
+  if (family.counters.empty() && family.gauges.empty() && family.histograms.empty()) {
+    family.type = type;
+  }
+  LOG_ASSERT(family.type == type);
+  return family;
+}
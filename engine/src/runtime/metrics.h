@@ -0,0 +1,106 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__RUNTIME__METRICS_H
+#define WARSTAGE__RUNTIME__METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Metrics are counters, gauges and histograms, identified by a name and
+// a set of labels, and rendered in the Prometheus text exposition format.
+// Series are created on first use and never move, so callers on hot paths
+// look up a series once and keep the pointer. Updating a series is lock
+// free and may be done from any thread.
+//
+// Labels are passed preformatted, e.g. `peer="Daemon",message="ObjectChanges"`.
+
+
+class MetricsCounter {
+  std::atomic<std::uint64_t> value_{};
+public:
+  void increment(std::uint64_t value = 1) { value_.fetch_add(value, std::memory_order_relaxed); }
+  void set(std::uint64_t value) { value_.store(value, std::memory_order_relaxed); } // mirrors a counter kept elsewhere
+  [[nodiscard]] std::uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+};
+
+
+class MetricsGauge {
+  std::atomic<std::int64_t> value_{};
+public:
+  void set(std::int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  void add(std::int64_t value) { value_.fetch_add(value, std::memory_order_relaxed); }
+  [[nodiscard]] std::int64_t value() const { return value_.load(std::memory_order_relaxed); }
+};
+
+
+class MetricsHistogram {
+  const std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> buckets_;
+  std::atomic<std::uint64_t> count_{};
+  std::atomic<double> sum_{};
+
+public:
+  explicit MetricsHistogram(std::vector<double> bounds);
+
+  void observe(double value);
+  void observe(std::chrono::steady_clock::duration duration);
+
+  [[nodiscard]] const std::vector<double>& bounds() const { return bounds_; }
+  [[nodiscard]] std::uint64_t bucket(std::size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+  [[nodiscard]] std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  [[nodiscard]] double sum() const { return sum_.load(std::memory_order_relaxed); }
+};
+
+
+class Metrics {
+  enum class Type { Counter, Gauge, Histogram };
+
+  struct Family {
+    Type type{};
+    std::map<std::string, std::unique_ptr<MetricsCounter>> counters{};
+    std::map<std::string, std::unique_ptr<MetricsGauge>> gauges{};
+    std::map<std::string, std::unique_ptr<MetricsHistogram>> histograms{};
+  };
+
+  mutable std::mutex mutex_{};
+  std::map<std::string, Family> families_{};
+  std::mutex collectorsMutex_{};
+  std::map<int, std::function<void(Metrics&)>> collectors_{};
+  int lastCollectorId_{};
+
+public:
+  static const std::vector<double>& durationBounds();
+
+  Metrics() = default;
+  Metrics(const Metrics&) = delete;
+  Metrics& operator=(const Metrics&) = delete;
+
+  [[nodiscard]] MetricsCounter& counter(const std::string& name, const std::string& labels = {});
+  [[nodiscard]] MetricsGauge& gauge(const std::string& name, const std::string& labels = {});
+  [[nodiscard]] MetricsHistogram& histogram(const std::string& name, const std::string& labels = {}, const std::vector<double>& bounds = durationBounds());
+
+  void remove(const std::string& name, const std::string& labels);
+  void removeLabels(const std::string& labels); // all series with labels starting with the given labels
+
+  // Collectors are called before rendering, to sample values that are
+  // not updated as they change, e.g. the number of objects in a federation.
+  [[nodiscard]] int addCollector(std::function<void(Metrics&)> collector);
+  void removeCollector(int collectorId);
+
+  [[nodiscard]] std::string render();
+
+private:
+  Family& getFamily_unsafe(const std::string& name, Type type);
+};
+
+
+#endif
@@ -0,0 +1,95 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime/metrics.h"
+#include "runtime-fixture.h"
+#include "runtime/session.h"
+
+
+namespace {
+    std::size_t count_series(const std::string& text, const std::string& prefix) {
+        std::size_t result = 0;
+        for (auto i = text.find(prefix); i != std::string::npos; i = text.find(prefix, i + 1)) {
+            ++result;
+        }
+        return result;
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE(runtime_metrics)
+
+    BOOST_AUTO_TEST_CASE(render_counter_and_gauge) {
+        Metrics metrics{};
+        metrics.counter("packets_total", "peer=\"Daemon\"").increment(3);
+        metrics.counter("packets_total", "peer=\"Daemon\"").increment();
+        metrics.gauge("queue_bytes").set(17);
+
+        auto text = metrics.render();
+        BOOST_CHECK_NE(std::string::npos, text.find("# TYPE packets_total counter\n"));
+        BOOST_CHECK_NE(std::string::npos, text.find("packets_total{peer=\"Daemon\"} 4\n"));
+        BOOST_CHECK_NE(std::string::npos, text.find("# TYPE queue_bytes gauge\n"));
+        BOOST_CHECK_NE(std::string::npos, text.find("queue_bytes 17\n"));
+    }
+
+    BOOST_AUTO_TEST_CASE(render_histogram) {
+        Metrics metrics{};
+        auto& histogram = metrics.histogram("tick_seconds", "", {0.1, 1.0});
+        histogram.observe(0.05);
+        histogram.observe(0.5);
+        histogram.observe(5.0);
+
+        auto text = metrics.render();
+        BOOST_CHECK_NE(std::string::npos, text.find("tick_seconds_bucket{le=\"0.1\"} 1\n"));
+        BOOST_CHECK_NE(std::string::npos, text.find("tick_seconds_bucket{le=\"1\"} 2\n"));
+        BOOST_CHECK_NE(std::string::npos, text.find("tick_seconds_bucket{le=\"+Inf\"} 3\n"));
+        BOOST_CHECK_NE(std::string::npos, text.find("tick_seconds_sum 5.55"));
+        BOOST_CHECK_NE(std::string::npos, text.find("tick_seconds_count 3\n"));
+    }
+
+    BOOST_AUTO_TEST_CASE(collectors_and_removal) {
+        Metrics metrics{};
+        int collectorId = metrics.addCollector([](Metrics& m) {
+            m.gauge("objects", "federation=\"a\"").set(5);
+        });
+        metrics.counter("messages_total", "session=\"x\",message=\"A\"").increment();
+        metrics.counter("messages_total", "session=\"y\",message=\"A\"").increment();
+
+        auto text = metrics.render();
+        BOOST_CHECK_NE(std::string::npos, text.find("objects{federation=\"a\"} 5\n"));
+
+        metrics.removeCollector(collectorId);
+        metrics.remove("objects", "federation=\"a\"");
+        metrics.removeLabels("session=\"x\"");
+
+        text = metrics.render();
+        BOOST_CHECK_EQUAL(std::string::npos, text.find("objects{"));
+        BOOST_CHECK_EQUAL(std::string::npos, text.find("session=\"x\""));
+        BOOST_CHECK_NE(std::string::npos, text.find("messages_total{session=\"y\",message=\"A\"} 1\n"));
+    }
+
+    BOOST_AUTO_TEST_CASE(sessions_with_the_same_peer) {
+        Metrics metrics{};
+        RemoteFixture f{};
+        f.runtime1->setMetrics(&metrics);
+        f.strand->execute([&]() {
+            f.federate1->getObjectClass("Foo").create()["bar"] = 1;
+        });
+        f.strand->runUntilDone();
+
+        // the peer reconnects while the previous session is shutting down
+        f.runtime1->unregisterProcessSession_safe(f.runtime2->getProcessId());
+        f.runtime2->unregisterProcessSession_safe(f.runtime1->getProcessId());
+        auto session = f.endpoint1->openMasterSession();
+        f.strand->runUntilDone();
+        auto prefix = "warstage_session_received_bytes_total{process=\"" + f.runtime1->getProcessId().str() + "\"";
+        BOOST_CHECK_EQUAL(2u, count_series(metrics.render(), prefix));
+
+        // shutting down one session keeps the series of the other
+        session->shutdown().done();
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(1u, count_series(metrics.render(), prefix));
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 
 #include "mock-endpoint.h"
 #include "mock-session.h"
+#include <algorithm>
 
 
 MockEndpoint::MockEndpoint(Runtime& runtime, std::shared_ptr<Strand_base> strand) : Endpoint(runtime),
@@ -48,6 +49,44 @@ void MockEndpoint::reconnect() {
 }
 
 
+std::shared_ptr<Session> MockEndpoint::openMasterSession() {
+  return makeSession_safe("master");
+}
+
+
+void MockEndpoint::pause() {
+  for (auto& i : mockSessions_) {
+    if (auto session = i.lock()) {
+      session->pause();
+    }
+  }
+}
+
+
+void MockEndpoint::resume() {
+  for (auto& i : mockSessions_) {
+    if (auto session = i.lock()) {
+      session->resume();
+    }
+  }
+}
+
+
+SessionCounters MockEndpoint::getCounters_strand() const {
+  SessionCounters result{};
+  for (auto& i : mockSessions_) {
+    if (auto session = i.lock()) {
+      const auto& counters = session->getCounters_strand();
+      result.coalescedUpdates += counters.coalescedUpdates;
+      result.deferredUpdates += counters.deferredUpdates;
+      result.outgoingQueueFull += counters.outgoingQueueFull;
+      result.peakOutgoingQueueSize = std::max(result.peakOutgoingQueueSize, counters.peakOutgoingQueueSize);
+    }
+  }
+  return result;
+}
+
+
 void MockEndpoint::onSessionClosed(MockSession& session) {
   onSessionClosed_safe(session);
 }
@@ -56,10 +95,12 @@ void MockEndpoint::onSessionClosed(MockSession& session) {
 std::shared_ptr<Session> MockEndpoint::makeSession_safe(const std::string& url) {
   if (url == "master") {
     if (auto master = master_.lock()) {
-      auto result = std::make_shared<MockSession>(*this, strand_);
-      auto remote = std::make_shared<MockSession>(*master, master->strand_);
+      auto result = std::make_shared<MockSession>(*this, makeSessionStrand());
+      auto remote = std::make_shared<MockSession>(*master, master->makeSessionStrand());
       result->setRemote(*remote);
       remote->setRemote(*result);
+      result->connect();
+      remote->connect();
       mockSessions_.push_back(result);
       master->mockSessions_.push_back(remote);
       return result;
@@ -67,3 +108,8 @@ std::shared_ptr<Session> MockEndpoint::makeSession_safe(const std::string& url)
   }
   return nullptr;
 }
+
+
+std::shared_ptr<Strand_base> MockEndpoint::makeSessionStrand() const {
+  return strandFactory_ ? strandFactory_() : strand_;
+}
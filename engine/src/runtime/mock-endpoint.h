@@ -7,9 +7,11 @@
 #include "endpoint.h"
 
 class MockSession;
+struct SessionCounters;
 
 class MockEndpoint : public Endpoint {
   std::shared_ptr<Strand_base> strand_{};
+  std::function<std::shared_ptr<Strand_base>()> strandFactory_{};
   std::weak_ptr<MockEndpoint> master_{};
   std::vector<std::weak_ptr<MockSession>> mockSessions_{};
   bool disconnected_{};
@@ -23,13 +25,29 @@ protected: // Shutdownable
 public:
   void setMasterEndpoint(MockEndpoint& endpoint);
 
+  // Sessions run on the endpoint strand, unless a factory is set
+  // to give each session a strand of its own.
+  void setStrandFactory(std::function<std::shared_ptr<Strand_base>()> value) { strandFactory_ = std::move(value); }
+
   void disconnect();
   void reconnect();
 
+  // opens another session to the master, as a peer reconnecting
+  // before its previous session has shut down
+  std::shared_ptr<Session> openMasterSession();
+
+  // while paused, sessions hold back outgoing packets as pending writes
+  void pause();
+  void resume();
+  [[nodiscard]] SessionCounters getCounters_strand() const;
+
   void onSessionClosed(MockSession& session);
 
 protected: // Endpoint
   [[nodiscard]] std::shared_ptr<Session> makeSession_safe(const std::string& url) override;
+
+private:
+  [[nodiscard]] std::shared_ptr<Strand_base> makeSessionStrand() const;
 };
 
 #endif
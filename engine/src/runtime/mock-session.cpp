@@ -13,13 +13,25 @@ MockSession::MockSession(MockEndpoint& endpoint, std::shared_ptr<Strand_base> st
 
 void MockSession::setRemote(MockSession& remote) {
   remote_ = std::dynamic_pointer_cast<MockSession>(remote.shared_from_this());
-  sendHandshake_strand();
+}
+
+
+/*
+ * Both sides must have their remote set before either handshake is sent,
+ * since the sessions may run on different threads.
+ */
+void MockSession::connect() {
+  strand_->post([this_ = shared_from_this()]() {
+    auto session = std::static_pointer_cast<MockSession>(this_);
+    if (!session->isHandshakeSent_strand()) { // may already be sent in reply to the remote handshake
+      session->sendHandshake_strand();
+    }
+  });
 }
 
 
 void MockSession::disconnect() {
-  if (!disconnected_) {
-    disconnected_ = true;
+  if (!disconnected_.exchange(true)) {
     if (auto endpoint = mockEndpoint_.lock()) {
       endpoint->onSessionClosed(*this);
     }
@@ -29,9 +41,40 @@ void MockSession::disconnect() {
 }
 
 
+/*
+ * While paused, outgoing packets are held back as pending writes,
+ * as by a slow connection, and sent in order when resumed.
+ */
+void MockSession::pause() {
+  strand_->post([this_ = shared_from_this()]() {
+    std::static_pointer_cast<MockSession>(this_)->paused_ = true;
+  });
+}
+
+
+void MockSession::resume() {
+  strand_->post([this_ = shared_from_this()]() {
+    auto session = std::static_pointer_cast<MockSession>(this_);
+    auto packets = std::move(session->pausedPackets_);
+    session->pausedPackets_.clear();
+    session->pausedSize_ = 0;
+    session->paused_ = false;
+    for (const auto& packet : packets) {
+      session->sendPacketImpl_strand(packet);
+    }
+    session->outgoingQueueDrained_strand();
+  });
+}
+
+
 void MockSession::sendPacketImpl_strand(const Value& message) {
+  if (paused_) {
+    pausedPackets_.push_back(message);
+    pausedSize_ += message.size();
+    return;
+  }
   if (!disconnected_ && !remote_->disconnected_) {
-    remote_->strand_->setImmediate([remote = remote_, message]() {
+    remote_->strand_->post([remote = remote_, message]() {
       remote->receivePacket_strand(message);
     });
   }
@@ -5,6 +5,7 @@
 #define WARSTAGE__RUNTIME__MOCK_SESSION_H
 
 #include "session.h"
+#include <atomic>
 
 class MockEndpoint;
 
@@ -13,16 +14,24 @@ class MockSession : public Session {
 
   std::weak_ptr<MockEndpoint> mockEndpoint_{};
   std::shared_ptr<MockSession> remote_{};
-  bool disconnected_{};
+  std::atomic_bool disconnected_{}; // read from the remote session strand
+  bool paused_{}; // strand
+  std::vector<Value> pausedPackets_{}; // strand
+  std::size_t pausedSize_{}; // strand
 
 public:
   MockSession(MockEndpoint& endpoint, std::shared_ptr<Strand_base> strand);
 
   void setRemote(MockSession& remote);
+  void connect();
   void disconnect();
 
+  void pause();
+  void resume();
+
 protected:
   void sendPacketImpl_strand(const Value& message) override;
+  [[nodiscard]] std::size_t getPendingWriteSize_strand() override { return pausedSize_; }
 };
 
 #endif
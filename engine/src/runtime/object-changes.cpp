@@ -0,0 +1,423 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./object-changes.h"
+
+
+ValueHistory& ObjectChangesHistory::get(ObjectId objectId, int property) {
+  auto& properties = objects_[objectId];
+  for (auto& [id, history] : properties) {
+    if (id == property) {
+      return history;
+    }
+  }
+  return properties.emplace_back(property, ValueHistory{}).second;
+}
+
+
+/***/
+
+
+void ObjectChangesEncoder::begin(ObjectChange change, ObjectId objectId, const char* objectClass) {
+  ++messageCount_;
+  objectId_ = objectId;
+  objectClass_ = objectClass;
+  if (change == ObjectChange::Delete) {
+    history_.erase(objectId);
+  }
+  compressor_.begin();
+  compressor_.append_int32(static_cast<std::int32_t>(change));
+  compressor_.append_ObjectId(objectId);
+  addSymbol(classes_, objectClass);
+}
+
+
+void ObjectChangesEncoder::addProperty(const char* propertyName, const Value& value, double time, ObjectId processId) {
+  int property = addSymbol(properties_, propertyName);
+  compressor_.append_float(static_cast<float>(time));
+
+  int process;
+  auto i = processes_.find(processId);
+  if (i != processes_.end()) {
+    process = i->second;
+  } else {
+    process = static_cast<int>(processes_.size());
+    processes_[processId] = process;
+  }
+  if (value.is_defined()) {
+    compressor_.append_int32(process);
+  } else {
+    compressor_.append_int32(-1 - process);
+  }
+  if (i == processes_.end()) {
+    compressor_.append_ObjectId(processId);
+  }
+  if (value.is_defined()) {
+    auto encoding = schema_ ? schema_->find(objectClass_, propertyName) : nullptr;
+    if (floatDelta_) {
+      compressor_.append(value, history_.get(objectId_, property), encoding);
+    } else {
+      compressor_.append(value, encoding);
+    }
+  }
+}
+
+
+Binary ObjectChangesEncoder::end() {
+  compressor_.end();
+  return Binary{compressor_.data(), compressor_.size()};
+}
+
+
+void ObjectChangesEncoder::beginSnapshot() {
+  compressor_.begin();
+}
+
+
+void ObjectChangesEncoder::addObject(ObjectId objectId, const char* objectClass) {
+  ++messageCount_;
+  objectId_ = objectId;
+  objectClass_ = objectClass;
+  compressor_.append_int32(-1);
+  compressor_.append_ObjectId(objectId);
+  addSymbol(classes_, objectClass);
+}
+
+
+int ObjectChangesEncoder::addSymbol(SymbolTable& symbols, const char* name) {
+  int index = symbols.FindIndex(name, false);
+  if (index != -1) {
+    compressor_.append_int32(index);
+  } else {
+    index = symbols.GetIndex(name, false);
+    compressor_.append_int32(index);
+    compressor_.append_string(name);
+  }
+  return index;
+}
+
+
+/***/
+
+
+void ObjectChangesDecoder::reset() {
+  decompressor_ = ValueDecompressor{};
+  classes_.clear();
+  properties_.clear();
+  processes_.clear();
+  history_.clear();
+}
+
+
+const ObjectChangesMessage* ObjectChangesDecoder::decode(Binary data) {
+  callback_ = nullptr;
+  expect_ = Expect::Change;
+  depth_ = 0;
+  failure_ = false;
+  decompressor_.use_history(nullptr);
+  decompressor_.use_encoding(nullptr);
+
+  if (!decompressor_.visit_array(data.data, data.size, *this) || failure_ || expect_ != Expect::Property) {
+    return nullptr;
+  }
+
+  finishMessage();
+  return &message_;
+}
+
+
+bool ObjectChangesDecoder::decodeSnapshot(Binary data, const std::function<void(const ObjectChangesMessage&)>& callback) {
+  reset();
+  callback_ = &callback;
+  expect_ = Expect::Change;
+  depth_ = 0;
+  failure_ = false;
+
+  bool valid = decompressor_.visit_array(data.data, data.size, *this) && !failure_
+      && (expect_ == Expect::Change || expect_ == Expect::Property);
+  if (valid && expect_ == Expect::Property) {
+    finishMessage();
+  }
+
+  callback_ = nullptr;
+  return valid;
+}
+
+
+/***/
+
+
+void ObjectChangesDecoder::begin_document(const char* name) {
+  if (!failure_ && beginValue()) {
+    values_.begin_document(name);
+    ++depth_;
+  }
+}
+
+
+void ObjectChangesDecoder::begin_array(const char* name) {
+  if (!failure_ && beginValue()) {
+    values_.begin_array(name);
+    ++depth_;
+  }
+}
+
+
+void ObjectChangesDecoder::end() {
+  if (!failure_) {
+    values_.end();
+    --depth_;
+    endValue();
+  }
+}
+
+
+void ObjectChangesDecoder::visit_null(const char* name) {
+  if (!failure_ && beginValue()) {
+    values_.visit_null(name);
+    endValue();
+  }
+}
+
+
+void ObjectChangesDecoder::visit_boolean(const char* name, bool value) {
+  if (!failure_ && beginValue()) {
+    values_.visit_boolean(name, value);
+    endValue();
+  }
+}
+
+
+void ObjectChangesDecoder::visit_int32(const char* name, std::int32_t value) {
+  if (failure_) {
+    return;
+  }
+  if (depth_ != 0 || expect_ == Expect::Value) {
+    if (beginValue()) {
+      values_.visit_int32(name, value);
+      endValue();
+    }
+    return;
+  }
+
+  switch (expect_) {
+    case Expect::Change:
+      if (callback_ && value != -1) {
+        return fail();
+      }
+      beginMessage(callback_ ? ObjectChange::Discover : static_cast<ObjectChange>(value));
+      expect_ = Expect::ObjectId;
+      break;
+
+    case Expect::Class:
+      if (value == static_cast<std::int32_t>(classes_.size())) {
+        expect_ = Expect::ClassName;
+      } else if ((message_.objectClass = findSymbol(classes_, value))) {
+        expect_ = Expect::Property;
+      } else {
+        fail();
+      }
+      break;
+
+    case Expect::Property:
+      if (callback_ && value == -1) {
+        finishMessage();
+        beginMessage(ObjectChange::Discover);
+        expect_ = Expect::ObjectId;
+        break;
+      }
+      message_.properties.emplace_back();
+      valueRanges_.emplace_back();
+      property_ = value;
+      if (value == static_cast<std::int32_t>(properties_.size())) {
+        expect_ = Expect::PropertyName;
+      } else if ((message_.properties.back().propertyName = findSymbol(properties_, value))) {
+        expect_ = Expect::Time;
+      } else {
+        fail();
+      }
+      break;
+
+    case Expect::Process:
+      defined_ = value >= 0;
+      if (!defined_) {
+        value = -1 - value;
+      }
+      if (value == static_cast<std::int32_t>(processes_.size())) {
+        expect_ = Expect::ProcessId;
+      } else if (value < static_cast<std::int32_t>(processes_.size())) {
+        message_.properties.back().processId = processes_[value];
+        expectValue();
+      } else {
+        fail();
+      }
+      break;
+
+    default:
+      fail();
+      break;
+  }
+}
+
+
+void ObjectChangesDecoder::visit_double(const char* name, double value) {
+  if (failure_) {
+    return;
+  }
+  if (depth_ != 0 || expect_ == Expect::Value) {
+    if (beginValue()) {
+      values_.visit_double(name, value);
+      endValue();
+    }
+  } else if (expect_ == Expect::Time) {
+    message_.properties.back().time = value;
+    expect_ = Expect::Process;
+  } else {
+    fail();
+  }
+}
+
+
+void ObjectChangesDecoder::visit_string(const char* name, const char* data, std::size_t size) {
+  if (failure_) {
+    return;
+  }
+  if (depth_ != 0 || expect_ == Expect::Value) {
+    if (beginValue()) {
+      values_.visit_string(name, data, size);
+      endValue();
+    }
+  } else if (expect_ == Expect::ClassName) {
+    message_.objectClass = classes_.emplace_back(data, size).c_str();
+    expect_ = Expect::Property;
+  } else if (expect_ == Expect::PropertyName) {
+    message_.properties.back().propertyName = properties_.emplace_back(data, size).c_str();
+    expect_ = Expect::Time;
+  } else {
+    fail();
+  }
+}
+
+
+void ObjectChangesDecoder::visit_binary(const char* name, const void* data, std::size_t size) {
+  if (!failure_ && beginValue()) {
+    values_.visit_binary(name, data, size);
+    endValue();
+  }
+}
+
+
+void ObjectChangesDecoder::visit_ObjectId(const char* name, ObjectId value) {
+  if (failure_) {
+    return;
+  }
+  if (depth_ != 0 || expect_ == Expect::Value) {
+    if (beginValue()) {
+      values_.visit_ObjectId(name, value);
+      endValue();
+    }
+  } else if (expect_ == Expect::ObjectId) {
+    message_.objectId = value;
+    if (message_.change == ObjectChange::Delete) {
+      history_.erase(value);
+    }
+    expect_ = Expect::Class;
+  } else if (expect_ == Expect::ProcessId) {
+    processes_.push_back(value);
+    message_.properties.back().processId = value;
+    expectValue();
+  } else {
+    fail();
+  }
+}
+
+
+/***/
+
+
+void ObjectChangesDecoder::beginMessage(ObjectChange change) {
+  message_.change = change;
+  message_.objectClass = nullptr;
+  message_.properties.clear();
+  valueRanges_.clear();
+  values_.clear();
+}
+
+
+/*
+ * Values are written back to back in values_ while decoding, and made
+ * when the message is complete, since the buffer may move while it grows.
+ */
+void ObjectChangesDecoder::finishMessage() {
+  std::shared_ptr<ValueBuffer> buffer{};
+  for (std::size_t i = 0; i != valueRanges_.size(); ++i) {
+    auto [start, end] = valueRanges_[i];
+    if (start == end) {
+      continue;
+    }
+    auto data = reinterpret_cast<const char*>(values_.buffer().data());
+    if (end - start <= Value::InlineSize && Value::is_inline_type(static_cast<ValueType>(data[start]))) {
+      message_.properties[i].value = Value::make_element(data + start, end - start);
+    } else {
+      if (!buffer) {
+        buffer = std::make_shared<ValueBuffer>(values_.buffer().data(), values_.buffer().size());
+      }
+      auto p = reinterpret_cast<const char*>(buffer->data());
+      message_.properties[i].value = Value{buffer, p + start, p + end};
+    }
+  }
+
+  if (callback_) {
+    (*callback_)(message_);
+  }
+}
+
+
+/*
+ * Scalar callbacks and nested documents at depth 0 are property values,
+ * anything deeper is part of the value being written.
+ */
+bool ObjectChangesDecoder::beginValue() {
+  if (depth_ != 0) {
+    return true;
+  }
+  if (expect_ != Expect::Value) {
+    fail();
+    return false;
+  }
+  valueRanges_.back().first = values_.buffer().size();
+  return true;
+}
+
+
+/*
+ * The decompressor reads the value after this returns, with the
+ * history of the property to decode xor-ed floats.
+ */
+void ObjectChangesDecoder::expectValue() {
+  if (defined_) {
+    decompressor_.use_history(&history_.get(message_.objectId, property_));
+    decompressor_.use_encoding(schema_ ? schema_->find(message_.objectClass, message_.properties.back().propertyName) : nullptr);
+    expect_ = Expect::Value;
+  } else {
+    expect_ = Expect::Property;
+  }
+}
+
+
+void ObjectChangesDecoder::endValue() {
+  if (depth_ == 0) {
+    valueRanges_.back().second = values_.buffer().size();
+    decompressor_.use_history(nullptr);
+    decompressor_.use_encoding(nullptr);
+    expect_ = Expect::Property;
+  }
+}
+
+
+const char* ObjectChangesDecoder::findSymbol(const std::deque<std::string>& symbols, std::int32_t index) {
+  if (index < 0 || index >= static_cast<std::int32_t>(symbols.size())) {
+    return nullptr;
+  }
+  return symbols[index].c_str();
+}
@@ -0,0 +1,166 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__RUNTIME__OBJECT_CHANGES_H
+#define WARSTAGE__RUNTIME__OBJECT_CHANGES_H
+
+#include "./object-schema.h"
+#include "./runtime.h"
+#include "value/compressor.h"
+#include "value/decompressor.h"
+#include "value/dictionary.h"
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+
+// An object change is written directly in the compressor wire format,
+// as a sequence of unnamed elements (see ValueCompressor::append):
+//
+// <int change>, <ObjectId objectId>, <class>, { <property>, <float time>, <process>, <value> }*
+//
+// Class names, property names and process ids are replaced by numeric ids,
+// scoped to the encoder/decoder pair. An id equal to the number of known ids
+// is a new id, and is followed by its definition (a string for class and
+// property names, an ObjectId for processes). An undefined value is omitted,
+// and signalled by writing the process id N as -1-N.
+//
+// The encoder and decoder are stateful, the decoder must be reset whenever
+// a new encoder starts sending.
+//
+// Floats in values are sent as the xor with the float last sent for the
+// same object and property, see ValueCompressor::append, unless float
+// delta is turned off on the encoder. The decoder reads both forms. The
+// history of an object is dropped when it is deleted.
+//
+// Properties declared in the schema are written with their encoding, and
+// the schema must be set on both the encoder and decoder before the first
+// message.
+//
+// A snapshot holds the discovery of many objects in a single document,
+// with ids scoped to the snapshot, each object starting with -1:
+//
+// { <int -1>, <ObjectId objectId>, <class>, { <property>, <float time>, <process>, <value> }* }*
+
+
+// The float histories of the values sent for each object, by property
+// id, kept in step by the encoder and decoder. Objects send only a few
+// of the many property names known to the session, so each object keeps
+// a short list rather than a slot for every property id.
+
+class ObjectChangesHistory {
+  std::unordered_map<ObjectId, std::vector<std::pair<int, ValueHistory>>> objects_{};
+
+public:
+  [[nodiscard]] ValueHistory& get(ObjectId objectId, int property);
+  void erase(ObjectId objectId) { objects_.erase(objectId); }
+  void clear() { objects_.clear(); }
+};
+
+
+class ObjectChangesEncoder {
+  ValueCompressor compressor_{};
+  SymbolTable classes_{};
+  SymbolTable properties_{};
+  std::unordered_map<ObjectId, int> processes_{};
+  ObjectChangesHistory history_{};
+  const ObjectSchema* schema_{};
+  bool floatDelta_{true};
+  ObjectId objectId_{};
+  const char* objectClass_{};
+  int messageCount_{};
+
+public:
+  [[nodiscard]] bool isFirstMessage() const { return messageCount_ == 1; }
+  [[nodiscard]] bool hasMessages() const { return messageCount_ != 0; }
+
+  [[nodiscard]] const ObjectSchema* getSchema() const { return schema_; }
+  void setSchema(const ObjectSchema* value) { schema_ = value; }
+
+  [[nodiscard]] bool getFloatDelta() const { return floatDelta_; }
+  void setFloatDelta(bool value) { floatDelta_ = value; }
+
+  void begin(ObjectChange change, ObjectId objectId, const char* objectClass);
+  void addProperty(const char* propertyName, const Value& value, double time, ObjectId processId);
+  [[nodiscard]] Binary end();
+
+  void beginSnapshot();
+  void addObject(ObjectId objectId, const char* objectClass);
+
+private:
+  int addSymbol(SymbolTable& symbols, const char* name);
+};
+
+
+struct ObjectChangesProperty {
+  const char* propertyName{};
+  Value value{};
+  double time{};
+  ObjectId processId{};
+};
+
+struct ObjectChangesMessage {
+  ObjectChange change{};
+  ObjectId objectId{};
+  const char* objectClass{};
+  std::vector<ObjectChangesProperty> properties{};
+};
+
+
+// Decodes object changes while the compressed stream is read, see
+// ValueDecompressor::visit, so header fields and scalar values never
+// pass through an intermediate document. Scalar values are made inline,
+// other values share one buffer per message.
+
+class ObjectChangesDecoder : private ValueVisitor {
+  enum class Expect { Change, ObjectId, Class, ClassName, Property, PropertyName, Time, Process, ProcessId, Value };
+
+  ValueDecompressor decompressor_{};
+  ValueWriter values_{};
+  std::vector<std::pair<std::size_t, std::size_t>> valueRanges_{};
+  std::deque<std::string> classes_{};
+  std::deque<std::string> properties_{};
+  std::vector<ObjectId> processes_{};
+  ObjectChangesHistory history_{};
+  const ObjectSchema* schema_{};
+  ObjectChangesMessage message_{};
+  const std::function<void(const ObjectChangesMessage&)>* callback_{};
+  Expect expect_{};
+  int depth_{};
+  int property_{};
+  bool defined_{};
+  bool failure_{};
+
+public:
+  void reset();
+  void setSchema(const ObjectSchema* value) { schema_ = value; }
+
+  [[nodiscard]] const ObjectChangesMessage* decode(Binary data);
+  [[nodiscard]] bool decodeSnapshot(Binary data, const std::function<void(const ObjectChangesMessage&)>& callback);
+
+private:
+  void begin_document(const char* name) override;
+  void begin_array(const char* name) override;
+  void end() override;
+
+  void visit_null(const char* name) override;
+  void visit_boolean(const char* name, bool value) override;
+  void visit_int32(const char* name, std::int32_t value) override;
+  void visit_double(const char* name, double value) override;
+  void visit_string(const char* name, const char* data, std::size_t size) override;
+  void visit_binary(const char* name, const void* data, std::size_t size) override;
+  void visit_ObjectId(const char* name, ObjectId value) override;
+
+  void beginMessage(ObjectChange change);
+  void finishMessage();
+  [[nodiscard]] bool beginValue();
+  void expectValue();
+  void endValue();
+  void fail() { failure_ = true; }
+
+  static const char* findSymbol(const std::deque<std::string>& symbols, std::int32_t index);
+};
+
+
+#endif
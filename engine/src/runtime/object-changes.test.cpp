@@ -0,0 +1,219 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime/object-changes.h"
+
+
+BOOST_AUTO_TEST_SUITE(runtime_object_changes)
+
+    BOOST_AUTO_TEST_CASE(encode_decode_discover) {
+        auto objectId = ObjectId::parse("111122223333444455556666");
+        auto processId = ObjectId::parse("777788889999aaaabbbbcccc");
+
+        ObjectChangesEncoder encoder{};
+        encoder.begin(ObjectChange::Discover, objectId, "Unit");
+        encoder.addProperty("name", *(Struct{} << "" << "foo" << ValueEnd{}).begin(), 0.5, processId);
+        encoder.addProperty("deleted", Value{}, 0.0, processId);
+        auto data = encoder.end();
+        BOOST_CHECK(encoder.isFirstMessage());
+
+        ObjectChangesDecoder decoder{};
+        auto message = decoder.decode(data);
+        BOOST_REQUIRE(message);
+        BOOST_CHECK(message->change == ObjectChange::Discover);
+        BOOST_CHECK(message->objectId == objectId);
+        BOOST_CHECK_EQUAL(std::string("Unit"), message->objectClass);
+        BOOST_REQUIRE_EQUAL(2, message->properties.size());
+        BOOST_CHECK_EQUAL(std::string("name"), message->properties[0].propertyName);
+        BOOST_CHECK_EQUAL(std::string("foo"), message->properties[0].value._c_str());
+        BOOST_CHECK_EQUAL(0.5, message->properties[0].time);
+        BOOST_CHECK(message->properties[0].processId == processId);
+        BOOST_CHECK_EQUAL(std::string("deleted"), message->properties[1].propertyName);
+        BOOST_CHECK(message->properties[1].value.is_undefined());
+        BOOST_CHECK(message->properties[1].processId == processId);
+    }
+
+    BOOST_AUTO_TEST_CASE(encode_decode_reuses_ids) {
+        auto objectId = ObjectId::parse("111122223333444455556666");
+        auto processId = ObjectId::parse("777788889999aaaabbbbcccc");
+
+        ObjectChangesEncoder encoder{};
+        ObjectChangesDecoder decoder{};
+
+        encoder.begin(ObjectChange::Discover, objectId, "Unit");
+        encoder.addProperty("position", *(Struct{} << "" << 1 << ValueEnd{}).begin(), 0.0, processId);
+        auto data = encoder.end();
+        auto size = data.size;
+        BOOST_REQUIRE(decoder.decode(data));
+
+        encoder.begin(ObjectChange::Update, objectId, "Unit");
+        encoder.addProperty("position", *(Struct{} << "" << 2 << ValueEnd{}).begin(), 0.0, processId);
+        data = encoder.end();
+        BOOST_CHECK(!encoder.isFirstMessage());
+        BOOST_CHECK_LT(data.size, size);
+
+        auto message = decoder.decode(data);
+        BOOST_REQUIRE(message);
+        BOOST_CHECK(message->change == ObjectChange::Update);
+        BOOST_CHECK(message->objectId == objectId);
+        BOOST_CHECK_EQUAL(std::string("Unit"), message->objectClass);
+        BOOST_REQUIRE_EQUAL(1, message->properties.size());
+        BOOST_CHECK_EQUAL(std::string("position"), message->properties[0].propertyName);
+        BOOST_CHECK_EQUAL(2, message->properties[0].value._int32());
+        BOOST_CHECK(message->properties[0].processId == processId);
+    }
+
+    BOOST_AUTO_TEST_CASE(encode_decode_document_values) {
+        auto objectId = ObjectId::parse("111122223333444455556666");
+        auto processId = ObjectId::parse("777788889999aaaabbbbcccc");
+
+        ObjectChangesEncoder encoder{};
+        encoder.begin(ObjectChange::Discover, objectId, "Unit");
+        encoder.addProperty("position", *(Struct{} << "" << Array{} << 1.5 << 2.5 << ValueEnd{} << ValueEnd{}).begin(), 0.0, processId);
+        encoder.addProperty("stats", *(Struct{} << "" << Struct{} << "count" << 12 << "name" << "foo" << ValueEnd{} << ValueEnd{}).begin(), 0.0, processId);
+        encoder.addProperty("alliance", *(Struct{} << "" << processId << ValueEnd{}).begin(), 0.0, processId);
+        auto data = encoder.end();
+
+        ObjectChangesDecoder decoder{};
+        auto message = decoder.decode(data);
+        BOOST_REQUIRE(message);
+        BOOST_REQUIRE_EQUAL(3, message->properties.size());
+        auto position = message->properties[0].value._vec2();
+        BOOST_CHECK_EQUAL(1.5f, position.x);
+        BOOST_CHECK_EQUAL(2.5f, position.y);
+        BOOST_CHECK_EQUAL(12, message->properties[1].value["count"_int]);
+        BOOST_CHECK_EQUAL(std::string("foo"), message->properties[1].value["name"_c_str]);
+        BOOST_CHECK(message->properties[2].value.is_inline());
+        BOOST_CHECK(message->properties[2].value._ObjectId() == processId);
+    }
+
+    BOOST_AUTO_TEST_CASE(encode_decode_float_changes) {
+        auto objectId = ObjectId::parse("111122223333444455556666");
+        auto processId = ObjectId::parse("777788889999aaaabbbbcccc");
+
+        ObjectChangesEncoder encoder{};
+        ObjectChangesDecoder decoder{};
+        std::size_t size = 0;
+        for (int i = 0; i != 4; ++i) {
+            int j = std::min(i, 2); // the last update repeats the values
+            encoder.begin(i == 0 ? ObjectChange::Discover : ObjectChange::Update, objectId, "Unit");
+            encoder.addProperty("position", *(Struct{} << "" << glm::vec2{512.0f + 0.25f * j, 256.0f} << ValueEnd{}).begin(), 0.0, processId);
+            encoder.addProperty("morale", *(Struct{} << "" << 1.0f - 0.01f * j << ValueEnd{}).begin(), 0.0, processId);
+            auto data = encoder.end();
+            if (i == 3) {
+                BOOST_CHECK_LT(data.size, size);
+            }
+            size = data.size;
+
+            auto message = decoder.decode(data);
+            BOOST_REQUIRE(message);
+            BOOST_REQUIRE_EQUAL(2, message->properties.size());
+            auto position = message->properties[0].value._vec2();
+            BOOST_CHECK_EQUAL(512.0f + 0.25f * j, position.x);
+            BOOST_CHECK_EQUAL(256.0f, position.y);
+            BOOST_CHECK_EQUAL(1.0f - 0.01f * j, message->properties[1].value._float());
+        }
+
+        encoder.begin(ObjectChange::Delete, objectId, "Unit");
+        BOOST_REQUIRE(decoder.decode(encoder.end()));
+        encoder.begin(ObjectChange::Discover, objectId, "Unit");
+        encoder.addProperty("morale", *(Struct{} << "" << 0.5f << ValueEnd{}).begin(), 0.0, processId);
+        auto message = decoder.decode(encoder.end());
+        BOOST_REQUIRE(message);
+        BOOST_CHECK_EQUAL(0.5f, message->properties[0].value._float());
+    }
+
+    BOOST_AUTO_TEST_CASE(encode_decode_float_changes_without_delta) {
+        auto objectId = ObjectId::parse("111122223333444455556666");
+        auto processId = ObjectId::parse("777788889999aaaabbbbcccc");
+
+        ObjectChangesEncoder encoder{};
+        ObjectChangesDecoder decoder{};
+        for (int i = 0; i != 6; ++i) {
+            encoder.setFloatDelta(i < 2 || i >= 4);
+            encoder.begin(i == 0 ? ObjectChange::Discover : ObjectChange::Update, objectId, "Unit");
+            encoder.addProperty("morale", *(Struct{} << "" << 1.0f - 0.01f * i << ValueEnd{}).begin(), 0.0, processId);
+            encoder.addProperty(makeString("p%d", i).c_str(), *(Struct{} << "" << 2.0f * i << ValueEnd{}).begin(), 0.0, processId);
+            auto message = decoder.decode(encoder.end());
+            BOOST_REQUIRE(message);
+            BOOST_REQUIRE_EQUAL(2, message->properties.size());
+            BOOST_CHECK_EQUAL(1.0f - 0.01f * i, message->properties[0].value._float());
+            BOOST_CHECK_EQUAL(2.0f * i, message->properties[1].value._float());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(encode_decode_with_schema) {
+        auto objectId = ObjectId::parse("111122223333444455556666");
+        auto processId = ObjectId::parse("777788889999aaaabbbbcccc");
+
+        ObjectSchema local{};
+        local.define("Unit", "morale", ValueEncoding::fixed(0.0f, 1.0f, 8));
+        local.define("Unit", "center", ValueEncoding::fixed(0.0f, 1024.0f, 17));
+        ObjectSchema remote{};
+        remote.define("Unit", "morale", ValueEncoding::fixed(0.0f, 1.0f, 8));
+        remote.define("Unit", "center", ValueEncoding::fixed(0.0f, 1024.0f, 16));
+        auto schema = local.agree(ObjectSchema::fromValue(remote.toValue()));
+        BOOST_CHECK(schema.find("Unit", "morale"));
+        BOOST_CHECK(!schema.find("Unit", "center"));
+        BOOST_CHECK(!schema.find("Unit", "path"));
+
+        ObjectChangesEncoder encoder{};
+        ObjectChangesDecoder decoder{};
+        encoder.setSchema(&schema);
+        decoder.setSchema(&schema);
+        encoder.begin(ObjectChange::Discover, objectId, "Unit");
+        encoder.addProperty("morale", *(Struct{} << "" << 0.5f << ValueEnd{}).begin(), 0.0, processId);
+        encoder.addProperty("center", *(Struct{} << "" << glm::vec2{100.25f, 200.0f} << ValueEnd{}).begin(), 0.0, processId);
+        auto message = decoder.decode(encoder.end());
+        BOOST_REQUIRE(message);
+        BOOST_REQUIRE_EQUAL(2, message->properties.size());
+        BOOST_CHECK_CLOSE(0.5f, message->properties[0].value._float(), 0.5);
+        BOOST_CHECK_EQUAL(100.25f, message->properties[1].value._vec2().x);
+    }
+
+    BOOST_AUTO_TEST_CASE(decode_unknown_id_fails) {
+        ObjectChangesEncoder encoder{};
+        encoder.begin(ObjectChange::Discover, ObjectId::parse("111122223333444455556666"), "Unit");
+        encoder.end();
+        encoder.begin(ObjectChange::Delete, ObjectId::parse("111122223333444455556666"), "Unit");
+        auto data = encoder.end();
+
+        ObjectChangesDecoder decoder{};
+        BOOST_CHECK(!decoder.decode(data));
+    }
+
+    BOOST_AUTO_TEST_CASE(encode_decode_snapshot) {
+        auto objectId1 = ObjectId::parse("111122223333444455556666");
+        auto objectId2 = ObjectId::parse("111122223333444455557777");
+        auto processId = ObjectId::parse("777788889999aaaabbbbcccc");
+
+        ObjectChangesEncoder encoder{};
+        encoder.beginSnapshot();
+        encoder.addObject(objectId1, "Unit");
+        encoder.addProperty("position", *(Struct{} << "" << 1 << ValueEnd{}).begin(), 0.0, processId);
+        encoder.addProperty("deleted", Value{}, 0.0, processId);
+        encoder.addObject(objectId2, "Unit");
+        encoder.addProperty("position", *(Struct{} << "" << 2 << ValueEnd{}).begin(), 0.0, processId);
+        auto data = encoder.end();
+
+        std::vector<ObjectId> objectIds{};
+        std::vector<int> positions{};
+        ObjectChangesDecoder decoder{};
+        BOOST_REQUIRE(decoder.decodeSnapshot(data, [&](const ObjectChangesMessage& message) {
+            BOOST_CHECK(message.change == ObjectChange::Discover);
+            BOOST_CHECK_EQUAL(std::string("Unit"), message.objectClass);
+            BOOST_REQUIRE(!message.properties.empty());
+            BOOST_CHECK_EQUAL(std::string("position"), message.properties[0].propertyName);
+            BOOST_CHECK(message.properties[0].processId == processId);
+            objectIds.push_back(message.objectId);
+            positions.push_back(message.properties[0].value._int32());
+        }));
+        BOOST_REQUIRE_EQUAL(2, objectIds.size());
+        BOOST_CHECK(objectIds[0] == objectId1);
+        BOOST_CHECK(objectIds[1] == objectId2);
+        BOOST_CHECK_EQUAL(1, positions[0]);
+        BOOST_CHECK_EQUAL(2, positions[1]);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
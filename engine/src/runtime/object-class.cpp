@@ -108,10 +108,7 @@ ObjectRef ObjectClass::create(ObjectId objectId) {
 
   federate_->objectInstances_.push_back(objectInstance);
 
-  {
-    std::lock_guard federate_lock{federate_->mutex_};
-    federate_->tryScheduleImmediateSynchronize_unsafe();
-  }
+  federate_->scheduleSynchronize_strand();
 
   ObjectRef object;
   object.instance_ = objectInstance;
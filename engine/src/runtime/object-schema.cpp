@@ -0,0 +1,101 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./object-schema.h"
+#include <algorithm>
+
+
+void ObjectSchema::define(const char* objectClass, const char* propertyName, ValueEncoding encoding) {
+  auto i = classes_.find(objectClass);
+  if (i == classes_.end()) {
+    i = classes_.emplace(addName(objectClass), Properties{}).first;
+  }
+  auto j = i->second.find(propertyName);
+  if (j != i->second.end()) {
+    j->second = std::move(encoding);
+  } else {
+    i->second.emplace(addName(propertyName), std::move(encoding));
+  }
+}
+
+
+const ValueEncoding* ObjectSchema::find(const char* objectClass, const char* propertyName) const {
+  auto i = classes_.find(objectClass);
+  if (i == classes_.end()) {
+    return nullptr;
+  }
+  auto j = i->second.find(propertyName);
+  return j != i->second.end() ? &j->second : nullptr;
+}
+
+
+/*
+ * The schema is sent as an array of property encodings:
+ * { "c": class, "p": property, "t": type, "b": bits, "lo": min, "hi": max, "n": [names] }
+ */
+Value ObjectSchema::toValue() const {
+  auto builder = build_array();
+  for (const auto& [objectClass, properties] : classes_) {
+    for (const auto& [propertyName, encoding] : properties) {
+      auto names = build_array();
+      for (const auto& name : encoding.names) {
+        names = std::move(names) << name;
+      }
+      builder = std::move(builder) << Struct{}
+          << "c" << std::string{objectClass}
+          << "p" << std::string{propertyName}
+          << "t" << static_cast<int>(encoding.type)
+          << "b" << encoding.bits
+          << "lo" << encoding.min
+          << "hi" << encoding.max
+          << "n" << (std::move(names) << ValueEnd{})
+          << ValueEnd{};
+    }
+  }
+  return std::move(builder) << ValueEnd{};
+}
+
+
+ObjectSchema ObjectSchema::fromValue(const Value& value) {
+  ObjectSchema result{};
+  for (const auto& item : value) {
+    const char* objectClass = item["c"_c_str];
+    const char* propertyName = item["p"_c_str];
+    int type = item["t"_int];
+    if (!objectClass || !propertyName || type < static_cast<int>(ValueEncoding::Type::Float16) || type > static_cast<int>(ValueEncoding::Type::Enum)) {
+      continue;
+    }
+    ValueEncoding encoding{static_cast<ValueEncoding::Type>(type), item["b"_int], item["lo"_float], item["hi"_float]};
+    if (encoding.type == ValueEncoding::Type::Fixed) {
+      encoding.bits = std::clamp(encoding.bits, 1, 31);
+    }
+    for (const auto& name : item["n"_value]) {
+      encoding.names.emplace_back(name._c_str() ?: "");
+    }
+    result.define(objectClass, propertyName, std::move(encoding));
+  }
+  return result;
+}
+
+
+ObjectSchema ObjectSchema::agree(const ObjectSchema& other) const {
+  ObjectSchema result{};
+  for (const auto& [objectClass, properties] : classes_) {
+    auto i = other.classes_.find(objectClass);
+    if (i == other.classes_.end()) {
+      continue;
+    }
+    for (const auto& [propertyName, encoding] : properties) {
+      auto j = i->second.find(propertyName);
+      if (j != i->second.end() && j->second == encoding) {
+        result.define(std::string{objectClass}.c_str(), std::string{propertyName}.c_str(), encoding);
+      }
+    }
+  }
+  return result;
+}
+
+
+std::string_view ObjectSchema::addName(const char* name) {
+  return names_.emplace_back(name);
+}
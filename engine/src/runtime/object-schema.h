@@ -0,0 +1,49 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__RUNTIME__OBJECT_SCHEMA_H
+#define WARSTAGE__RUNTIME__OBJECT_SCHEMA_H
+
+#include "value/encoding.h"
+#include "value/value.h"
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+// Declares how properties of object classes are encoded when object
+// changes are sent to other processes (see ValueEncoding), trading
+// precision for size. Both processes send their schema in the session
+// handshake, and an encoding is only used if both declared the same
+// encoding for the property. Properties not in the schema are sent
+// with full precision.
+
+class ObjectSchema {
+  using Properties = std::unordered_map<std::string_view, ValueEncoding>;
+
+  std::deque<std::string> names_{};
+  std::unordered_map<std::string_view, Properties> classes_{};
+
+public:
+  ObjectSchema() = default;
+  ObjectSchema(ObjectSchema&&) = default;
+  ObjectSchema& operator=(ObjectSchema&&) = default;
+
+  [[nodiscard]] bool empty() const { return classes_.empty(); }
+
+  void define(const char* objectClass, const char* propertyName, ValueEncoding encoding);
+  [[nodiscard]] const ValueEncoding* find(const char* objectClass, const char* propertyName) const;
+
+  [[nodiscard]] Value toValue() const;
+  [[nodiscard]] static ObjectSchema fromValue(const Value& value);
+
+  // the encodings declared the same way in both schemas
+  [[nodiscard]] ObjectSchema agree(const ObjectSchema& other) const;
+
+private:
+  std::string_view addName(const char* name);
+};
+
+
+#endif
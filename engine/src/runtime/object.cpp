@@ -20,7 +20,8 @@ MasterProperty& MasterInstance::getProperty(const Property& property) {
   auto& p = properties_[property.propertyName_];
   if (!p) {
     p = std::make_unique<MasterProperty>(property.propertyName_);
-    p->buffer_ = property.buffer_;
+    p->value_ = property.value3_;
+    p->assigned_ = property.buffer_ || property.value3_.is_inline();
   }
   return *p;
 }
@@ -41,6 +42,7 @@ Property& ObjectInstance::getProperty(const char* propertyName) {
   if (!p) {
     p = std::make_unique<Property>(this, propertyName);
     synchronize_ = true;
+    ownershipPending_ = true;
   }
   return *p;
 }
@@ -53,6 +55,7 @@ Property& ObjectInstance::getProperty(const std::string& propertyName) {
   if (!p) {
     p = std::make_unique<Property>(this, propertyName);
     synchronize_ = true;
+    ownershipPending_ = true;
 
   }
   return *p;
@@ -91,7 +94,7 @@ void ObjectRef::Delete() {
     if (!instance_->deletedByObject_ && !instance_->deletedByMaster_) {
       std::lock_guard federate_lock{instance_->objectClass_->federate_->mutex_};
       instance_->deletedByObject_ = true;
-      instance_->objectClass_->federate_->tryScheduleImmediateSynchronize_unsafe();
+      instance_->objectClass_->federate_->tryScheduleImmediateSynchronize_safe();
     }
   }
 }
@@ -183,8 +186,9 @@ void Property::modifyOwnershipState(OwnershipOperation operation) {
       instanceOwnership_.first.str().c_str(),
       str(instanceOwnership_.second));
   updateOwnershipState(instanceOwnership_, operation);
+  objectInstance_->ownershipPending_ = true;
   objectInstance_->synchronize_ = true;
-  objectInstance_->objectClass_->federate_->tryScheduleImmediateSynchronize_unsafe();
+  objectInstance_->objectClass_->federate_->tryScheduleImmediateSynchronize_safe();
 }
 
 
@@ -197,11 +201,8 @@ Property& Property::operator=(bool value) {
     return *this;
   processId_ = objectInstance_->processId_;
   session_ = nullptr;
-  prepareBuffer();
-  buffer_->add_byte(static_cast<unsigned char>(ValueType::_boolean));
-  buffer_->add_byte(0);
-  buffer_->add_byte(static_cast<unsigned char>(value ? 1 : 0));
-  prepareBufferDone(time, true);
+  char data = value ? 1 : 0;
+  assignInline(ValueType::_boolean, &data, 1, time);
   return *this;
 }
 
@@ -215,11 +216,8 @@ Property& Property::operator=(int value) {
     return *this;
   processId_ = objectInstance_->processId_;
   session_ = nullptr;
-  prepareBuffer();
-  buffer_->add_byte(static_cast<unsigned char>(ValueType::_int32));
-  buffer_->add_byte(0);
-  buffer_->add_int32(static_cast<std::int32_t>(value));
-  prepareBufferDone(time, true);
+  auto data = static_cast<std::int32_t>(value);
+  assignInline(ValueType::_int32, &data, 4, time);
   return *this;
 }
 
@@ -233,11 +231,7 @@ Property& Property::operator=(double value) {
     return *this;
   processId_ = objectInstance_->processId_;
   session_ = nullptr;
-  prepareBuffer();
-  buffer_->add_byte(static_cast<unsigned char>(ValueType::_double));
-  buffer_->add_byte(0);
-  buffer_->add_double(value);
-  prepareBufferDone(time, true);
+  assignInline(ValueType::_double, &value, 8, time);
   return *this;
 }
 
@@ -292,16 +286,11 @@ Property& Property::operator=(ObjectId value) {
     return *this;
   processId_ = objectInstance_->processId_;
   session_ = nullptr;
-  prepareBuffer();
   if (value) {
-    buffer_->add_byte(static_cast<unsigned char>(ValueType::_ObjectId));
-    buffer_->add_byte(0);
-    buffer_->add_binary(value.data(), value.size());
+    assignInline(ValueType::_ObjectId, value.data(), value.size(), time);
   } else {
-    buffer_->add_byte(static_cast<unsigned char>(ValueType::_null));
-    buffer_->add_byte(0);
+    assignInline(ValueType::_null, nullptr, 0, time);
   }
-  prepareBufferDone(time, true);
   return *this;
 }
 
@@ -336,15 +325,20 @@ void Property::assertCanSetValue() {
 
 
 void Property::assign(const MasterProperty& other) {
-  LOG_ASSERT(other.buffer_);
+  LOG_ASSERT(other.hasValue());
   processId_ = other.processId_;
   session_ = other.session_;
-  prepareBuffer();
-  buffer_->value_.append(reinterpret_cast<const char*>(other.buffer_->data()), other.buffer_->size());
 
   double time = other.time_ + objectInstance_->objectClass_->federate_->currentTime_;
 
-  prepareBufferDone(std::max(time2_, time), false);
+  auto element = other.value_.element();
+  if (element.size <= Value::InlineSize) {
+    prepareValueDone(Value::make_element(element.data, element.size), std::max(time2_, time), false);
+  } else {
+    prepareBuffer();
+    buffer_->value_.append(reinterpret_cast<const char*>(element.data), element.size);
+    prepareBufferDone(std::max(time2_, time), false);
+  }
   version3_ = other.version_;
 }
 
@@ -352,14 +346,34 @@ void Property::assign(const MasterProperty& other) {
 void Property::prepareBuffer() {
   LOG_ASSERT(objectInstance_->objectClass_->federate_->isFederateStrandCurrent());
 
-  if (buffer_ && buffer_.unique())
+  if (buffer_ && buffer_.unique()) {
     buffer_->value_.resize(0);
-  else
+    buffer_->clear_field_index();
+  } else {
     buffer_ = std::make_shared<ValueBuffer>();
+  }
 }
 
 
 void Property::prepareBufferDone(double time, bool synchronize) {
+  auto ptr = buffer_->value_.data();
+  auto end = ptr + buffer_->value_.size();
+  prepareValueDone(Value{buffer_, ptr, end}, time, synchronize);
+}
+
+
+void Property::assignInline(ValueType type, const void* data, std::size_t size, double time) {
+  char element[Value::InlineSize];
+  element[0] = static_cast<char>(type);
+  element[1] = 0;
+  if (size) {
+    std::memcpy(element + 2, data, size);
+  }
+  prepareValueDone(Value::make_element(element, size + 2), time, true);
+}
+
+
+void Property::prepareValueDone(Value value, double time, bool synchronize) {
   if (objectInstance_->objectClass_->federate_->currentTime_ >= time2_) {
     time1_ = time2_;
     time2_ = time3_;
@@ -369,9 +383,7 @@ void Property::prepareBufferDone(double time, bool synchronize) {
     version2_ = version3_;
   }
 
-  auto ptr = buffer_->value_.data();
-  auto end = ptr + buffer_->value_.size();
-  value3_ = Value{buffer_, ptr, end};
+  value3_ = std::move(value);
   time3_ = time;
 
   if (instanceOwnership_.first == OwnershipState{}) {
@@ -396,8 +408,7 @@ void Property::prepareBufferDone(double time, bool synchronize) {
   if (synchronize) {
     ++version3_;
     objectInstance_->synchronize_ = true;
-    std::lock_guard federate_lock{objectInstance_->objectClass_->federate_->mutex_};
-    objectInstance_->objectClass_->federate_->tryScheduleImmediateSynchronize_unsafe();
+    objectInstance_->objectClass_->federate_->scheduleSynchronize_strand();
   }
 }
 
@@ -405,15 +416,25 @@ void Property::prepareBufferDone(double time, bool synchronize) {
 void MasterProperty::assign(const Property& other) {
   processId_ = other.processId_;
   session_ = other.session_;
-  if (buffer_ && buffer_.unique())
-    buffer_->value_.resize(0);
-  else
-    buffer_ = std::make_shared<ValueBuffer>();
-  buffer_->value_.append(reinterpret_cast<const char*>(other.buffer_->data()), other.buffer_->size());
+  assigned_ = true;
 
-  auto ptr = buffer_->value_.data();
-  auto end = ptr + buffer_->value_.size();
-  value_ = Value{buffer_, ptr, end};
+  auto element = other.value3_.element();
+  value_ = Value{};
+  if (element.size <= Value::InlineSize) {
+    value_ = Value::make_element(element.data, element.size);
+  } else {
+    if (buffer_ && buffer_.unique()) {
+      buffer_->value_.resize(0);
+      buffer_->clear_field_index();
+    } else {
+      buffer_ = std::make_shared<ValueBuffer>();
+    }
+    buffer_->value_.append(reinterpret_cast<const char*>(element.data), element.size);
+
+    auto ptr = buffer_->value_.data();
+    auto end = ptr + buffer_->value_.size();
+    value_ = Value{buffer_, ptr, end};
+  }
   time_ = other.time3_ - other.objectInstance_->objectClass_->federate_->currentTime_;
   version_ = other.version3_;
 }
@@ -142,11 +142,14 @@ private:
   void assign(const MasterProperty& other);
   void prepareBuffer(); // AssertFederateStrand
   void prepareBufferDone(double time, bool synchronize);
+  void assignInline(ValueType type, const void* data, std::size_t size, double time);
+  void prepareValueDone(Value value, double time, bool synchronize);
 };
 
 struct MasterProperty {
   std::string propertyName_{};
   std::shared_ptr<ValueBuffer> buffer_{};
+  bool assigned_{};
   bool syncFlag_{};
 
   OwnershipMap ownershipMap_{};
@@ -160,6 +163,7 @@ struct MasterProperty {
   int version_{};
 
   explicit MasterProperty(std::string propertyName) : propertyName_{std::move(propertyName)} {}
+  [[nodiscard]] bool hasValue() const { return assigned_; }
   void assign(const Property& other);
 };
 
@@ -168,6 +172,7 @@ struct MasterInstance {
   ObjectId objectId_{};
   int refCount_{};
   bool deleted_{};
+  int ownershipVersion_{}; // incremented with the ownership version of any property
   std::string objectClassName_{};
 
   Dictionary<std::unique_ptr<MasterProperty>> properties_{};
@@ -184,6 +189,8 @@ struct ObjectInstance {
   MasterInstance* masterInstance_{};
   ObjectId objectId_{};
   bool spurious_{};
+  bool ownershipPending_{true};
+  int ownershipVersion_{};
 
   bool deletedByObject_{};
   bool deletedByMaster_{};
@@ -12,7 +12,13 @@
 class Federate;
 class Property;
 
+#ifndef ENABLE_OWNERSHIP_VALIDATION
+#ifdef NDEBUG
+#define ENABLE_OWNERSHIP_VALIDATION 0
+#else
 #define ENABLE_OWNERSHIP_VALIDATION 1
+#endif
+#endif
 
 
 enum class OwnershipNotification {
@@ -0,0 +1,150 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime-fixture.h"
+#include "runtime/session.h"
+#include "runtime/session-federate.h"
+
+namespace {
+    ObjectId create_foo(RemoteFixture& f, int bar) {
+        ObjectId result{};
+        f.strand->execute([&]() {
+            auto foo = f.federate1->getObjectClass("Foo").create();
+            foo["bar"] = bar;
+            result = foo.getObjectId();
+        });
+        f.strand->runUntilDone();
+        return result;
+    }
+
+    void update_foo(RemoteFixture& f, ObjectId fooId, int bar) {
+        f.strand->execute([&]() {
+            f.federate1->getObject(fooId)["bar"] = bar;
+        });
+        f.strand->runUntilDone();
+    }
+
+    int get_foo(RemoteFixture& f, ObjectId fooId) {
+        int result{};
+        f.strand->execute([&]() {
+            result = f.federate2->getObject(fooId)["bar"_int];
+        });
+        return result;
+    }
+
+    SessionCounters get_counters(RemoteFixture& f) {
+        SessionCounters result{};
+        f.strand->execute([&]() {
+            result = f.endpoint1->getCounters_strand();
+        });
+        return result;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(runtime_backpressure)
+
+    BOOST_AUTO_TEST_CASE(should_not_defer_updates_within_budget) {
+        RemoteFixture f{};
+        f.endpoint1->setOutgoingByteBudget(1024 * 1024);
+        auto fooId = create_foo(f, 1);
+        f.endpoint1->pause();
+        update_foo(f, fooId, 2);
+        update_foo(f, fooId, 3);
+
+        auto counters = get_counters(f);
+        BOOST_CHECK_EQUAL(0u, counters.outgoingQueueFull);
+        BOOST_CHECK_EQUAL(0u, counters.deferredUpdates);
+
+        f.endpoint1->resume();
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(3, get_foo(f, fooId));
+    }
+
+    BOOST_AUTO_TEST_CASE(should_coalesce_updates_past_budget) {
+        std::vector<int> received{};
+        RemoteFixture f{};
+        f.endpoint1->setOutgoingByteBudget(1);
+        f.strand->execute([&]() {
+            f.federate2->getObjectClass("Foo").observe([&received](ObjectRef foo) {
+                if (!foo.justDestroyed()) {
+                    received.push_back(foo["bar"_int]);
+                }
+            });
+        });
+        auto fooId = create_foo(f, 1);
+        f.endpoint1->pause();
+        f.strand->runUntilDone();
+
+        update_foo(f, fooId, 2); // sent, and held as a pending write
+        update_foo(f, fooId, 3); // held back, the queue is over the budget
+        update_foo(f, fooId, 4); // replaces 3
+        BOOST_CHECK_EQUAL(1, get_foo(f, fooId));
+
+        auto counters = get_counters(f);
+        BOOST_CHECK_EQUAL(1u, counters.outgoingQueueFull);
+        BOOST_CHECK_EQUAL(2u, counters.deferredUpdates);
+        BOOST_CHECK_EQUAL(1u, counters.coalescedUpdates);
+
+        f.endpoint1->resume();
+        f.strand->runUntilDone();
+        // the pending write with 2 is sent before the held back update
+        BOOST_CHECK_EQUAL(4, get_foo(f, fooId));
+        BOOST_CHECK(std::find(received.begin(), received.end(), 3) == received.end());
+        BOOST_CHECK_EQUAL(4, received.back());
+    }
+
+    BOOST_AUTO_TEST_CASE(should_send_deferred_updates_when_drained) {
+        RemoteFixture f{};
+        f.endpoint1->setOutgoingByteBudget(1);
+        std::vector<ObjectId> fooIds{};
+        for (int i = 0; i != 3; ++i) {
+            fooIds.push_back(create_foo(f, 0));
+        }
+        f.endpoint1->pause();
+        f.strand->runUntilDone();
+
+        for (int round = 1; round <= 3; ++round) {
+            for (int i = 0; i != 3; ++i) {
+                update_foo(f, fooIds[i], 10 * round + i);
+            }
+        }
+
+        f.endpoint1->resume();
+        f.strand->runUntilDone();
+        for (int i = 0; i != 3; ++i) {
+            BOOST_CHECK_EQUAL(30 + i, get_foo(f, fooIds[i]));
+        }
+
+        // the queue is no longer full, so updates are sent again
+        update_foo(f, fooIds[0], 40);
+        BOOST_CHECK_EQUAL(40, get_foo(f, fooIds[0]));
+        BOOST_CHECK_EQUAL(1u, get_counters(f).outgoingQueueFull);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_drain_after_federation_left) {
+        RemoteFixture f{};
+        f.endpoint1->setOutgoingByteBudget(1);
+        auto fooId = create_foo(f, 1);
+        f.endpoint1->pause();
+        f.strand->runUntilDone();
+
+        update_foo(f, fooId, 2);
+        update_foo(f, fooId, 3);
+        BOOST_CHECK_EQUAL(1u, get_counters(f).outgoingQueueFull);
+
+        // leaves the federation, the session keeps a null federate for it
+        std::shared_ptr<Federate> federate{};
+        f.strand->execute([&]() {
+            auto session = f.runtime1->getProcessSession_safe(f.runtime2->getProcessId());
+            federate = session->getSessionFederate_safe(f.federationId)->shared_from_this();
+            federate->shutdown().done();
+        });
+        f.strand->runUntilDone();
+
+        f.endpoint1->resume();
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(1u, get_counters(f).outgoingQueueFull);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,108 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime-fixture.h"
+
+namespace {
+    // two federations over one session, each runtime first hosting a
+    // federation of its own, so that the two sides of the session assign
+    // opposite handles to the federations
+    struct HandlesFixture : public RemoteFixture {
+        static inline const ObjectId federationIdB = ObjectId::parse("9988776655443322110099887766");
+        std::shared_ptr<Federate>& federate1A = federate1;
+        std::shared_ptr<Federate>& federate2B = federate2;
+        std::shared_ptr<Federate> federate1B;
+        std::shared_ptr<Federate> federate2A;
+        HandlesFixture() : RemoteFixture{ProcessType::Daemon, nullptr, federationIdB} {
+            strand->runUntilDone();
+            federate1B = startFederate(*runtime1, "Federate1B", federationIdB);
+            federate2A = startFederate(*runtime2, "Federate2A", federationId);
+            strand->runUntilDone();
+        }
+    };
+
+    void create_foo(Federate& federate, int bar) {
+        auto foo = federate.getObjectClass("Foo").create();
+        foo["bar"] = bar;
+    }
+
+    int find_foo(Federate& federate) {
+        auto foo = federate.getObjectClass("Foo").find([](auto) { return true; });
+        return foo ? foo["bar"_int] : 0;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(runtime_federation_handles)
+
+    BOOST_AUTO_TEST_CASE(should_send_object_changes_to_the_same_federation) {
+        HandlesFixture f{};
+        f.strand->execute([&]() {
+            create_foo(*f.federate1A, 1);
+            create_foo(*f.federate2B, 2);
+        });
+        f.strand->runUntilDone();
+
+        f.strand->execute([&]() {
+            BOOST_CHECK_EQUAL(1, count_objects(f.federate2A->getObjectClass("Foo")));
+            BOOST_CHECK_EQUAL(1, find_foo(*f.federate2A));
+            BOOST_CHECK_EQUAL(1, count_objects(f.federate1B->getObjectClass("Foo")));
+            BOOST_CHECK_EQUAL(2, find_foo(*f.federate1B));
+        });
+    }
+
+    BOOST_AUTO_TEST_CASE(should_send_events_to_the_same_federation) {
+        HandlesFixture f{};
+        std::vector<std::string> received{};
+        f.strand->execute([&]() {
+            f.federate1A->getEventClass("Ping").subscribe([&received](const Value& value) {
+                received.push_back(makeString("A%d", value["n"_int]));
+            });
+            f.federate1B->getEventClass("Ping").subscribe([&received](const Value& value) {
+                received.push_back(makeString("B%d", value["n"_int]));
+            });
+        });
+        f.strand->runUntilDone();
+
+        f.strand->execute([&]() {
+            f.federate2A->getEventClass("Ping").dispatch(Struct{} << "n" << 1 << ValueEnd{});
+            f.federate2B->getEventClass("Ping").dispatch(Struct{} << "n" << 2 << ValueEnd{});
+        });
+        f.strand->runUntilDone();
+
+        BOOST_REQUIRE_EQUAL(2, received.size());
+        BOOST_CHECK(std::find(received.begin(), received.end(), "A1") != received.end());
+        BOOST_CHECK(std::find(received.begin(), received.end(), "B2") != received.end());
+    }
+
+    BOOST_AUTO_TEST_CASE(should_send_ownership_changes_to_the_same_federation) {
+        HandlesFixture f{};
+        f.strand->execute([&]() {
+            create_foo(*f.federate1A, 1);
+            create_foo(*f.federate1B, 1);
+        });
+        f.strand->runUntilDone();
+
+        f.strand->execute([&]() {
+            auto foo = *f.federate2A->getObjectClass("Foo").begin();
+            foo["bar"].modifyOwnershipState(OwnershipOperation::Publish);
+            foo["bar"].modifyOwnershipState(OwnershipOperation::ForcedOwnershipAcquisition);
+        });
+        f.strand->runUntilDone();
+
+        f.strand->execute([&]() {
+            auto foo = *f.federate2A->getObjectClass("Foo").begin();
+            BOOST_CHECK(foo["bar"].getOwnershipState() & OwnershipStateFlag::Owned);
+            foo["bar"] = 2;
+        });
+        f.strand->runUntilDone();
+
+        f.strand->execute([&]() {
+            BOOST_CHECK((*f.federate1A->getObjectClass("Foo").begin())["bar"].getOwnershipState() & OwnershipStateFlag::Unowned);
+            BOOST_CHECK_EQUAL(2, find_foo(*f.federate1A));
+            BOOST_CHECK((*f.federate1B->getObjectClass("Foo").begin())["bar"].getOwnershipState() & OwnershipStateFlag::Owned);
+            BOOST_CHECK_EQUAL(1, find_foo(*f.federate1B));
+        });
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
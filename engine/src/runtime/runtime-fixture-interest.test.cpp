@@ -0,0 +1,167 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime-fixture.h"
+#include "runtime/interest-policy.h"
+#include "runtime/session-federate.h"
+#include <thread>
+
+namespace {
+    class TestInterestPolicy : public InterestPolicy {
+    public:
+        [[nodiscard]] std::optional<glm::vec2> getCameraPosition(ObjectRef object) const override {
+            if (object.getObjectClass() != "_View") {
+                return std::nullopt;
+            }
+            return object["position"_vec2];
+        }
+
+        void updateInterest(SessionInterest& interest, ObjectRef object, const std::string& subjectId) const override {
+            if (object.getObjectClass() == "Owner" && subjectId == object["playerId"_c_str]) {
+                interest.objectIds = {object.getObjectId()};
+            }
+        }
+
+        [[nodiscard]] bool shouldFilterObject(ObjectRef object) const override {
+            return object.getObjectClass() == "Item";
+        }
+
+        [[nodiscard]] bool isWithinInterest(const SessionInterest& interest, ObjectRef object) const override {
+            auto owner = object["owner"_ObjectId];
+            if (owner && std::find(interest.objectIds.begin(), interest.objectIds.end(), owner) != interest.objectIds.end()) {
+                return true;
+            }
+            return glm::distance(object["position"_vec2], interest.cameraPosition) <= 100.0f;
+        }
+
+        [[nodiscard]] bool isLowPriority(const Property& property) const override {
+            return property.getName() == "detail";
+        }
+    };
+
+    const TestInterestPolicy interestPolicy{};
+
+    // federate1 is a player's, federate2 is the daemon's
+    struct InterestFixture : public RemoteFixture {
+        InterestFixture() : RemoteFixture{ProcessType::Player, &interestPolicy} {
+            runtime1->registerProcessAuth_safe(runtime1->getProcessId(), ProcessAuth{"player1"});
+        }
+        void setView(glm::vec2 position) {
+            strand->execute([&]() {
+                auto view = federate1->getObjectClass("_View").find([](auto) { return true; });
+                if (!view) {
+                    view = federate1->getObjectClass("_View").create();
+                }
+                view["position"] = position;
+            });
+            strand->runUntilDone();
+        }
+        ObjectId createItem(glm::vec2 position, ObjectId owner = {}) {
+            ObjectId result{};
+            strand->execute([&]() {
+                auto item = federate2->getObjectClass("Item").create();
+                item["position"] = position;
+                item["owner"] = owner;
+                item["value"] = 1;
+                item["detail"] = 1;
+                result = item.getObjectId();
+            });
+            strand->runUntilDone();
+            return result;
+        }
+        void updateItem(ObjectId itemId, int value, int detail) {
+            strand->execute([&]() {
+                auto item = federate2->getObject(itemId);
+                item["value"] = value;
+                item["detail"] = detail;
+            });
+            strand->runUntilDone();
+        }
+        std::pair<int, int> getItem(ObjectId itemId) {
+            std::pair<int, int> result{};
+            strand->execute([&]() {
+                if (auto item = federate1->getObject(itemId)) {
+                    result = {item["value"_int], item["detail"_int]};
+                }
+            });
+            return result;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(runtime_interest)
+
+    BOOST_AUTO_TEST_CASE(should_send_objects_within_interest) {
+        InterestFixture f{};
+        f.setView({0.0f, 0.0f});
+        auto itemId = f.createItem({10.0f, 0.0f});
+        f.updateItem(itemId, 2, 2);
+        BOOST_CHECK((f.getItem(itemId) == std::pair{2, 2}));
+        f.updateItem(itemId, 3, 3);
+        BOOST_CHECK((f.getItem(itemId) == std::pair{3, 3}));
+    }
+
+    BOOST_AUTO_TEST_CASE(should_defer_objects_outside_interest) {
+        InterestFixture f{};
+        f.setView({0.0f, 0.0f});
+        auto itemId = f.createItem({1000.0f, 0.0f});
+        BOOST_CHECK((f.getItem(itemId) == std::pair{1, 1}));
+
+        // held back until the update interval has passed
+        f.updateItem(itemId, 2, 2);
+        f.updateItem(itemId, 3, 3);
+        BOOST_CHECK((f.getItem(itemId) == std::pair{1, 1}));
+
+        // sent with latest values, without low priority properties
+        std::this_thread::sleep_for(SessionFederate::DeferredUpdateInterval + std::chrono::milliseconds{50});
+        f.strand->run();
+        f.strand->runUntilDone();
+        BOOST_CHECK((f.getItem(itemId) == std::pair{3, 1}));
+
+        // sent with all properties when within interest
+        f.updateItem(itemId, 4, 4);
+        f.setView({1000.0f, 0.0f});
+        BOOST_CHECK((f.getItem(itemId) == std::pair{4, 4}));
+    }
+
+    BOOST_AUTO_TEST_CASE(should_send_own_objects_outside_interest) {
+        InterestFixture f{};
+        f.setView({0.0f, 0.0f});
+        ObjectId ownerId{};
+        ObjectId otherId{};
+        f.strand->execute([&]() {
+            auto owner = f.federate2->getObjectClass("Owner").create();
+            owner["playerId"] = "player1";
+            ownerId = owner.getObjectId();
+            auto other = f.federate2->getObjectClass("Owner").create();
+            other["playerId"] = "player2";
+            otherId = other.getObjectId();
+        });
+        f.strand->runUntilDone();
+
+        auto ownItemId = f.createItem({1000.0f, 0.0f}, ownerId);
+        auto otherItemId = f.createItem({1000.0f, 0.0f}, otherId);
+        f.updateItem(ownItemId, 2, 2);
+        f.updateItem(otherItemId, 2, 2);
+        BOOST_CHECK((f.getItem(ownItemId) == std::pair{2, 2}));
+        BOOST_CHECK((f.getItem(otherItemId) == std::pair{1, 1}));
+    }
+
+    BOOST_AUTO_TEST_CASE(should_forget_deferred_changes_of_deleted_objects) {
+        InterestFixture f{};
+        f.setView({0.0f, 0.0f});
+        auto itemId = f.createItem({1000.0f, 0.0f});
+        f.updateItem(itemId, 2, 2);
+        f.updateItem(itemId, 3, 3);
+        f.strand->execute([&]() {
+            f.federate2->getObject(itemId).Delete();
+        });
+        f.strand->runUntilDone();
+        f.setView({1000.0f, 0.0f});
+        f.strand->execute([&]() {
+            BOOST_CHECK_EQUAL(0, count_objects(f.federate1->getObjectClass("Item")));
+        });
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
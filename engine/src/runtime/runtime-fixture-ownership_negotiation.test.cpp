@@ -96,6 +96,39 @@ namespace {
                 object2["bar"].getOwnershipState());
         });
     }
+
+    void test_acquisition_after_uncontended_updates(RuntimeFixture& f) {
+        f.strand->execute([&]() {
+            auto object = f.federate1->getObjectClass("Foo").create();
+            object["bar"] = 0;
+        });
+        f.strand->runUntilDone();
+        for (int i = 1; i <= 5; ++i) {
+            f.strand->execute([&, i]() {
+                auto object1 = *f.federate1->getObjectClass("Foo").begin();
+                object1["bar"] = i;
+            });
+            f.strand->runUntilDone();
+        }
+        f.strand->execute([&]() {
+            auto object2 = *f.federate2->getObjectClass("Foo").begin();
+            BOOST_CHECK_EQUAL(5, object2["bar"_int]);
+            object2["bar"].modifyOwnershipState(OwnershipOperation::Publish);
+            object2["bar"].modifyOwnershipState(OwnershipOperation::OwnershipAcquisition);
+        });
+        f.strand->runUntilDone();
+        f.strand->execute([&]() {
+            auto object2 = *f.federate2->getObjectClass("Foo").begin();
+            BOOST_CHECK(object2["bar"].getOwnershipState() & OwnershipStateFlag::Owned);
+            object2["bar"] = 99;
+        });
+        f.strand->runUntilDone();
+        f.strand->execute([&]() {
+            auto object1 = *f.federate1->getObjectClass("Foo").begin();
+            BOOST_CHECK(object1["bar"].getOwnershipState() & OwnershipStateFlag::Unowned);
+            BOOST_CHECK_EQUAL(99, object1["bar"_int]);
+        });
+    }
 }
 
 BOOST_AUTO_TEST_SUITE(runtime_ownership_negotiation)
@@ -115,4 +148,14 @@ BOOST_AUTO_TEST_SUITE(runtime_ownership_negotiation)
         test_ownership_negotiation(f);
     }
 
+    BOOST_AUTO_TEST_CASE(should_acquire_after_uncontended_updates_local) {
+        LocalFixture f{};
+        test_acquisition_after_uncontended_updates(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_acquire_after_uncontended_updates_remote) {
+        RemoteFixture f{};
+        test_acquisition_after_uncontended_updates(f);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime-fixture.h"
+#include <thread>
+
+namespace {
+    void should_fulfill_many_service_requests(RuntimeFixture& f) {
+        f.strand->execute([&]() {
+            f.federate2->getServiceClass("Double").define([](const Value& params) {
+                return resolve(Struct{} << "x" << 2 * params["x"_int] << ValueEnd{});
+            });
+        });
+        f.strand->runUntilDone();
+
+        int sum = 0;
+        f.strand->execute([&]() {
+            for (int i = 1; i <= 20; ++i) {
+                f.federate1->requestService("Double", Struct{} << "x" << i << ValueEnd{}, "", f.federate1.get())
+                    .then<void>([&sum](const Value& value) {
+                        sum += value["x"_int];
+                    }).done();
+            }
+        });
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(20 * 21, sum);
+    }
+
+    void should_fulfill_service_requests_out_of_order(RuntimeFixture& f) {
+        std::vector<Promise<Value>> pending{};
+        f.strand->execute([&]() {
+            f.federate2->getServiceClass("Later").define([&pending](const Value& params) {
+                pending.emplace_back();
+                return pending.back();
+            });
+        });
+        f.strand->runUntilDone();
+
+        std::vector<int> results{};
+        f.strand->execute([&]() {
+            for (int i = 0; i != 3; ++i) {
+                f.federate1->requestService("Later", Value{}, "", f.federate1.get())
+                    .then<void>([&results, i](const Value& value) {
+                        results.push_back(i * 10 + value["x"_int]);
+                    }).done();
+            }
+        });
+        f.strand->runUntilDone();
+        BOOST_REQUIRE_EQUAL(3, pending.size());
+
+        f.strand->execute([&]() {
+            pending[1].resolve(Struct{} << "x" << 1 << ValueEnd{}).done();
+            pending[2].resolve(Struct{} << "x" << 2 << ValueEnd{}).done();
+        });
+        f.strand->runUntilDone();
+        f.strand->execute([&]() {
+            pending[0].resolve(Struct{} << "x" << 0 << ValueEnd{}).done();
+        });
+        f.strand->runUntilDone();
+        BOOST_CHECK((results == std::vector<int>{11, 22, 0}));
+    }
+
+    // requests that never get a response, so they stay pending
+    void define_unresponsive_service(RuntimeFixture& f, std::vector<Promise<Value>>& pending) {
+        f.strand->execute([&]() {
+            f.federate2->getServiceClass("Never").define([&pending](const Value& params) {
+                pending.emplace_back();
+                return pending.back();
+            });
+        });
+        f.strand->runUntilDone();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(runtime_service)
+
+    BOOST_AUTO_TEST_CASE(should_fulfill_many_service_requests_local) {
+        LocalFixture f{};
+        should_fulfill_many_service_requests(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_fulfill_many_service_requests_remote) {
+        RemoteFixture f{};
+        should_fulfill_many_service_requests(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_fulfill_many_service_requests_relay) {
+        RelayFixture f{};
+        should_fulfill_many_service_requests(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_fulfill_service_requests_out_of_order_remote) {
+        RemoteFixture f{};
+        should_fulfill_service_requests_out_of_order(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_reject_timed_out_service_requests_remote) {
+        RemoteFixture f{};
+        f.endpoint1->setServiceRequestTimeout(std::chrono::milliseconds{1});
+        f.endpoint2->setServiceRequestTimeout(std::chrono::milliseconds{1});
+        std::vector<Promise<Value>> pending{};
+        define_unresponsive_service(f, pending);
+
+        int rejected = 0;
+        f.strand->execute([&]() {
+            f.federate1->requestService("Never", Value{}, "", f.federate1.get())
+                .then<void>([](const Value&) {}, [&rejected](const std::exception_ptr&) {
+                    ++rejected;
+                }).done();
+        });
+        f.strand->runUntilDone();
+        BOOST_REQUIRE_EQUAL(1, pending.size());
+        BOOST_CHECK_EQUAL(0, rejected);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{150});
+        f.strand->run(); // runs the heartbeat interval
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(1, rejected);
+
+        f.strand->execute([&]() {
+            pending[0].resolve(Value{}).done(); // a late fulfill is ignored
+        });
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(1, rejected);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_reject_pending_service_requests_on_shutdown_remote) {
+        RemoteFixture f{};
+        std::vector<Promise<Value>> pending{};
+        define_unresponsive_service(f, pending);
+
+        int fulfilled = 0;
+        int rejected = 0;
+        f.strand->execute([&]() {
+            for (int i = 0; i != 3; ++i) {
+                f.federate1->requestService("Never", Value{}, "", f.federate1.get())
+                    .then<void>([&fulfilled](const Value&) {
+                        ++fulfilled;
+                    }, [&rejected](const std::exception_ptr&) {
+                        ++rejected;
+                    }).done();
+            }
+        });
+        f.strand->runUntilDone();
+        BOOST_REQUIRE_EQUAL(3, pending.size());
+
+        f.strand->execute([&]() {
+            pending[2].resolve(Value{}).done();
+        });
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(1, fulfilled);
+
+        f.endpoint1->shutdown().done();
+        f.strand->runUntilDone();
+        BOOST_CHECK_EQUAL(1, fulfilled);
+        BOOST_CHECK_EQUAL(2, rejected);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,6 +23,44 @@ namespace {
             BOOST_CHECK_EQUAL(62, foo["nope"_int]);
         });
     }
+
+    void should_synchronize_batched_changes(RuntimeFixture& f) {
+        f.strand->execute([&]() {
+            Federate::BatchScope batch{*f.federate1};
+            auto foo = f.federate1->getObjectClass("Foo").create();
+            foo["bar"] = 47;
+            {
+                Federate::BatchScope nested{*f.federate1};
+                foo["baz"] = 11.5;
+            }
+            foo["bar"] = 48;
+        });
+        f.strand->runUntilDone();
+        f.strand->execute([&]() {
+            BOOST_CHECK_EQUAL(1, count_objects(f.federate2->getObjectClass("Foo")));
+            auto foo = f.federate2->getObjectClass("Foo").find([](auto) { return true; });
+            BOOST_CHECK_EQUAL(48, foo["bar"_int]);
+            BOOST_CHECK_EQUAL(11.5, foo["baz"_double]);
+        });
+    }
+
+    void should_synchronize_many_new_objects(RuntimeFixture& f) {
+        f.strand->execute([&]() {
+            for (int i = 0; i < 40; ++i) {
+                auto foo = f.federate1->getObjectClass("Foo").create();
+                foo["bar"] = i;
+            }
+        });
+        f.strand->runUntilDone();
+        f.strand->execute([&]() {
+            BOOST_CHECK_EQUAL(40, count_objects(f.federate2->getObjectClass("Foo")));
+            int sum = 0;
+            for (auto foo : f.federate2->getObjectClass("Foo")) {
+                sum += foo["bar"_int];
+            }
+            BOOST_CHECK_EQUAL(40 * 39 / 2, sum);
+        });
+    }
 }
 
 BOOST_AUTO_TEST_SUITE(runtime_sync_object)
@@ -42,4 +80,24 @@ BOOST_AUTO_TEST_SUITE(runtime_sync_object)
         should_synchronize_new_objects(f);
     }
 
+    BOOST_AUTO_TEST_CASE(should_synchronize_batched_changes_local) {
+        LocalFixture f{};
+        should_synchronize_batched_changes(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_synchronize_batched_changes_remote) {
+        RemoteFixture f{};
+        should_synchronize_batched_changes(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_synchronize_many_new_objects_remote) {
+        RemoteFixture f{};
+        should_synchronize_many_new_objects(f);
+    }
+
+    BOOST_AUTO_TEST_CASE(should_synchronize_many_new_objects_relay) {
+        RelayFixture f{};
+        should_synchronize_many_new_objects(f);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -45,30 +45,39 @@ namespace {
         std::unique_ptr <Runtime> runtime2;
         std::shared_ptr <MockEndpoint> endpoint1;
         std::shared_ptr <MockEndpoint> endpoint2;
-        RemoteFixture() {
+        std::vector<std::shared_ptr<Federate>> federates;
+        // runtime2 is the master daemon; federate2 joins federationId2
+        // instead of federationId when one is given
+        explicit RemoteFixture(ProcessType processType1 = ProcessType::Daemon, const InterestPolicy* interestPolicy = nullptr, ObjectId federationId2 = {}) {
             strand = std::make_shared<Strand_Manual>();
             PromiseUtils::strand_ = strand;
-            runtime1 = std::make_unique<Runtime>(ProcessType::Daemon);
+            runtime1 = std::make_unique<Runtime>(processType1);
             runtime2 = std::make_unique<Runtime>(ProcessType::Daemon);
+            runtime1->setInterestPolicy(interestPolicy);
+            runtime2->setInterestPolicy(interestPolicy);
             endpoint1 = std::make_shared<MockEndpoint>(*runtime1, strand);
             endpoint2 = std::make_shared<MockEndpoint>(*runtime2, strand);
             endpoint1->setMasterEndpoint(*endpoint2);
-            runtime1->initiateFederation_safe(federationId, FederationType::Battle);
-            runtime2->initiateFederation_safe(federationId, FederationType::Battle);
-            federate1 = std::make_shared<Federate>(*runtime1, "Federate1", strand);
-            federate2 = std::make_shared<Federate>(*runtime2, "Federate2", strand);
-            federate1->startup(federationId);
-            federate2->startup(federationId);
+            federate1 = startFederate(*runtime1, "Federate1", federationId);
+            federate2 = startFederate(*runtime2, "Federate2", federationId2 ? federationId2 : federationId);
         }
         ~RemoteFixture() {
-            federate1->shutdown().done();
-            federate2->shutdown().done();
+            for (auto& federate : federates) {
+                federate->shutdown().done();
+            }
             endpoint1->shutdown().done();
             endpoint2->shutdown().done();
             runtime1->shutdown().done();
             runtime2->shutdown().done();
             strand->runUntilDone();
         }
+        std::shared_ptr<Federate> startFederate(Runtime& runtime, const char* federateName, ObjectId id) {
+            runtime.initiateFederation_safe(id, FederationType::Battle);
+            auto federate = std::make_shared<Federate>(runtime, federateName, strand);
+            federate->startup(id);
+            federates.push_back(federate);
+            return federate;
+        }
         void disconnect() override {
             endpoint2->disconnect();
         }
@@ -0,0 +1,141 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime/runtime.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+    struct RegistryFixture {
+        std::shared_ptr<Strand_Manual> strand;
+        std::unique_ptr<Runtime> runtime1;
+        std::unique_ptr<Runtime> runtime2;
+        RegistryFixture() {
+            strand = std::make_shared<Strand_Manual>();
+            PromiseUtils::strand_ = strand;
+            runtime1 = std::make_unique<Runtime>(ProcessType::Daemon);
+            runtime2 = std::make_unique<Runtime>(ProcessType::Daemon);
+        }
+        ~RegistryFixture() {
+            runtime1->shutdown().done();
+            runtime2->shutdown().done();
+            strand->runUntilDone();
+        }
+    };
+
+    std::vector<ObjectId> create_process_ids(std::size_t count) {
+        std::vector<ObjectId> result{};
+        for (std::size_t i = 0; i != count; ++i) {
+            result.push_back(ObjectId::create());
+        }
+        return result;
+    }
+
+    // counts the registered processes, or returns -1 if a process was seen
+    // without all processes registered before it; the processes are read
+    // from the last, as the registry seen by a thread can only move forward
+    int count_registered(const Runtime& runtime, const std::vector<ObjectId>& processIds) {
+        int count = 0;
+        for (auto i = processIds.rbegin(); i != processIds.rend(); ++i) {
+            if (runtime.getProcessType_safe(*i) != ProcessType::None) {
+                ++count;
+            } else if (count != 0) {
+                return -1;
+            }
+        }
+        return count;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(runtime_registry)
+
+    BOOST_AUTO_TEST_CASE(should_read_registrations_from_many_threads) {
+        RegistryFixture f{};
+        auto processIds = create_process_ids(100);
+        std::atomic_bool registered{};
+        std::atomic_int errors{};
+        std::atomic_int incomplete{};
+
+        std::vector<std::thread> readers{};
+        for (int i = 0; i != 4; ++i) {
+            readers.emplace_back([&]() {
+                int last = 0;
+                while (!registered) {
+                    int count = count_registered(*f.runtime1, processIds);
+                    if (count < last) {
+                        ++errors;
+                    }
+                    last = count;
+                }
+                // a registry cached by this thread must not outlive the last registration
+                if (count_registered(*f.runtime1, processIds) != static_cast<int>(processIds.size())) {
+                    ++incomplete;
+                }
+            });
+        }
+
+        for (auto processId : processIds) {
+            f.runtime1->registerProcess_safe(processId, ProcessType::Player, nullptr);
+        }
+        registered = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        BOOST_CHECK_EQUAL(0, errors.load());
+        BOOST_CHECK_EQUAL(0, incomplete.load());
+    }
+
+    BOOST_AUTO_TEST_CASE(should_read_unregistrations_from_many_threads) {
+        RegistryFixture f{};
+        auto processIds = create_process_ids(16);
+        for (auto processId : processIds) {
+            f.runtime1->registerProcess_safe(processId, ProcessType::Player, nullptr);
+        }
+
+        std::atomic_bool unregistered{};
+        std::atomic_int remaining{};
+        std::vector<std::thread> readers{};
+        for (int i = 0; i != 4; ++i) {
+            readers.emplace_back([&]() {
+                while (!unregistered) {
+                    for (auto processId : processIds) {
+                        (void) f.runtime1->getProcessAuth_safe(processId);
+                    }
+                }
+                for (auto processId : processIds) {
+                    if (f.runtime1->getProcessType_safe(processId) != ProcessType::None) {
+                        ++remaining;
+                    }
+                }
+            });
+        }
+
+        for (auto processId : processIds) {
+            f.runtime1->registerProcessAuth_safe(processId, ProcessAuth{"subject"});
+            f.runtime1->unregisterProcess_safe(processId);
+        }
+        unregistered = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        BOOST_CHECK_EQUAL(0, remaining.load());
+    }
+
+    BOOST_AUTO_TEST_CASE(should_not_share_registries_between_runtimes) {
+        RegistryFixture f{};
+        auto processId = ObjectId::create();
+        f.runtime1->registerProcess_safe(processId, ProcessType::Player, nullptr);
+
+        BOOST_CHECK(f.runtime1->getProcessType_safe(processId) == ProcessType::Player);
+        BOOST_CHECK(f.runtime2->getProcessType_safe(processId) == ProcessType::None);
+
+        f.runtime2->registerProcess_safe(processId, ProcessType::Daemon, nullptr);
+        f.runtime1->unregisterProcess_safe(processId);
+        BOOST_CHECK(f.runtime1->getProcessType_safe(processId) == ProcessType::None);
+        BOOST_CHECK(f.runtime2->getProcessType_safe(processId) == ProcessType::Daemon);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
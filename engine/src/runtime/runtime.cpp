@@ -3,6 +3,7 @@
 
 #include "./endpoint.h"
 #include "./federation.h"
+#include "./metrics.h"
 #include "./runtime.h"
 #include "./session.h"
 #include "./session-federate.h"
@@ -13,6 +14,7 @@
 #define LOG_TRACE(format, ...)   LOG_X(format, ##__VA_ARGS__)
 
 static std::atomic_int debugCounter = 0;
+static std::atomic<std::uint64_t> lastRegistryVersion = 0;
 
 
 const char* str(ProcessType value) {
@@ -40,7 +42,10 @@ Runtime::Runtime(ProcessType processType, SupervisionPolicy* supervisionPolicy)
     processId_{ObjectId::create()},
     supervisionPolicy_{supervisionPolicy}
 {
-  processes_[processId_] = { processId_, processType_ };
+  auto registry = std::make_shared<Registry>();
+  registry->processes[processId_] = { processId_, processType_ };
+  registry_ = std::move(registry);
+  registryVersion_.store(++lastRegistryVersion, std::memory_order_release);
   LOG_LIFECYCLE("%p Runtime + %d %s", this, ++debugCounter, str(processType));
 }
 
@@ -48,6 +53,7 @@ Runtime::Runtime(ProcessType processType, SupervisionPolicy* supervisionPolicy)
 Runtime::~Runtime() {
   LOG_LIFECYCLE("%p Runtime ~ %d", this, --debugCounter);
   LOG_ASSERT(shutdownCompleted());
+  setMetrics(nullptr);
   std::lock_guard lock(mutex_);
   LOG_ASSERT(!endpoint_); // must destruct Endpoint before Runtime
   for (auto& federation : federations_) {
@@ -75,16 +81,33 @@ Promise<void> Runtime::shutdown_() {
 }
 
 
-std::vector<ProcessInfo> Runtime::addRuntimeObserver_safe(RuntimeObserver& observer) {
+/*
+ * Must be set before any sessions or federates are created,
+ * and cleared only after they have been shut down.
+ */
+void Runtime::setMetrics(Metrics* value) {
+  if (metrics_) {
+    metrics_->removeCollector(metricsCollectorId_);
+  }
+  metrics_ = value;
+  if (metrics_) {
+    metricsCollectorId_ = metrics_->addCollector([this](Metrics& metrics) {
+      collectMetrics_safe(metrics);
+    });
+  }
+}
+
+
+std::vector<ProcessInfo> Runtime::addRuntimeObserver_safe(RuntimeObserver& observer, std::shared_ptr<Strand_base> strand) {
   std::vector<ProcessInfo> result{};
   std::lock_guard lock{mutex_};
-  observers_.push_back(&observer);
-  for (const auto& i : federationIdProcessId_) {
-    auto federationId = i.first;
-    auto processId = i.second;
-    auto process = processes_.find(processId);
-    if (process != processes_.end()) {
-      result.emplace_back(ProcessInfo{process->second.type, process->second.id, federationId});
+  observers_.push_back({&observer, strand ? std::move(strand) : PromiseUtils::Strand()});
+  for (const auto& [federationId, processIds] : registry_->federationProcesses) {
+    for (auto processId : processIds) {
+      auto process = registry_->processes.find(processId);
+      if (process != registry_->processes.end()) {
+        result.emplace_back(ProcessInfo{process->second.type, process->second.id, federationId});
+      }
     }
   }
   return result;
@@ -94,80 +117,79 @@ std::vector<ProcessInfo> Runtime::addRuntimeObserver_safe(RuntimeObserver& obser
 void Runtime::removeRuntimeObserver_safe(RuntimeObserver& observer) {
   std::lock_guard lock{mutex_};
   observers_.erase(
-      std::remove(observers_.begin(), observers_.end(), &observer),
+      std::remove_if(observers_.begin(), observers_.end(), [&observer](const auto& x) {
+        return x.observer == &observer;
+      }),
       observers_.end());
 }
 
 bool Runtime::hasRuntimeObserver_safe(const RuntimeObserver& observer) const {
   std::lock_guard lock{mutex_};
-  auto i = std::find(observers_.begin(), observers_.end(), &observer);
-  return i != observers_.end();
+  return std::any_of(observers_.begin(), observers_.end(), [&observer](const auto& x) {
+    return x.observer == &observer;
+  });
 }
 
 ProcessType Runtime::getProcessType_safe(ObjectId processId) const {
-  std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId);
-  return i != processes_.end() ? i->second.type : ProcessType::None;
+  auto registry = getRegistry_safe();
+  auto i = registry->processes.find(processId);
+  return i != registry->processes.end() ? i->second.type : ProcessType::None;
 }
 
 
 ProcessAuth Runtime::getProcessAuth_safe(ObjectId processId) const {
-  std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId);
-  return i != processes_.end() ? i->second.auth : ProcessAuth{};
+  auto registry = getRegistry_safe();
+  auto i = registry->processes.find(processId);
+  return i != registry->processes.end() ? i->second.auth : ProcessAuth{};
 }
 
 
 ProcessAddr Runtime::getProcessAddr_safe() const {
-  std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId_);
-  return i != processes_.end() ? i->second.addr : ProcessAddr{};
+  auto registry = getRegistry_safe();
+  auto i = registry->processes.find(processId_);
+  return i != registry->processes.end() ? i->second.addr : ProcessAddr{};
 }
 
 
 std::string Runtime::getSubjectId_safe() const {
-  std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId_);
-  return i != processes_.end() ? i->second.auth.subjectId : std::string{};
-}
-
-
-Session* Runtime::getProcessSession(ObjectId processId) const {
-  auto i = processes_.find(processId);
-  return i != processes_.end() ? i->second.session : nullptr;
+  auto registry = getRegistry_safe();
+  auto i = registry->processes.find(processId_);
+  return i != registry->processes.end() ? i->second.auth.subjectId : std::string{};
 }
 
 
 Session* Runtime::getProcessSession_safe(ObjectId processId) const {
-  std::lock_guard lock{mutex_};
-  return getProcessSession(processId);
+  auto registry = getRegistry_safe();
+  auto i = registry->processes.find(processId);
+  return i != registry->processes.end() ? i->second.session : nullptr;
 }
 
 
 bool Runtime::registerProcess_safe(ObjectId processId, ProcessType processType, Session* session) {
   std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId);
-  if (i == processes_.end()) {
+  auto i = registry_->processes.find(processId);
+  if (i == registry_->processes.end()) {
     if (processType == ProcessType::None) {
       LOG_E("Runtime::RegisterProcess, missing type");
       return false;
     }
-    processes_[processId] = {processId, processType, session};
+    auto registry = copyRegistry_unsafe();
+    registry->processes[processId] = {processId, processType, session};
+    publishRegistry_unsafe(std::move(registry));
     return true;
   }
-  if (processType != ProcessType::None) {
-    if (processType != i->second.type) {
-      LOG_E("Runtime::RegisterProcess, mismatching type");
-      return false;
-    }
-    i->second.type = processType;
+  if (processType != ProcessType::None && processType != i->second.type) {
+    LOG_E("Runtime::RegisterProcess, mismatching type");
+    return false;
   }
-  if (session != nullptr) {
-    if (i->second.session != nullptr && session != i->second.session) {
+  if (session != nullptr && session != i->second.session) {
+    if (i->second.session != nullptr) {
       LOG_E("Runtime::RegisterProcess, mismatching session");
       return false;
     }
-    i->second.session = session;
+    auto registry = copyRegistry_unsafe();
+    registry->processes[processId].session = session;
+    publishRegistry_unsafe(std::move(registry));
   }
   return true;
 }
@@ -175,12 +197,13 @@ bool Runtime::registerProcess_safe(ObjectId processId, ProcessType processType,
 
 void Runtime::registerProcessAuth_safe(ObjectId processId, const ProcessAuth& processAuth) {
   std::unique_lock lock{mutex_};
-  auto i = processes_.find(processId);
-  if (i == processes_.end()) {
+  if (!registry_->processes.contains(processId)) {
     LOG_E("Runtime::RegisterProcess, invalid process");
     return;
   }
-  i->second.auth = processAuth;
+  auto registry = copyRegistry_unsafe();
+  registry->processes[processId].auth = processAuth;
+  publishRegistry_unsafe(std::move(registry));
   lock.unlock();
   notifyProcessAuth_safe(processId, processAuth);
 }
@@ -188,10 +211,10 @@ void Runtime::registerProcessAuth_safe(ObjectId processId, const ProcessAuth& pr
 
 void Runtime::notifyProcessAuth_safe(ObjectId processId, const ProcessAuth& processAuth) {
   std::lock_guard lock{mutex_};
-  for (auto observer : observers_) {
-    PromiseUtils::Strand()->setImmediate([this_weak = weak_from_this(), observer, processId, processAuth]() {
+  for (const auto& [observer, strand] : observers_) {
+    strand->post([this_weak = weak_from_this(), observer = observer, processId, processAuth]() {
       if (auto this_ = this_weak.lock(); this_ && this_->hasRuntimeObserver_safe(*observer)) {
-        observer->onProcessAuthenticated_main(processId, processAuth);
+        observer->onProcessAuthenticated_strand(processId, processAuth);
       }
     });
   }
@@ -202,24 +225,27 @@ void Runtime::registerProcessAddr_safe(ObjectId processId, const char* host, con
   LOG_ASSERT(host);
   LOG_ASSERT(port);
   std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId);
-  if (i == processes_.end()) {
+  if (!registry_->processes.contains(processId)) {
     LOG_E("Runtime::RegisterProcess, invalid process");
     return;
   }
-  i->second.addr.host = host;
-  i->second.addr.port = port;
+  auto registry = copyRegistry_unsafe();
+  auto& process = registry->processes[processId];
+  process.addr.host = host;
+  process.addr.port = port;
+  publishRegistry_unsafe(std::move(registry));
 }
 
 
 void Runtime::unregisterProcessSession_safe(ObjectId processId) {
   std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId);
-  if (i == processes_.end()) {
+  if (!registry_->processes.contains(processId)) {
     LOG_E("Runtime::RegisterProcess, invalid process");
     return;
   }
-  i->second.session = nullptr;
+  auto registry = copyRegistry_unsafe();
+  registry->processes[processId].session = nullptr;
+  publishRegistry_unsafe(std::move(registry));
 }
 
 
@@ -232,7 +258,11 @@ void Runtime::unregisterProcess_safe(ObjectId processId) {
   LOG_ASSERT(!isProcessActive_safe(processId));
 
   std::lock_guard lock{mutex_};
-  processes_.erase(processId);
+  if (registry_->processes.contains(processId)) {
+    auto registry = copyRegistry_unsafe();
+    registry->processes.erase(processId);
+    publishRegistry_unsafe(std::move(registry));
+  }
 }
 
 
@@ -240,28 +270,22 @@ bool Runtime::isProcessActive_safe(ObjectId processId) const {
   if (processId == processId_) {
     return true;
   }
-  std::lock_guard lock{mutex_};
-  auto i = processes_.find(processId);
-  if (i != processes_.end() && i->second.session) {
+  auto registry = getRegistry_safe();
+  auto i = registry->processes.find(processId);
+  if (i != registry->processes.end() && i->second.session) {
     return true;
   }
-
-  for (auto& j : federationIdProcessId_) {
-    if (j.second == processId) {
-      return true;
-    }
-  }
-
-  return false;
+  return registry->processFederations.contains(processId);
 }
 
 
 void Runtime::federationProcessAdded_safe(ObjectId federationId, ObjectId processId) {
   std::unique_lock lock{mutex_};
 
-  auto process = [this, processId] {
-    auto i = processes_.find(processId);
-    return i != processes_.end() ? &i->second : nullptr;
+  auto registry = registry_; // keeps process valid after unlock
+  auto process = [&registry, processId] {
+    auto i = registry->processes.find(processId);
+    return i != registry->processes.end() ? &i->second : nullptr;
   }();
   if (!process) {
     return;
@@ -276,21 +300,24 @@ void Runtime::federationProcessAdded_safe(ObjectId federationId, ObjectId proces
       process->addr.host.c_str(),
       process->addr.port.c_str());
 
-  auto federationProcess = std::make_pair(federationId, process->id);
-  if (federationIdProcessId_.find(federationProcess) != federationIdProcessId_.end()) {
+  auto federationProcesses = registry->federationProcesses.find(federationId);
+  if (federationProcesses != registry->federationProcesses.end() && federationProcesses->second.contains(processId)) {
     return; // already added
   }
-  federationIdProcessId_.insert(federationProcess);
+  auto updated = copyRegistry_unsafe();
+  updated->federationProcesses[federationId].insert(processId);
+  updated->processFederations[processId].insert(federationId);
+  publishRegistry_unsafe(std::move(updated));
 
   auto i = std::find_if(federations_.begin(), federations_.end(), [federationId](auto& x) {
     return x->getFederationId() == federationId;
   });
   auto federation = i != federations_.end() ? i->get() : nullptr;
   if (federation) {
-    for (auto observer : observers_) {
-      PromiseUtils::Strand()->setImmediate([this_weak = weak_from_this(), observer, federationId, processId, processType = process->type]() {
+    for (const auto& [observer, strand] : observers_) {
+      strand->post([this_weak = weak_from_this(), observer = observer, federationId, processId, processType = process->type]() {
         if (auto this_ = this_weak.lock(); this_ && this_->hasRuntimeObserver_safe(*observer)) {
-          observer->onProcessAdded_main(federationId, processId, processType);
+          observer->onProcessAdded_strand(federationId, processId, processType);
         }
       });
     }
@@ -319,12 +346,23 @@ void Runtime::federationProcessRemoved_safe(ObjectId federationId, ObjectId proc
       federationId.debug_str().c_str(),
       processId.debug_str().c_str());
 
-  auto federationProcess = std::make_pair(federationId, processId);
   std::unique_lock lock{mutex_};
-  if (federationIdProcessId_.find(federationProcess) == federationIdProcessId_.end()) {
+  auto federationProcesses = registry_->federationProcesses.find(federationId);
+  if (federationProcesses == registry_->federationProcesses.end() || !federationProcesses->second.contains(processId)) {
     return; // already removed
   }
-  federationIdProcessId_.erase(std::make_pair(federationId, processId));
+  auto registry = copyRegistry_unsafe();
+  auto& processIds = registry->federationProcesses[federationId];
+  processIds.erase(processId);
+  if (processIds.empty()) {
+    registry->federationProcesses.erase(federationId);
+  }
+  auto& federationIds = registry->processFederations[processId];
+  federationIds.erase(federationId);
+  if (federationIds.empty()) {
+    registry->processFederations.erase(processId);
+  }
+  publishRegistry_unsafe(std::move(registry));
   lock.unlock();
 
   if (auto session = getProcessSession_safe(processId)) {
@@ -349,10 +387,10 @@ void Runtime::notifyFederationProcessRemoved_safe_(ObjectId federationId, Object
   });
   auto federation = i != federations_.end() ? i->get() : nullptr;
   if (federation) {
-    for (auto* observer : observers_) {
-      PromiseUtils::Strand()->setImmediate([this_weak = weak_from_this(), observer, federationId, processId]() {
+    for (const auto& [observer, strand] : observers_) {
+      strand->post([this_weak = weak_from_this(), observer = observer, federationId, processId]() {
         if (auto this_ = this_weak.lock(); this_ && this_->hasRuntimeObserver_safe(*observer)) {
-          observer->onProcessRemoved_main(federationId, processId);
+          observer->onProcessRemoved_strand(federationId, processId);
         }
       });
     }
@@ -361,19 +399,15 @@ void Runtime::notifyFederationProcessRemoved_safe_(ObjectId federationId, Object
 
 void Runtime::joinSessionsToFederation_safe(ObjectId federationId) {
   std::vector<std::shared_ptr<Session>> sessions{};
-  std::unique_lock lock{mutex_};
-  auto i = std::lower_bound(federationIdProcessId_.begin(), federationIdProcessId_.end(), std::make_pair(federationId, ObjectId{}));
-  while (i != federationIdProcessId_.end() && i->first == federationId) {
-    const auto& process = [this, processId = i->second] {
-      auto i = processes_.find(processId);
-      return i != processes_.end() ? &i->second : nullptr;
-    }();
-    if (process) {
-      if (auto session = getProcessSession(process->id)) {
-        sessions.push_back(session->shared_from_this());
+  std::unique_lock lock{mutex_}; // sessions unregister under mutex before they are destroyed
+  auto federationProcesses = registry_->federationProcesses.find(federationId);
+  if (federationProcesses != registry_->federationProcesses.end()) {
+    for (auto processId : federationProcesses->second) {
+      auto process = registry_->processes.find(processId);
+      if (process != registry_->processes.end() && process->second.session) {
+        sessions.push_back(process->second.session->shared_from_this());
       }
     }
-    ++i;
   }
   lock.unlock();
 
@@ -387,24 +421,19 @@ void Runtime::joinSessionsToFederation_safe(ObjectId federationId) {
 
 std::vector<ObjectId> Runtime::getProcessFederations_safe(ObjectId processId) {
   std::vector<ObjectId> result{};
-  std::lock_guard lock{mutex_};
-  for (const auto& i : federationIdProcessId_) {
-    if (i.second == processId) {
-      result.push_back(i.first);
-    }
+  auto registry = getRegistry_safe();
+  auto i = registry->processFederations.find(processId);
+  if (i != registry->processFederations.end()) {
+    result.assign(i->second.begin(), i->second.end());
   }
   return result;
 }
 
 
 FederationType Runtime::getFederationType_safe(ObjectId federationId) const {
-  std::lock_guard lock{mutex_};
-  for (auto& federation : federations_) {
-    if (federation->getFederationId() == federationId) {
-      return federation->getFederationType();
-    }
-  }
-  return FederationType::None;
+  auto registry = getRegistry_safe();
+  auto i = registry->federationTypes.find(federationId);
+  return i != registry->federationTypes.end() ? i->second : FederationType::None;
 }
 
 
@@ -454,6 +483,12 @@ Federation* Runtime::initiateFederation_safe(ObjectId federationId, FederationTy
     LOG_ASSERT(federation->getFederationType() == federationType);
   } else {
     federation->federationType_ = federationType;
+    {
+      std::lock_guard lock{mutex_};
+      auto registry = copyRegistry_unsafe();
+      registry->federationTypes[federationId] = federationType;
+      publishRegistry_unsafe(std::move(registry));
+    }
 
     LOG_TRACE("%s[%s] Runtime::InitiateFederation({%s}, %s)",
         str(processType_),
@@ -532,6 +567,12 @@ void Runtime::releaseFederation_safe(Federation* federation) {
       assert(i != federations_.end());
     }
 
+    if (registry_->federationTypes.contains(federationId)) {
+      auto registry = copyRegistry_unsafe();
+      registry->federationTypes.erase(federationId);
+      publishRegistry_unsafe(std::move(registry));
+    }
+
     if (federationId && endpoint_) {
       endpoint_->broadcastFederationProcessRemoved_safe(federationId, processId_);
     }
@@ -543,3 +584,87 @@ void Runtime::releaseFederation_safe(Federation* federation) {
     federationProcessRemoved_safe(federationId, processId_);
   }
 }
+
+
+/***/
+
+
+/*
+ * Each thread keeps the registries it has read last, by version. As
+ * long as the version of the runtime has not moved, the registry is
+ * read without taking the mutex. Versions are unique across runtimes,
+ * so a thread serving several runtimes needs only one small cache.
+ */
+std::shared_ptr<const Runtime::Registry> Runtime::getRegistry_safe() const {
+  struct CachedRegistry {
+    std::uint64_t version;
+    std::shared_ptr<const Registry> registry;
+  };
+  static constexpr std::size_t MaxCachedRegistries = 8;
+  thread_local std::vector<CachedRegistry> cache{};
+
+  auto version = registryVersion_.load(std::memory_order_acquire);
+  for (const auto& cached : cache) {
+    if (cached.version == version) {
+      return cached.registry;
+    }
+  }
+
+  std::unique_lock lock{mutex_};
+  CachedRegistry cached{registryVersion_.load(std::memory_order_relaxed), registry_};
+  lock.unlock();
+
+  if (cache.size() == MaxCachedRegistries) {
+    cache.erase(cache.begin());
+  }
+  cache.push_back(cached);
+  return cached.registry;
+}
+
+
+std::shared_ptr<Runtime::Registry> Runtime::copyRegistry_unsafe() const {
+  return std::make_shared<Registry>(*registry_);
+}
+
+
+void Runtime::publishRegistry_unsafe(std::shared_ptr<Registry> registry) {
+  registry_ = std::move(registry);
+  registryVersion_.store(++lastRegistryVersion, std::memory_order_release);
+}
+
+
+/***/
+
+
+void Runtime::collectMetrics_safe(Metrics& metrics) {
+  std::vector<Federation*> federations{};
+  std::unique_lock lock{mutex_};
+  for (auto& federation : federations_) {
+    ++federation->acquireCount_;
+    federations.push_back(federation.get());
+  }
+  lock.unlock();
+
+  std::set<std::string> reported{};
+  for (auto federation : federations) {
+    std::size_t objectCount;
+    {
+      std::lock_guard federation_lock{federation->mutex_};
+      objectCount = federation->masterInstances_.size();
+    }
+    auto labels = makeString("process=\"%s\",federation=\"%s\",type=\"%s\"",
+        processId_.str().c_str(),
+        federation->getFederationId().str().c_str(),
+        str(federation->getFederationType()));
+    metrics.gauge("warstage_federation_objects", labels).set(static_cast<std::int64_t>(objectCount));
+    reported.insert(std::move(labels));
+    releaseFederation_safe(federation);
+  }
+
+  for (const auto& labels : reportedFederations_) {
+    if (!reported.count(labels)) {
+      metrics.remove("warstage_federation_objects", labels);
+    }
+  }
+  reportedFederations_.swap(reported);
+}
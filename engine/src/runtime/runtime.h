@@ -14,9 +14,12 @@
 #include "async/strand.h"
 #include "async/shutdownable.h"
 #include "value/value.h"
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <set>
 
@@ -63,18 +66,24 @@ enum class ObjectChange {
   Delete = 3,
 };
 
-class Analytics;
 class Endpoint;
+class Metrics;
+class ValueCorpus;
+class InterestPolicy;
+class ObjectSchema;
 class SupervisionPolicy;
 
+// Observer callbacks run on the strand the observer was added with,
+// or on PromiseUtils::Strand() if it was added without one
+
 class RuntimeObserver {
   friend class Runtime;
 public:
   virtual ~RuntimeObserver() = default;
 protected:
-  virtual void onProcessAdded_main(ObjectId federationId, ObjectId processId, ProcessType processType) {}
-  virtual void onProcessRemoved_main(ObjectId federationId, ObjectId processId) {}
-  virtual void onProcessAuthenticated_main(ObjectId processId, const ProcessAuth& processAuth) = 0;
+  virtual void onProcessAdded_strand(ObjectId federationId, ObjectId processId, ProcessType processType) {}
+  virtual void onProcessRemoved_strand(ObjectId federationId, ObjectId processId) {}
+  virtual void onProcessAuthenticated_strand(ObjectId processId, const ProcessAuth& processAuth) = 0;
 };
 
 class Runtime :
@@ -94,16 +103,36 @@ class Runtime :
     ProcessAuth auth = {};
   };
 
+  // The registry is read-mostly: changes copy it and replace it under
+  // the mutex with a new version, while lookups from session strands
+  // reuse the registry cached on their thread until the version moves.
+  struct Registry {
+    std::unordered_map<ObjectId, Process> processes{};
+    std::unordered_map<ObjectId, std::unordered_set<ObjectId>> federationProcesses{}; // federationId -> processIds
+    std::unordered_map<ObjectId, std::unordered_set<ObjectId>> processFederations{}; // processId -> federationIds
+    std::unordered_map<ObjectId, FederationType> federationTypes{};
+  };
+
   const ProcessType processType_;
   const ObjectId processId_;
   mutable std::mutex mutex_{};
   SupervisionPolicy* supervisionPolicy_;
   Endpoint* endpoint_{};
-  // Analytics* analytics_{};
+  Metrics* metrics_{};
+  int metricsCollectorId_{};
+  const ObjectSchema* objectSchema_{};
+  const InterestPolicy* interestPolicy_{};
+  ValueCorpus* packetCorpus_{};
+  bool floatDelta_{true};
+  std::set<std::string> reportedFederations_{}; // metrics collector
   std::vector<std::unique_ptr<Federation>> federations_{}; // mutex
-  std::unordered_map<ObjectId, Process> processes_{}; // mutex
-  std::set<std::pair<ObjectId, ObjectId>> federationIdProcessId_{}; // mutex
-  std::vector<RuntimeObserver*> observers_{}; // mutex
+  std::shared_ptr<const Registry> registry_{}; // mutex
+  std::atomic<std::uint64_t> registryVersion_{}; // replaced with registry_, unique across runtimes
+  struct ObserverInfo {
+    RuntimeObserver* observer;
+    std::shared_ptr<Strand_base> strand;
+  };
+  std::vector<ObserverInfo> observers_{}; // mutex
 
 public:
   explicit Runtime(ProcessType processType, SupervisionPolicy* supervisionPolicy = nullptr);
@@ -116,12 +145,32 @@ protected: // Shutdownable
   [[nodiscard]] Promise<void> shutdown_() override;
 
 public:
-  std::vector<ProcessInfo> addRuntimeObserver_safe(RuntimeObserver& observer);
+  std::vector<ProcessInfo> addRuntimeObserver_safe(RuntimeObserver& observer, std::shared_ptr<Strand_base> strand = nullptr);
   void removeRuntimeObserver_safe(RuntimeObserver& observer);
   bool hasRuntimeObserver_safe(const RuntimeObserver& observer) const;
 
-  // [[nodiscard]] Analytics* getAnalytics() const { return analytics_; }
-  // void setAnalytics(Analytics* value) { analytics_ = value; }
+  [[nodiscard]] Metrics* getMetrics() const { return metrics_; }
+  void setMetrics(Metrics* value);
+
+  // must be set before any sessions are created
+  [[nodiscard]] const ObjectSchema* getObjectSchema() const { return objectSchema_; }
+  void setObjectSchema(const ObjectSchema* value) { objectSchema_ = value; }
+
+  // must be set before any sessions are created, without a
+  // policy all objects are sent to players without rate limiting
+  [[nodiscard]] const InterestPolicy* getInterestPolicy() const { return interestPolicy_; }
+  void setInterestPolicy(const InterestPolicy* value) { interestPolicy_ = value; }
+
+  // records the packets sent by sessions, for the codec benchmark,
+  // must be set before any sessions are created
+  [[nodiscard]] ValueCorpus* getPacketCorpus() const { return packetCorpus_; }
+  void setPacketCorpus(ValueCorpus* value) { packetCorpus_ = value; }
+
+  // sends floats in object changes as the xor with their previous
+  // value, see ObjectChangesEncoder, must be set before any sessions
+  // are created
+  [[nodiscard]] bool getFloatDelta() const { return floatDelta_; }
+  void setFloatDelta(bool value) { floatDelta_ = value; }
 
   [[nodiscard]] ObjectId getProcessId() const { return processId_; }
   [[nodiscard]] ProcessType getProcessType() const { return processType_; }
@@ -130,7 +179,6 @@ public:
   [[nodiscard]] ProcessAuth getProcessAuth_safe() const { return getProcessAuth_safe(processId_); }
   [[nodiscard]] ProcessAddr getProcessAddr_safe() const;
   [[nodiscard]] std::string getSubjectId_safe() const;
-  [[nodiscard]] Session* getProcessSession(ObjectId processId) const;
   [[nodiscard]] Session* getProcessSession_safe(ObjectId processId) const;
   [[nodiscard]] bool isProcessActive_safe(ObjectId processId) const;
 
@@ -160,6 +208,13 @@ public:
 
   Federation* acquireFederation_safe(ObjectId federationId, bool createIfNotExists = false);
   void releaseFederation_safe(Federation* federation);
+
+private:
+  [[nodiscard]] std::shared_ptr<const Registry> getRegistry_safe() const;
+  [[nodiscard]] std::shared_ptr<Registry> copyRegistry_unsafe() const;
+  void publishRegistry_unsafe(std::shared_ptr<Registry> registry);
+
+  void collectMetrics_safe(Metrics& metrics);
 };
 
 
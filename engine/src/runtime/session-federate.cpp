@@ -3,10 +3,14 @@
 
 #include "session-federate.h"
 #include "session.h"
+#include "async/strand.h"
+#include <algorithm>
 
 
 SessionFederate::SessionFederate(Runtime& runtime, const char* federateName, std::shared_ptr<Strand_base> strand, Session& session)
-    : Federate{runtime, federateName, std::move(strand)}, session_{&session}
+    : Federate{runtime, federateName, std::move(strand)},
+    session_{&session},
+    interestPolicy_{runtime.getInterestPolicy()}
 {
   LOG_LIFECYCLE("%p SessionFederate + %s", this, federateName_.c_str());
 }
@@ -20,6 +24,16 @@ SessionFederate::~SessionFederate() {
 
 Promise<void> SessionFederate::shutdown_() {
   auto federationId = getFederationId();
+  if (deferredInterval_) {
+    clearInterval(*deferredInterval_);
+    deferredInterval_.reset();
+  }
+  co_await *strand_;
+  if (flushImmediate_) {
+    clearImmediate(*flushImmediate_);
+    flushImmediate_.reset();
+    flushMessages();
+  }
   co_await Federate::shutdown_();
   session_->removeFederation_safe(federationId, *this);
   session_->runtime_->federationProcessRemoved_safe(federationId, session_->getProcessId());
@@ -45,7 +59,9 @@ void SessionFederate::leaveBlock_strand() {
 }
 
 
-void SessionFederate::objectCallback(ObjectId federationId, ObjectRef object) {
+void SessionFederate::objectCallback(ObjectRef object) {
+  updateInterest(object);
+
   const char doNotDistributePrefix = session_->getDoNotDistributePrefix_strand();
   if (object.getObjectClass()[0] == doNotDistributePrefix) {
     return;
@@ -55,24 +71,13 @@ void SessionFederate::objectCallback(ObjectId federationId, ObjectRef object) {
       : object.justDiscovered() ? ObjectChange::Discover
           : ObjectChange::Update;
 
-  auto builder = Struct{}
-      << "m" << static_cast<std::int32_t>(Session::Message::ObjectChanges)
-      << "x" << federationId.str()
-      << "i" << object.getObjectId()
-      << "c" << object.getObjectClass()
-      << "t" << static_cast<std::int32_t>(change);
-
-  bool distribute = change != ObjectChange::Update;
-
-  if (change == ObjectChange::Delete) {
-    builder = std::move(builder) << "p" << Struct{} << ValueEnd{};
-  } else {
+  changedProperties_.clear();
+  if (change != ObjectChange::Delete) {
     bool allowOwnership = !ownershipDisabled_ && session_->getProcessType() != ProcessType::None;
 
     if (allowOwnership && object.getOwnershipState() & OwnershipStateFlag::NotAbleToAcquire) {
       object.modifyOwnershipState(OwnershipOperation::Publish);
     }
-    auto properties = std::move(builder) << "p" << Struct{};
     for (auto& property : object.getProperties()) {
       if (property) {
         bool shouldDistribute = property->hasChanged()
@@ -82,33 +87,38 @@ void SessionFederate::objectCallback(ObjectId federationId, ObjectRef object) {
           if (allowOwnership && property->getOwnershipState() & OwnershipStateFlag::NotAbleToAcquire) {
             property->modifyOwnershipState(OwnershipOperation::Publish);
           }
-          properties = std::move(properties) << property->getName().c_str() << Struct{}
-              << "v" << property->value3_
-              << "t" << property->time3_ - currentTime_
-              << "p" << property->processId_
-              << ValueEnd{};
-          distribute = true;
+          changedProperties_.push_back(property.get());
         }
       }
     }
-    builder = std::move(properties) << ValueEnd{};
   }
 
-  if (distribute) {
-    auto value = std::move(builder) << ValueEnd{};
-    enqueueMessage(value);
+  if (change == ObjectChange::Delete) {
+    deferredObjects_.erase(object.getObjectId());
+  } else if (change == ObjectChange::Update && deferObjectChanges(object)) {
+    return;
+  }
+
+  if (change == ObjectChange::Update && changedProperties_.empty()) {
+    return;
+  }
+
+  if (change == ObjectChange::Discover && discoveredInstances_.size() >= SnapshotThreshold) {
+    addSnapshotObject(object);
+  } else {
+    sendObjectChanges(object, change);
   }
 }
 
 
-void SessionFederate::eventCallback(ObjectId federationId, const char* eventName, const Value& value) {
+void SessionFederate::eventCallback(const char* eventName, const Value& value) {
   if (eventName[0] == session_->getDoNotDistributePrefix_strand()) {
     return;
   }
 
   enqueueMessage(Struct{}
       << "m" << static_cast<std::int32_t>(Session::Message::EventDispatch)
-      << "x" << federationId.str()
+      << "x" << federationHandle_
       << "e" << eventName
       << "v" << value
       << "d" << getEventDelay()
@@ -117,7 +127,7 @@ void SessionFederate::eventCallback(ObjectId federationId, const char* eventName
 }
 
 
-Promise<Value> SessionFederate::serviceCallback(ObjectId federationId, const char* serviceName, const Value& value, const std::string& subjectId) {
+Promise<Value> SessionFederate::serviceCallback(const char* serviceName, const Value& value, const std::string& subjectId) {
   if (serviceName[0] == session_->getDoNotDistributePrefix_strand()) {
     return Promise<Value>{}.reject<Value>(Value{});
   }
@@ -125,7 +135,7 @@ Promise<Value> SessionFederate::serviceCallback(ObjectId federationId, const cha
   auto serviceRequest = session_->generateServiceRequest_strand();
   enqueueMessage(Struct{}
       << "m" << static_cast<std::int32_t>(Session::Message::ServiceRequest)
-      << "x" << federationId.str()
+      << "x" << federationHandle_
       << "s" << serviceName
       << "r" << serviceRequest.first
       << "v" << value
@@ -136,7 +146,7 @@ Promise<Value> SessionFederate::serviceCallback(ObjectId federationId, const cha
 }
 
 
-void SessionFederate::ownershipCallback(ObjectId federationId, ObjectRef object, const Property& property, OwnershipNotification notification) {
+void SessionFederate::ownershipCallback(ObjectRef object, const Property& property, OwnershipNotification notification) {
   const char doNotDistributePrefix = session_->getDoNotDistributePrefix_strand();
   if (object.getObjectClass()[0] == doNotDistributePrefix || property.getName()[0] == doNotDistributePrefix) {
     return;
@@ -174,7 +184,7 @@ void SessionFederate::ownershipCallback(ObjectId federationId, ObjectRef object,
   if (message != Session::Message::None) {
     enqueueMessage(Struct{}
         << "m" << static_cast<std::int32_t>(message)
-        << "x" << federationId.str()
+        << "x" << federationHandle_
         << "i" << object.getObjectId()
         << "p" << property.getName()
         << ValueEnd{});
@@ -182,12 +192,42 @@ void SessionFederate::ownershipCallback(ObjectId federationId, ObjectRef object,
 }
 
 
+void SessionFederate::setCameraPosition(glm::vec2 value) {
+  LOG_ASSERT(isFederateStrandCurrent());
+
+  interest_.cameraPosition = value;
+  interest_.hasCameraPosition = true;
+  sendDeferredObjects();
+}
+
+
 void SessionFederate::enqueueMessage(const Value& message) {
   LOG_ASSERT(isFederateStrandCurrent());
 
-  messages_.push_back(message);
+  session_->sampleOutgoingMessage_strand(message["m"_int]);
+  messages_ = takeMessages() << message;
   if (!blocks_) {
-    flushMessages();
+    scheduleFlushMessages();
+  }
+}
+
+
+/*
+ * Messages enqueued outside a block, e.g. service requests and
+ * fulfillments that each run in a task of their own, are flushed
+ * when the tasks already on the strand have run, so that a burst
+ * of them is sent as a single Messages packet.
+ */
+void SessionFederate::scheduleFlushMessages() {
+  LOG_ASSERT(isFederateStrandCurrent());
+
+  if (!flushImmediate_) {
+    flushImmediate_ = strand_->setImmediate([weak_ = weak_from_this()]() {
+      if (auto this_ = std::static_pointer_cast<SessionFederate>(weak_.lock())) {
+        this_->flushImmediate_.reset();
+        this_->flushMessages();
+      }
+    });
   }
 }
 
@@ -195,20 +235,295 @@ void SessionFederate::enqueueMessage(const Value& message) {
 void SessionFederate::flushMessages() {
   LOG_ASSERT(isFederateStrandCurrent());
 
-  if (!messages_.empty()) {
-    auto builder = build_array();
-    for (const auto& message : messages_) {
-      builder = std::move(builder) << message;
-    }
-    auto array = std::move(builder) << ValueEnd{};
+  endSnapshot();
+  if (messages_) {
+    auto packet = std::move(*messages_) << ValueEnd{} << ValueEnd{};
+    messages_.reset();
+    session_->trySendOutgoingPacket_strand(packet);
+  }
+}
+
 
-    auto value = Struct{}
+/*
+ * Messages are written straight into the Messages packet, which is
+ * started by the first message. A pending snapshot is written first,
+ * as the messages that follow may refer to the objects it discovers.
+ */
+ArrayBuilder<StructBuilder<ValueBuilder>> SessionFederate::takeMessages() {
+  endSnapshot();
+  if (!messages_) {
+    return Struct{}
         << "m" << static_cast<std::int32_t>(Session::Packet::Messages)
-        << "mm" << array
+        << "mm" << Array{};
+  }
+  return std::move(*messages_);
+}
+
+
+/***/
+
+
+bool SessionFederate::shouldFilterObject(ObjectRef object) const {
+  return interestPolicy_
+      && session_->getProcessType() == ProcessType::Player
+      && interest_.hasCameraPosition
+      && interestPolicy_->shouldFilterObject(object);
+}
+
+
+bool SessionFederate::isWithinInterest(ObjectRef object) const {
+  return interestPolicy_->isWithinInterest(interest_, object);
+}
+
+
+/*
+ * Removes changes that should not be sent now from changedProperties_, and
+ * returns true if nothing is left to send. While the session's outgoing queue
+ * is full, all changes are held back. Objects outside the area of interest
+ * are sent at most once per DeferredUpdateInterval, and without low priority
+ * properties. Held back properties are sent later with their latest value,
+ * by sendDeferredObjects() or by the next call.
+ */
+bool SessionFederate::deferObjectChanges(ObjectRef object) {
+  auto i = deferredObjects_.find(object.getObjectId());
+  bool queueFull = session_->isOutgoingQueueFull_strand();
+  bool withinInterest = !shouldFilterObject(object) || isWithinInterest(object);
+  if (i == deferredObjects_.end() && withinInterest && !queueFull) {
+    return false;
+  }
+
+  if (i == deferredObjects_.end()) {
+    i = deferredObjects_.emplace(object.getObjectId(), DeferredObject{object}).first;
+  }
+  auto& deferred = i->second;
+  takeDeferredProperties(deferred);
+
+  if (queueFull) {
+    ++session_->counters_.deferredUpdates;
+    deferChangedProperties(deferred, changedProperties_.begin());
+    startDeferredInterval();
+    return true;
+  }
+
+  if (withinInterest) {
+    deferredObjects_.erase(i);
+    return false;
+  }
+
+  auto now = std::chrono::system_clock::now();
+  deferChangedProperties(deferred, now < deferred.sendTime + DeferredUpdateInterval
+      ? changedProperties_.begin()
+      : partitionLowPriority());
+
+  if (!changedProperties_.empty()) {
+    deferred.sendTime = now;
+  }
+  if (!deferred.properties.empty()) {
+    startDeferredInterval();
+  }
+  return changedProperties_.empty();
+}
+
+
+void SessionFederate::sendDeferredObjects() {
+  if (deferredObjects_.empty() || session_->isOutgoingQueueFull_strand()) {
+    return;
+  }
+
+  auto now = std::chrono::system_clock::now();
+  bool pending = false;
+
+  ++blocks_;
+  for (auto i = deferredObjects_.begin(); i != deferredObjects_.end();) {
+    auto& deferred = i->second;
+    auto object = deferred.object;
+    if (object.isDeletedByMaster()) {
+      i = deferredObjects_.erase(i);
+      continue;
+    }
+    bool withinInterest = !shouldFilterObject(object) || isWithinInterest(object);
+    if (!withinInterest && now < deferred.sendTime + DeferredUpdateInterval) {
+      pending = pending || !deferred.properties.empty();
+      ++i;
+      continue;
+    }
+
+    changedProperties_.clear();
+    takeDeferredProperties(deferred);
+    if (!withinInterest) {
+      deferChangedProperties(deferred, partitionLowPriority());
+    }
+
+    if (!changedProperties_.empty()) {
+      sendObjectChanges(object, ObjectChange::Update);
+      deferred.sendTime = now;
+    }
+
+    if (withinInterest) {
+      i = deferredObjects_.erase(i);
+    } else {
+      pending = pending || !deferred.properties.empty();
+      ++i;
+    }
+  }
+  if (--blocks_ == 0) {
+    flushMessages();
+  }
+
+  if (!pending && deferredInterval_) {
+    clearInterval(*deferredInterval_);
+    deferredInterval_.reset();
+  }
+}
+
+
+void SessionFederate::startDeferredInterval() {
+  if (!deferredInterval_) {
+    deferredInterval_ = strand_->setInterval([weak_ = weak_from_this()]() {
+      if (auto this_ = std::static_pointer_cast<SessionFederate>(weak_.lock())) {
+        if (!this_->shutdownStarted()) {
+          this_->sendDeferredObjects();
+        }
+      }
+    }, 250);
+  }
+}
+
+
+/*
+ * Deferred properties are kept by name, and looked up in the object
+ * when they are sent. A property that has also changed since it was
+ * deferred is sent once, with its latest value.
+ */
+void SessionFederate::takeDeferredProperties(DeferredObject& deferred) {
+  for (const auto& name : deferred.properties) {
+    auto& property = deferred.object.getProperty(name);
+    if (std::find(changedProperties_.begin(), changedProperties_.end(), &property) != changedProperties_.end()) {
+      ++session_->counters_.coalescedUpdates;
+    } else if (property.routing_) {
+      changedProperties_.push_back(&property);
+    }
+  }
+  deferred.properties.clear();
+}
+
+
+void SessionFederate::deferChangedProperties(DeferredObject& deferred, std::vector<Property*>::iterator first) {
+  for (auto i = first; i != changedProperties_.end(); ++i) {
+    deferred.properties.push_back((*i)->getName());
+  }
+  changedProperties_.erase(first, changedProperties_.end());
+}
+
+
+std::vector<Property*>::iterator SessionFederate::partitionLowPriority() {
+  return std::partition(changedProperties_.begin(), changedProperties_.end(), [this](Property* property) {
+    return !interestPolicy_->isLowPriority(*property);
+  });
+}
+
+
+/*
+ * The schema is chosen for the first message, and the receiver
+ * is told in that message if the schema is used. The message is
+ * written straight into the Messages packet, see takeMessages.
+ */
+void SessionFederate::sendObjectChanges(ObjectRef object, ObjectChange change) {
+  if (!objectChanges_.hasMessages()) {
+    objectChanges_.setSchema(session_->getObjectSchema_strand());
+    objectChanges_.setFloatDelta(getRuntime().getFloatDelta());
+  }
+  objectChanges_.begin(change, object.getObjectId(), object.getObjectClass().c_str());
+  addChangedProperties(objectChanges_);
+  auto changes = objectChanges_.end();
+
+  session_->sampleOutgoingMessage_strand(static_cast<int>(Session::Message::ObjectChanges));
+  if (objectChanges_.isFirstMessage()) {
+    messages_ = takeMessages() << Struct{}
+        << "m" << static_cast<std::int32_t>(Session::Message::ObjectChanges)
+        << "x" << federationHandle_
+        << "n" << true
+        << "s" << (objectChanges_.getSchema() != nullptr)
+        << "b" << changes
+        << ValueEnd{};
+  } else {
+    messages_ = takeMessages() << Struct{}
+        << "m" << static_cast<std::int32_t>(Session::Message::ObjectChanges)
+        << "x" << federationHandle_
+        << "n" << false
+        << "b" << changes
+        << ValueEnd{};
+  }
+  if (!blocks_) {
+    scheduleFlushMessages();
+  }
+}
+
+
+/*
+ * Discovered objects are collected into a single snapshot message when
+ * many objects are discovered at once, e.g. when joining a running battle.
+ * The snapshot is written when the next message is, or when the messages
+ * are flushed.
+ */
+void SessionFederate::addSnapshotObject(ObjectRef object) {
+  if (!snapshot_) {
+    snapshot_ = std::make_unique<ObjectChangesEncoder>();
+    snapshot_->setSchema(session_->getObjectSchema_strand());
+    snapshot_->setFloatDelta(getRuntime().getFloatDelta());
+    snapshot_->beginSnapshot();
+  }
+  snapshot_->addObject(object.getObjectId(), object.getObjectClass().c_str());
+  addChangedProperties(*snapshot_);
+}
+
+
+void SessionFederate::endSnapshot() {
+  if (snapshot_) {
+    auto snapshot = std::move(snapshot_);
+    session_->sampleOutgoingMessage_strand(static_cast<int>(Session::Message::ObjectSnapshot));
+    messages_ = takeMessages() << Struct{}
+        << "m" << static_cast<std::int32_t>(Session::Message::ObjectSnapshot)
+        << "x" << federationHandle_
+        << "s" << (snapshot->getSchema() != nullptr)
+        << "b" << snapshot->end()
         << ValueEnd{};
+  }
+}
 
-    session_->trySendOutgoingPacket_strand(value);
 
-    messages_.clear();
+void SessionFederate::addChangedProperties(ObjectChangesEncoder& encoder) {
+  for (auto property : changedProperties_) {
+    encoder.addProperty(property->getName().c_str(),
+        property->value3_,
+        property->time3_ - currentTime_,
+        property->processId_);
+  }
+}
+
+
+/*
+ * A player forwards its camera position to the daemon, and the daemon
+ * lets the interest policy find the player's own objects, to define
+ * the area of interest used when sending objects to the player.
+ */
+void SessionFederate::updateInterest(ObjectRef object) {
+  if (!interestPolicy_ || object.justDestroyed()) {
+    return;
+  }
+  if (session_->getProcessType() == ProcessType::Daemon) {
+    if (auto position = interestPolicy_->getCameraPosition(object)) {
+      if (!cameraPositionSent_ || glm::distance(*position, sentCameraPosition_) >= CameraUpdateDistance) {
+        sentCameraPosition_ = *position;
+        cameraPositionSent_ = true;
+        enqueueMessage(Struct{}
+            << "m" << static_cast<std::int32_t>(Session::Message::InterestUpdate)
+            << "x" << federationHandle_
+            << "c" << *position
+            << ValueEnd{});
+      }
+    }
+  } else if (session_->getProcessType() == ProcessType::Player) {
+    interestPolicy_->updateInterest(interest_, object, session_->subjectId_);
   }
 }
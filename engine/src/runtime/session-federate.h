@@ -5,18 +5,47 @@
 #define WARSTAGE__RUNTIME__SESSION_FEDERATE_H
 
 #include "./federate.h"
+#include "./interest-policy.h"
+#include "./object-changes.h"
 #include "./runtime.h"
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+
+// Changes held back for an object, sent later with their latest values.
+struct DeferredObject {
+  ObjectRef object{};
+  std::chrono::system_clock::time_point sendTime{};
+  std::vector<std::string> properties{};
+};
 
 
 class SessionFederate : public Federate {
   friend class Session;
 
   Session* const session_{};
+  const InterestPolicy* const interestPolicy_{};
+  int federationHandle_{};
   int blocks_{};
-  std::vector<Value> messages_{};
+  std::optional<ArrayBuilder<StructBuilder<ValueBuilder>>> messages_{}; // the "mm" array of the Messages packet
+  std::shared_ptr<ImmediateObject> flushImmediate_{};
+  ObjectChangesEncoder objectChanges_{};
+  std::unique_ptr<ObjectChangesEncoder> snapshot_{};
+  std::vector<Property*> changedProperties_{};
   bool ownershipDisabled_{};
+  SessionInterest interest_{};
+  std::unordered_map<ObjectId, DeferredObject> deferredObjects_{};
+  std::shared_ptr<IntervalObject> deferredInterval_{};
+  glm::vec2 sentCameraPosition_{};
+  bool cameraPositionSent_{};
 
 public:
+  static constexpr float CameraUpdateDistance = 32.0f;
+  static constexpr auto DeferredUpdateInterval = std::chrono::milliseconds{1000};
+  static constexpr std::size_t SnapshotThreshold = 16; // discovered objects
+
   SessionFederate(Runtime& runtime, const char* federateName, std::shared_ptr<Strand_base> strand, Session& session);
   ~SessionFederate() override;
 
@@ -29,13 +58,34 @@ public:
   void enterBlock_strand() override; // AssertFederateStrand
   void leaveBlock_strand() override; // AssertFederateStrand
 
-  void objectCallback(ObjectId federationId, ObjectRef object);
-  void eventCallback(ObjectId federationId, const char* eventName, const Value& value);
-  [[nodiscard]] Promise<Value> serviceCallback(ObjectId federationId, const char* serviceName, const Value& value, const std::string& subjectId);
-  void ownershipCallback(ObjectId federationId, ObjectRef object, const Property& property, OwnershipNotification notification);
+  [[nodiscard]] int getFederationHandle() const { return federationHandle_; }
+
+  void objectCallback(ObjectRef object);
+  void eventCallback(const char* eventName, const Value& value);
+  [[nodiscard]] Promise<Value> serviceCallback(const char* serviceName, const Value& value, const std::string& subjectId);
+  void ownershipCallback(ObjectRef object, const Property& property, OwnershipNotification notification);
+
+  void setCameraPosition(glm::vec2 value); // AssertFederateStrand
 
   void enqueueMessage(const Value& message); // AssertFederateStrand
   void flushMessages(); // AssertFederateStrand
+  void scheduleFlushMessages(); // AssertFederateStrand
+
+private:
+  [[nodiscard]] bool shouldFilterObject(ObjectRef object) const;
+  [[nodiscard]] bool isWithinInterest(ObjectRef object) const;
+  [[nodiscard]] bool deferObjectChanges(ObjectRef object);
+  void sendDeferredObjects();
+  void startDeferredInterval();
+  void takeDeferredProperties(DeferredObject& deferred);
+  void deferChangedProperties(DeferredObject& deferred, std::vector<Property*>::iterator first);
+  [[nodiscard]] std::vector<Property*>::iterator partitionLowPriority();
+  void sendObjectChanges(ObjectRef object, ObjectChange change);
+  void addSnapshotObject(ObjectRef object);
+  void endSnapshot();
+  [[nodiscard]] ArrayBuilder<StructBuilder<ValueBuilder>> takeMessages();
+  void addChangedProperties(ObjectChangesEncoder& encoder);
+  void updateInterest(ObjectRef object);
 };
 
 
@@ -2,16 +2,20 @@
 // Licensed under GNU General Public License version 3 or later.
 
 #include "./endpoint.h"
+#include "./metrics.h"
 #include "./runtime.h"
 #include "./session.h"
 #include "./session-federate.h"
 #include "utilities/logging.h"
+#include "value/corpus.h"
+#include <algorithm>
 
 
 #define LOG_TRACE(format, ...)   LOG_X(format, ##__VA_ARGS__)
 #define LOG_ROUTING(format, ...)   LOG_X(format, ##__VA_ARGS__)
 
 static std::atomic_int debugCounter = 0;
+static std::atomic_int lastMetricsOrdinal = 0;
 
 
 LatencyHeader LatencyTracker::generateHeader() {
@@ -55,11 +59,13 @@ LatencyTracker::clock::duration LatencyTracker::idleTimeToDuration(std::uint16_t
 Session::Session(Endpoint& endpoint, std::shared_ptr<Strand_base> strand) :
     runtime_{endpoint.runtime_},
     endpoint_{&endpoint},
-    strand_{std::move(strand)}
+    strand_{std::move(strand)},
+    outgoingByteBudget_{endpoint.outgoingByteBudget_},
+    serviceRequestTimeout_{endpoint.serviceRequestTimeout_}
 {
   LOG_LIFECYCLE("%p Session + %d", this, ++debugCounter);
   endpoint_->addSession_safe(this);
-  runtime_->addRuntimeObserver_safe(*this);
+  runtime_->addRuntimeObserver_safe(*this, strand_);
 }
 
 
@@ -82,6 +88,8 @@ Promise<void> Session::shutdown_() {
   runtime_->removeRuntimeObserver_safe(*this);
 
   stopHeartbeatInterval_strand();
+  releaseMetrics_strand();
+  rejectServiceRequests_strand(std::chrono::system_clock::time_point::max(), 503, "session shut down");
 
   std::unordered_map<ObjectId, std::shared_ptr<Federate>> federates{};
   std::unique_lock lock{mutex_};
@@ -154,12 +162,12 @@ void Session::receivePacket_strand(const Value& packet) {
   auto payload = packet["p"];
   int packetType = payload["m"_int];
 
-  // if (processType_ == ProcessType::Daemon && runtime_->getProcessType() == ProcessType::Player) {
-  //   if (auto analytics = runtime_->getAnalytics()) {
-  //     analytics->samplePacketIncoming(packet.size(), latencyTracker_.getLatency());
-  //     analytics->samplePacket(packetType);
-  //   }
-  // }
+  if (auto metrics = getMetrics_strand()) {
+    metrics->bytesIn->increment(packet.size());
+    if (packetType >= 0 && packetType < static_cast<int>(SessionMetrics::MaxPacketType)) {
+      metrics->packetsIn[packetType]->increment();
+    }
+  }
 
   switch (static_cast<Packet>(packetType)) {
     case Packet::Handshake:
@@ -189,12 +197,22 @@ void Session::sendPacket_strand(const Value& packet) {
       << "p" << packet
       << ValueEnd{};
   sendPacketImpl_strand(data);
+  if (auto corpus = runtime_->getPacketCorpus()) {
+    corpus->record(data);
+  }
+  counters_.peakOutgoingQueueSize = std::max(counters_.peakOutgoingQueueSize, getPendingWriteSize_strand());
 
-  // if (processType_ == ProcessType::Daemon && runtime_->getProcessType() == ProcessType::Player) {
-  //   if (auto analytics = runtime_->getAnalytics()) {
-  //     analytics->samplePacketOutgoing(data.size());
-  //   }
-  // }
+  if (auto metrics = getMetrics_strand()) {
+    int packetType = packet["m"_int];
+    metrics->bytesOut->increment(data.size());
+    if (packetType >= 0 && packetType < static_cast<int>(SessionMetrics::MaxPacketType)) {
+      metrics->packetsOut[packetType]->increment();
+    }
+    metrics->outgoingQueueSize->set(static_cast<std::int64_t>(getPendingWriteSize_strand()));
+    metrics->coalescedUpdates->set(counters_.coalescedUpdates);
+    metrics->deferredUpdates->set(counters_.deferredUpdates);
+    metrics->outgoingQueueFull->set(counters_.outgoingQueueFull);
+  }
 
   sendTimestamp_ = std::chrono::system_clock::now();
   startHeartbeatInterval_strand();
@@ -203,20 +221,26 @@ void Session::sendPacket_strand(const Value& packet) {
 
 void Session::sendHandshake_strand() {
   LOG_ASSERT(!handshakeSent_);
+  auto schema = runtime_->getObjectSchema();
+  auto schemaValue = schema ? schema->toValue() : build_array() << ValueEnd{};
   if (runtime_->getProcessType() == ProcessType::Daemon) {
     auto processAddr = runtime_->getProcessAddr_safe();
     sendPacket_strand(Struct{}
         << "m" << static_cast<int>(Packet::Handshake)
+        << "pv" << ProtocolVersion
         << "pt" << static_cast<int>(runtime_->getProcessType())
         << "id" << runtime_->getProcessId().str()
         << "host" << processAddr.host
         << "port" << processAddr.port
+        << "os" << schemaValue
         << ValueEnd{});
   } else {
     sendPacket_strand(Struct{}
         << "m" << static_cast<int>(Packet::Handshake)
+        << "pv" << ProtocolVersion
         << "pt" << static_cast<int>(runtime_->getProcessType())
         << "id" << runtime_->getProcessId().str()
+        << "os" << schemaValue
         << ValueEnd{});
   }
   handshakeSent_ = true;
@@ -247,29 +271,29 @@ void Session::joinFederation_safe(ObjectId federationId) {
 
   std::weak_ptr<SessionFederate> federate_weak = federate;
 
-  federate->setObjectCallback([federate_weak, federationId](ObjectRef object) {
+  federate->setObjectCallback([federate_weak](ObjectRef object) {
     if (auto this_ = federate_weak.lock()) {
-      this_->objectCallback(federationId, object);
+      this_->objectCallback(object);
     }
   });
 
-  federate->setEventCallback([federate_weak, federationId](const char* eventName, const Value& params) {
+  federate->setEventCallback([federate_weak](const char* eventName, const Value& params) {
     if (auto this_ = federate_weak.lock()) {
-      this_->eventCallback(federationId, eventName, params);
+      this_->eventCallback(eventName, params);
     }
   });
 
   if (processType_ != ProcessType::Agent) {
-    federate->setServiceCallback([federate_weak, federationId](const char* service, const Value& params, const std::string& subjectId) {
+    federate->setServiceCallback([federate_weak](const char* service, const Value& params, const std::string& subjectId) {
       auto this_ = federate_weak.lock();
-      return this_ ? this_->serviceCallback(federationId, service, params, subjectId) : Promise<Value>{}.reject<Value>(Value{});
+      return this_ ? this_->serviceCallback(service, params, subjectId) : Promise<Value>{}.reject<Value>(Value{});
     });
   }
 
   if (processType_ != ProcessType::Agent && processType_ != ProcessType::Headup) {
-    federate->setOwnershipCallback([federate_weak, federationId](ObjectRef object, const Property& property, OwnershipNotification notification) {
+    federate->setOwnershipCallback([federate_weak](ObjectRef object, const Property& property, OwnershipNotification notification) {
       if (auto this_ = federate_weak.lock()) {
-        this_->ownershipCallback(federationId, object, property, notification);
+        this_->ownershipCallback(object, property, notification);
       }
     });
   } else {
@@ -285,14 +309,22 @@ void Session::joinFederation_safe(ObjectId federationId) {
       return;
     }
     federates_[federationId] = federate;
+
+    // the federation handle is sent in place of the federation id in every message
+    auto handle = federationHandles_.find(federationId);
+    if (handle == federationHandles_.end()) {
+      handle = federationHandles_.emplace(federationId, static_cast<int>(federationHandles_.size())).first;
+    }
+    federate->federationHandle_ = handle->second;
   }
 
-  strand_->setImmediate([this_ = shared_from_this(), federate_weak = federate->weak_from_this(), federationId]() {
+  strand_->post([this_ = shared_from_this(), federate_weak = federate->weak_from_this(), federationId, federationHandle = federate->getFederationHandle()]() {
     if (auto federate = federate_weak.lock()) {
       auto processAddr = this_->runtime_->getProcessAddr_safe();
       auto packet = Struct{}
           << "m" << static_cast<int>(Session::Packet::FederationProcessAdded)
           << "x" << federationId.str()
+          << "h" << federationHandle
           << "id" << this_->runtime_->getProcessId().str()
           << "type" << static_cast<int>(this_->runtime_->getProcessType())
           << "host" << processAddr.host
@@ -368,15 +400,59 @@ void Session::sendHostRequest_strand(ObjectId lobbyId, ObjectId matchId) {
 }
 
 
+/*
+ * Request ids are handed out in sequence, and all requests of a session
+ * have the same timeout, so the pending requests are kept in a table
+ * indexed by request id, and expire from the front.
+ */
 std::pair<int, Promise<Value>> Session::generateServiceRequest_strand() {
   std::lock_guard lock{mutex_};
-  int requestId = ++lastServiceRequestId_;
+  int requestId = firstServiceRequestId_ + static_cast<int>(serviceRequests_.size());
   Promise<Value> deferred;
-  serviceRequests_[requestId] = deferred;
+  serviceRequests_.push_back(PendingServiceRequest{deferred, std::chrono::system_clock::now() + serviceRequestTimeout_, true});
   return std::make_pair(requestId, deferred);
 }
 
 
+std::optional<Promise<Value>> Session::takeServiceRequest_unsafe(int requestId) {
+  auto index = requestId - firstServiceRequestId_;
+  if (index < 0 || index >= static_cast<int>(serviceRequests_.size()) || !serviceRequests_[index].pending) {
+    return std::nullopt;
+  }
+  auto result = std::move(serviceRequests_[index].deferred);
+  serviceRequests_[index].pending = false;
+  while (!serviceRequests_.empty() && !serviceRequests_.front().pending) {
+    serviceRequests_.pop_front();
+    ++firstServiceRequestId_;
+  }
+  return result;
+}
+
+
+/*
+ * Rejects the pending requests with a deadline at or before the given
+ * deadline, i.e. requests that have timed out, or all requests when the
+ * session shuts down. The promises are rejected after the session mutex
+ * is released.
+ */
+void Session::rejectServiceRequests_strand(std::chrono::system_clock::time_point deadline, int reasonCode, const char* reasonText) {
+  std::vector<Promise<Value>> rejected{};
+  std::unique_lock lock{mutex_};
+  while (!serviceRequests_.empty() && serviceRequests_.front().deadline <= deadline) {
+    if (serviceRequests_.front().pending) {
+      rejected.push_back(std::move(serviceRequests_.front().deferred));
+    }
+    serviceRequests_.pop_front();
+    ++firstServiceRequestId_;
+  }
+  lock.unlock();
+
+  for (auto& deferred : rejected) {
+    deferred.reject<Value>(REASON(reasonCode, reasonText)).done();
+  }
+}
+
+
 void Session::startHeartbeatInterval_strand() {
   if (!heartbeatInterval_) {
     heartbeatInterval_ = strand_->setInterval([weak_ = weak_from_this()]() {
@@ -385,7 +461,10 @@ void Session::startHeartbeatInterval_strand() {
           auto now = std::chrono::system_clock::now();
           if (this_->shouldShutdownDueToTimeout_strand(now)) {
             this_->shutdown().onResolve<void>([this_]() {}).done();
-          } else if (this_->shouldSendHeartbeat_strand(now)) {
+            return;
+          }
+          this_->rejectServiceRequests_strand(now, 408, "service request timed out");
+          if (this_->shouldSendHeartbeat_strand(now)) {
             this_->sendHeartbeat_strand();
           }
         }
@@ -477,6 +556,10 @@ void Session::onIncomingHandshake_strand(const Value& packet) {
 
 
 void Session::processHandshake_strand(const Value& packet) {
+  if (packet["pv"_int] != ProtocolVersion) {
+    LOG_E("Session::ProcessHandshake, protocol version %d, expected %d", packet["pv"_int], ProtocolVersion);
+    return;
+  }
   const auto processId = ObjectId::parse(packet["id"_c_str]);
   const auto processType = static_cast<ProcessType>(packet["pt"_int]);
   if (processType == ProcessType::Headup && runtime_->getProcessType_safe(processId) != ProcessType::Headup) {
@@ -490,6 +573,10 @@ void Session::processHandshake_strand(const Value& packet) {
   processId_ = processId;
   processType_ = processType;
 
+  if (auto schema = runtime_->getObjectSchema()) {
+    objectSchema_ = schema->agree(ObjectSchema::fromValue(packet["os"_value]));
+  }
+
   if (processType == ProcessType::Daemon) {
     if (const char* host = packet["host"_c_str]) {
       const char* port = packet["port"_c_str] ?: "";
@@ -531,11 +618,11 @@ void Session::onIncomingMessages_strand(const Value& packet) {
 
 void Session::dispatchMessage_strand(const Value& message) {
   int messageType = message["m"_int];
-  // if (processType_ == ProcessType::Daemon && runtime_->getProcessType() == ProcessType::Player) {
-  //   if (auto analytics = runtime_->getAnalytics()) {
-  //     analytics->sampleMessage(messageType);
-  //   }
-  // }
+  if (auto metrics = getMetrics_strand()) {
+    if (messageType >= 0 && messageType < static_cast<int>(SessionMetrics::MaxMessageType)) {
+      metrics->messagesIn[messageType]->increment();
+    }
+  }
   auto m = static_cast<Message>(messageType);
   switch (m) {
     case Message::ObjectChanges:
@@ -562,6 +649,11 @@ void Session::dispatchMessage_strand(const Value& message) {
     case Message::RoutingDisable:
       return onIncomingRoutingMessage_strand(message, m, OwnershipOperation::None);
 
+    case Message::InterestUpdate:
+      return onIncomingInterestUpdate_strand(message);
+    case Message::ObjectSnapshot:
+      return onIncomingObjectSnapshot_strand(message);
+
     default:
       return;
   }
@@ -594,48 +686,97 @@ static bool HasPrecedenceLessThan(ProcessType t1, ObjectId p1, ProcessType t2, O
 
 
 void Session::onIncomingObjectChanges_strand(const Value& message) {
-  const char* federationIdString = message["x"_c_str];
-  if (!federationIdString) {
-    return LOG_W("%s-%s Session::OnIncomingObjectChanges: missing federationId",
+  auto remoteFederation = findRemoteFederation_strand(message, "OnIncomingObjectChanges");
+  if (!remoteFederation) {
+    return;
+  }
+
+  auto& decoder = remoteFederation->objectChanges;
+  if (message["n"_bool]) {
+    decoder.reset();
+    decoder.setSchema(message["s"_bool] ? getObjectSchema_strand() : nullptr);
+  }
+
+  // decode before looking up the federate, to keep the decoder in sync with the encoder
+  const auto* changes = decoder.decode(message["b"_binary]);
+  if (!changes) {
+    return LOG_W("%s-%s Session::OnIncomingObjectChanges: invalid object changes",
         str(runtime_->getProcessType()),
         runtime_->getProcessId().str().c_str());
   }
-  auto federationId = ObjectId::parse(federationIdString);
 
-  auto federate = findFederate_strand(federationId);
+  auto federate = findFederate_strand(*remoteFederation);
   if (!federate) {
-    if (!isKnownFederation_safe(federationId)) {
+    if (!isKnownFederation_safe(remoteFederation->federationId)) {
       LOG_D("%s-%s Session::OnIncomingObjectChanges: federation/federate not found %s",
           str(runtime_->getProcessType()),
           runtime_->getProcessId().str().c_str(),
-          federationId.str().c_str());
+          remoteFederation->federationId.str().c_str());
+    }
+    return;
+  }
+
+  if (federate->shutdownStarted()) {
+    return;
+  }
+
+  applyObjectChanges_strand(*federate, *changes);
+}
+
+
+/*
+ * A snapshot is sent instead of separate object changes when a federate
+ * discovers many objects at once, typically when joining a running
+ * federation. All objects are applied in a single federate block.
+ */
+void Session::onIncomingObjectSnapshot_strand(const Value& message) {
+  auto remoteFederation = findRemoteFederation_strand(message, "OnIncomingObjectSnapshot");
+  if (!remoteFederation) {
+    return;
+  }
+
+  auto federate = findFederate_strand(*remoteFederation);
+  if (!federate) {
+    if (!isKnownFederation_safe(remoteFederation->federationId)) {
+      LOG_D("%s-%s Session::OnIncomingObjectSnapshot: federation/federate not found %s",
+          str(runtime_->getProcessType()),
+          runtime_->getProcessId().str().c_str(),
+          remoteFederation->federationId.str().c_str());
     }
     return;
   }
 
-  const char* objectClass = message["c"_c_str];
-  if (!objectClass) {
-    return LOG_W("%s-%s Session::OnIncomingObjectChanges: objectClass not found",
+  if (federate->shutdownStarted()) {
+    return;
+  }
+
+  Federate::BatchScope batch{*federate};
+  ObjectChangesDecoder decoder{};
+  decoder.setSchema(message["s"_bool] ? getObjectSchema_strand() : nullptr);
+  bool valid = decoder.decodeSnapshot(message["b"_binary], [this, &federate](const ObjectChangesMessage& changes) {
+    applyObjectChanges_strand(*federate, changes);
+  });
+  if (!valid) {
+    LOG_W("%s-%s Session::OnIncomingObjectSnapshot: invalid object snapshot",
         str(runtime_->getProcessType()),
         runtime_->getProcessId().str().c_str());
   }
+}
+
 
-  auto objectId = message["i"_ObjectId];
+void Session::applyObjectChanges_strand(Federate& federate, const ObjectChangesMessage& changes) {
+  const char* objectClass = changes.objectClass;
+  auto objectId = changes.objectId;
   if (!objectId) {
     return LOG_W("%s-%s Session::OnIncomingObjectChanges: missing objectId",
         str(runtime_->getProcessType()),
         runtime_->getProcessId().str().c_str());
   }
 
-  if (federate->shutdownStarted()) {
-    return;
-  }
-
-  auto objectChange = static_cast<ObjectChange>(message["t"_int]);
-  if (objectChange == ObjectChange::Delete) {
-    if (auto object = federate->getObject(objectId)) {
+  if (changes.change == ObjectChange::Delete) {
+    if (auto object = federate.getObject(objectId)) {
       if (!object.canDelete()) {
-        if (!federate->ownershipPolicy(Property::Destructor_str)) {
+        if (!federate.ownershipPolicy(Property::Destructor_str)) {
           return LOG_W("Spurious object delete blocked from session: %s (%s)", objectClass, objectId.str().c_str());
         }
         auto& property = object[Property::Destructor_cstr];
@@ -650,24 +791,27 @@ void Session::onIncomingObjectChanges_strand(const Value& message) {
       }
     }
   } else {
-    auto object = federate->getObject(objectId) ?: federate->getObjectClass(objectClass).create(objectId);
-    for (auto& p : message["p"]) {
-      auto& property = object[p.name()];
-      auto processId = p["p"_ObjectId];
-      if (property.canSetValue() || tryAutoCorrectRouting(*federate, federationIdString, objectId, property, processId)) {
-        double delay = p["t"_double] - latencyTracker_.getLatency();
-        property.setValue(p["v"_value], delay, this, processId);
+    auto object = federate.getObject(objectId);
+    if (!object) {
+      object = federate.getObjectClass(objectClass).create(objectId);
+    }
+    for (const auto& p : changes.properties) {
+      auto& property = object[p.propertyName];
+      if (property.canSetValue() || tryAutoCorrectRouting(federate, objectId, property, p.processId)) {
+        double delay = p.time - latencyTracker_.getLatency();
+        property.setValue(p.value, delay, this, p.processId);
       }
     }
   }
 }
 
 
-bool Session::tryAutoCorrectRouting(Federate& federate, const char* federationId, ObjectId objectId, Property& property, ObjectId processId) {
+bool Session::tryAutoCorrectRouting(Federate& federate, ObjectId objectId, Property& property, ObjectId processId) {
+  auto& sessionFederate = dynamic_cast<SessionFederate&>(federate);
   if (property.session_ != this && processId == property.processId_) {
-    dynamic_cast<SessionFederate&>(federate).enqueueMessage(Struct{}
+    sessionFederate.enqueueMessage(Struct{}
         << "m" << static_cast<std::int32_t>(Session::Message::RoutingDisable)
-        << "x" << federationId
+        << "x" << sessionFederate.getFederationHandle()
         << "i" << objectId
         << "p" << property.getName()
         << ValueEnd{});
@@ -678,9 +822,9 @@ bool Session::tryAutoCorrectRouting(Federate& federate, const char* federationId
     if (spurious) {
       LOG_W("Spurious object update blocked from session: %s", property.getName().c_str());
     }
-    dynamic_cast<SessionFederate&>(federate).enqueueMessage(Struct{}
+    sessionFederate.enqueueMessage(Struct{}
         << "m" << static_cast<std::int32_t>(Session::Message::RoutingEnableUpstream)
-        << "x" << federationId
+        << "x" << sessionFederate.getFederationHandle()
         << "i" << objectId
         << "p" << property.getName()
         << ValueEnd{});
@@ -703,17 +847,14 @@ void Session::onIncomingEvent_strand(const Value& message) {
         runtime_->getProcessId().str().c_str());
   }
 
-  const char* federationIdString = message["x"_c_str];
-  if (!federationIdString) {
-    return LOG_W("%s-%s Session::OnIncomingEvent: missing federationId",
-        str(runtime_->getProcessType()),
-        runtime_->getProcessId().str().c_str());
+  auto remoteFederation = findRemoteFederation_strand(message, "OnIncomingEvent");
+  if (!remoteFederation) {
+    return;
   }
 
-  auto federationId = ObjectId::parse(federationIdString);
-  auto federate = findFederate_strand(federationId);
+  auto federate = findFederate_strand(*remoteFederation);
   if (!federate) {
-    if (!isKnownFederation_safe(federationId)) {
+    if (!isKnownFederation_safe(remoteFederation->federationId)) {
       LOG_D("%s-%s Session::OnIncomingEvent: federation/federate not found",
           str(runtime_->getProcessType()),
           runtime_->getProcessId().str().c_str());
@@ -749,19 +890,16 @@ Promise<void> Session::onIncomingServiceRequest_strand(Value message) {
         runtime_->getProcessId().str().c_str());
   }
 
-  const char* federationIdString = message["x"_c_str];
-  if (!federationIdString) {
+  auto remoteFederation = findRemoteFederation_strand(message, "OnIncomingServiceRequest");
+  if (!remoteFederation) {
     sendPacket_strand(makeRejectPacket(requestId, 400, "missing federationId"));
-    co_return LOG_W("%s-%s Session::OnIncomingServiceRequest: missing federationId",
-        str(runtime_->getProcessType()),
-        runtime_->getProcessId().str().c_str());
+    co_return;
   }
 
-  auto federationId = ObjectId::parse(federationIdString);
-  auto federate = std::static_pointer_cast<SessionFederate>(findFederate_strand(federationId));
+  auto federate = std::static_pointer_cast<SessionFederate>(findFederate_strand(*remoteFederation));
   if (!federate) {
     sendPacket_strand(makeRejectPacket(requestId, 404, "federation/federate not found"));
-    if (!isKnownFederation_safe(federationId)) {
+    if (!isKnownFederation_safe(remoteFederation->federationId)) {
       LOG_D("%s-%s Session::OnIncomingServiceRequest: federation/federate not found",
           str(runtime_->getProcessType()),
           runtime_->getProcessId().str().c_str());
@@ -811,52 +949,46 @@ Value Session::makeRejectPacket(int requestId, int reasonCode, const char* reaso
 
 
 void Session::onIncomingServiceFulfill_strand(const Value& message) {
-  std::lock_guard lock{mutex_};
   int requestId = message["r"_int];
-  auto i = serviceRequests_.find(requestId);
-  if (i == serviceRequests_.end()) {
+  std::unique_lock lock{mutex_};
+  auto deferred = takeServiceRequest_unsafe(requestId);
+  lock.unlock();
+  if (!deferred) {
     return LOG_W("%s-%s Session::OnIncomingServiceFulfill: requestId %d not found",
         str(runtime_->getProcessType()),
         runtime_->getProcessId().str().c_str(),
         requestId);
   }
 
-  i->second.resolve(message["v"_value]).done();
-  serviceRequests_.erase(requestId);
+  deferred->resolve(message["v"_value]).done();
 }
 
 
 void Session::onIncomingServiceReject_strand(const Value& message) {
-  std::lock_guard lock{mutex_};
   int requestId = message["r"_int];
-  auto i = serviceRequests_.find(requestId);
-  if (i == serviceRequests_.end()) {
+  std::unique_lock lock{mutex_};
+  auto deferred = takeServiceRequest_unsafe(requestId);
+  lock.unlock();
+  if (!deferred) {
     return LOG_W("%s-%s Session::OnIncomingServiceReject: requestId %d not found",
         str(runtime_->getProcessType()),
         runtime_->getProcessId().str().c_str(),
         requestId);
   }
 
-  i->second.reject<Value>(message["v"_value]).done();
-  serviceRequests_.erase(requestId);
+  deferred->reject<Value>(message["v"_value]).done();
 }
 
 
 void Session::onIncomingRoutingMessage_strand(const Value& message, Message msg, OwnershipOperation operation) {
-  const char* federationIdString = message["x"_c_str];
-  if (!federationIdString) {
-    return LOG_W("%s-%s Session::OnIncomingRoutingMessage: missing federationId",
-        str(runtime_->getProcessType()),
-        runtime_->getProcessId().str().c_str());
-  }
-
-  auto federationId = ObjectId::parse(federationIdString);
-  if (!federationId && processType_ != ProcessType::Headup) {
-    return LOG_W("%s-%s Session::OnIncomingRoutingMessage: invalid federationId",
-        str(runtime_->getProcessType()),
-        runtime_->getProcessId().str().c_str());
+  auto remoteFederation = findRemoteFederation_strand(message, "OnIncomingRoutingMessage");
+  if (!remoteFederation) {
+    return;
   }
 
+  // the system federation only has a handle if the remote process is
+  // local, see onIncomingFederationProcessAdded_strand
+  auto federationId = remoteFederation->federationId;
   auto federate = getSessionFederate_safe(federationId);
   if (!federate) {
     if (!isKnownFederation_safe(federationId)) {
@@ -893,7 +1025,7 @@ void Session::onIncomingRoutingMessage_strand(const Value& message, Message msg,
       && federate->getFederation()->getExclusiveOwner()
       && federate->getFederation()->getExclusiveOwner() != federate;
   if (forcedOwnershipAcquisitionBlocked) {
-    federate->ownershipCallback(federationId, object, property, OwnershipNotification::OwnershipUnavailable);
+    federate->ownershipCallback(object, property, OwnershipNotification::OwnershipUnavailable);
     return LOG_ASSERT(!forcedOwnershipAcquisitionBlocked);
   }
 
@@ -945,6 +1077,21 @@ void Session::onIncomingRoutingMessage_strand(const Value& message, Message msg,
 }
 
 
+void Session::onIncomingInterestUpdate_strand(const Value& message) {
+  auto remoteFederation = findRemoteFederation_strand(message, "OnIncomingInterestUpdate");
+  if (!remoteFederation) {
+    return;
+  }
+
+  auto federate = findFederate_strand(*remoteFederation);
+  if (!federate || federate->shutdownStarted()) {
+    return;
+  }
+
+  std::static_pointer_cast<SessionFederate>(federate)->setCameraPosition(message["c"_vec2]);
+}
+
+
 void Session::onIncomingFederationProcessAdded_strand(const Value& packet) {
   auto processId = ObjectId::parse(packet["id"_c_str]);
   if (!runtime_->registerProcess_safe(processId, static_cast<ProcessType>(packet["type"_int]), nullptr)) {
@@ -967,6 +1114,25 @@ void Session::onIncomingFederationProcessAdded_strand(const Value& packet) {
         runtime_->getProcessId().str().c_str());
   }
 
+  auto handle = packet["h"];
+  if (handle.is_int32()) {
+    auto index = handle._int32();
+    if (index < 0) {
+      return LOG_W("%s-%s Session::OnIncomingFederationProcessAdded: invalid federation handle",
+          str(runtime_->getProcessType()),
+          runtime_->getProcessId().str().c_str());
+    }
+    if (index >= static_cast<int>(remoteFederations_.size())) {
+      remoteFederations_.resize(index + 1);
+    }
+    auto& remoteFederation = remoteFederations_[index];
+    if (!remoteFederation) {
+      remoteFederation = std::make_unique<RemoteFederation>();
+    }
+    remoteFederation->federationId = federationId;
+    remoteFederation->federate.reset();
+  }
+
   auto processAddr = ProcessAddr{packet["host"_c_str] ?: "", packet["port"_c_str] ?: ""};
   if (!processAddr.host.empty()) {
     runtime_->registerProcessAddr_safe(processId, processAddr.host.c_str(), processAddr.port.c_str());
@@ -1072,6 +1238,8 @@ void Session::trySendOutgoingPacket_strand(const Value& packet) {
 void Session::enqueueOutgoingPacket_strand(const Value& packet) {
   std::lock_guard lock{mutex_};
   outgoingPacketQueue_.push_back(packet);
+  outgoingPacketQueueSize_ += packet.size();
+  counters_.peakOutgoingQueueSize = std::max(counters_.peakOutgoingQueueSize, outgoingPacketQueueSize_);
 }
 
 
@@ -1079,11 +1247,162 @@ void Session::emptyOutgoingPacketQueue_strand() {
   std::vector<Value> queue{};
   std::unique_lock lock{mutex_};
   std::swap(queue, outgoingPacketQueue_);
+  outgoingPacketQueueSize_ = 0;
   lock.unlock();
 
   for (const Value& packet : queue) {
     sendPacket_strand(packet);
   }
+  outgoingQueueDrained_strand();
+}
+
+
+/*
+ * Series are labeled with the local and the remote process, which is
+ * known after the handshake, and removed when the session is shut down.
+ * Runtimes sharing a registry (e.g. in the load generator) then never
+ * remove each other's series. The connection ordinal keeps a session
+ * that is still shutting down when its peer reconnects from removing
+ * the series of the new session.
+ */
+SessionMetrics* Session::getMetrics_strand() {
+  static_assert(SessionMetrics::MaxPacketType == static_cast<std::size_t>(Packet::FederationHostingRequest) + 1);
+  static_assert(SessionMetrics::MaxMessageType == static_cast<std::size_t>(Message::ObjectSnapshot) + 1);
+  if (!metrics_ && processType_ != ProcessType::None && !shutdownStarted()) {
+    if (auto metrics = runtime_->getMetrics()) {
+      metrics_ = std::make_unique<SessionMetrics>();
+      auto& labels = metrics_->labels;
+      labels = makeString("process=\"%s\",session=\"%s\",peer=\"%s\",connection=\"%d\"",
+          runtime_->getProcessId().str().c_str(),
+          processId_.str().c_str(),
+          str(processType_),
+          ++lastMetricsOrdinal);
+      metrics_->bytesIn = &metrics->counter("warstage_session_received_bytes_total", labels);
+      metrics_->bytesOut = &metrics->counter("warstage_session_sent_bytes_total", labels);
+      metrics_->compressorIn = &metrics->counter("warstage_session_compressor_input_bytes_total", labels);
+      metrics_->compressorOut = &metrics->counter("warstage_session_compressor_output_bytes_total", labels);
+      metrics_->compressionRatio = &metrics->histogram("warstage_session_compression_ratio", labels, {1.0, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0});
+      metrics_->outgoingQueueSize = &metrics->gauge("warstage_session_outgoing_queue_bytes", labels);
+      metrics_->coalescedUpdates = &metrics->counter("warstage_session_coalesced_updates_total", labels);
+      metrics_->deferredUpdates = &metrics->counter("warstage_session_deferred_updates_total", labels);
+      metrics_->outgoingQueueFull = &metrics->counter("warstage_session_outgoing_queue_full_total", labels);
+      for (std::size_t i = 0; i != SessionMetrics::MaxPacketType; ++i) {
+        auto packetLabels = labels + makeString(",packet=\"%s\"", packetToString(static_cast<Packet>(i)));
+        metrics_->packetsIn[i] = &metrics->counter("warstage_session_received_packets_total", packetLabels);
+        metrics_->packetsOut[i] = &metrics->counter("warstage_session_sent_packets_total", packetLabels);
+      }
+      for (std::size_t i = 0; i != SessionMetrics::MaxMessageType; ++i) {
+        auto messageLabels = labels + makeString(",message=\"%s\"", messageToString(static_cast<Message>(i)));
+        metrics_->messagesIn[i] = &metrics->counter("warstage_session_received_messages_total", messageLabels);
+        metrics_->messagesOut[i] = &metrics->counter("warstage_session_sent_messages_total", messageLabels);
+      }
+    }
+  }
+  return metrics_.get();
+}
+
+
+void Session::releaseMetrics_strand() {
+  if (metrics_) {
+    if (auto metrics = runtime_->getMetrics()) {
+      metrics->removeLabels(metrics_->labels);
+    }
+    metrics_ = nullptr;
+  }
+}
+
+
+void Session::sampleOutgoingMessage_strand(int messageType) {
+  if (auto metrics = getMetrics_strand()) {
+    if (messageType >= 0 && messageType < static_cast<int>(SessionMetrics::MaxMessageType)) {
+      metrics->messagesOut[messageType]->increment();
+    }
+  }
+}
+
+
+void Session::sampleCompressor_strand(std::size_t inputSize, std::size_t outputSize) {
+  if (auto metrics = getMetrics_strand()) {
+    metrics->compressorIn->increment(inputSize);
+    metrics->compressorOut->increment(outputSize);
+    if (outputSize) {
+      metrics->compressionRatio->observe(static_cast<double>(inputSize) / static_cast<double>(outputSize));
+    }
+  }
+}
+
+
+/*
+ * While the queued outgoing data is over the byte budget, session
+ * federates hold back object updates, and send only the latest value
+ * of each property when the queue has drained. Events and service
+ * messages are always queued in order.
+ */
+bool Session::isOutgoingQueueFull_strand() {
+  std::unique_lock lock{mutex_};
+  auto size = outgoingPacketQueueSize_;
+  lock.unlock();
+
+  bool full = size + getPendingWriteSize_strand() > outgoingByteBudget_;
+  if (full && !outgoingQueueFull_) {
+    ++counters_.outgoingQueueFull;
+  }
+  outgoingQueueFull_ = full;
+  return full;
+}
+
+
+void Session::outgoingQueueDrained_strand() {
+  if (!outgoingQueueFull_ || isOutgoingQueueFull_strand()) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<Federate>> federates{};
+  std::unique_lock lock{mutex_};
+  for (const auto& i : federates_) {
+    if (i.second) { // null for a federation left within FederationForgetTimeout
+      federates.push_back(i.second);
+    }
+  }
+  lock.unlock();
+
+  for (const auto& federate : federates) {
+    if (!federate->shutdownStarted()) {
+      std::static_pointer_cast<SessionFederate>(federate)->sendDeferredObjects();
+    }
+  }
+}
+
+
+RemoteFederation* Session::findRemoteFederation_strand(const Value& message, const char* method) {
+  auto handle = message["x"];
+  if (!handle.is_int32()) {
+    LOG_W("%s-%s Session::%s: missing federationId",
+        str(runtime_->getProcessType()),
+        runtime_->getProcessId().str().c_str(),
+        method);
+    return nullptr;
+  }
+  auto index = handle._int32();
+  if (index < 0 || index >= static_cast<int>(remoteFederations_.size()) || !remoteFederations_[index]) {
+    LOG_W("%s-%s Session::%s: unknown federation handle %d",
+        str(runtime_->getProcessType()),
+        runtime_->getProcessId().str().c_str(),
+        method,
+        index);
+    return nullptr;
+  }
+  return remoteFederations_[index].get();
+}
+
+
+std::shared_ptr<Federate> Session::findFederate_strand(RemoteFederation& remoteFederation) {
+  auto federate = remoteFederation.federate.lock();
+  if (!federate || federate->shutdownStarted()) {
+    federate = findFederate_strand(remoteFederation.federationId);
+    remoteFederation.federate = federate;
+  }
+  return federate;
 }
 
 
@@ -1118,15 +1437,34 @@ char Session::getDoNotDistributePrefix_strand() const {
 }
 
 
-void Session::onProcessAuthenticated_main(ObjectId processId, const ProcessAuth& processAuth) {
+void Session::onProcessAuthenticated_strand(ObjectId processId, const ProcessAuth& processAuth) {
   if (processId == runtime_->getProcessId() && !processAuth.accessToken.empty()) {
-    strand_->setImmediate([this_ = shared_from_this(), processAuth] () {
-      this_->sendAuthenticate_strand(processAuth);
-    });
+    sendAuthenticate_strand(processAuth);
   }
 }
 
 
+const char* Session::packetToString(Session::Packet packet) {
+  switch (packet) {
+    case Session::Packet::Heartbeat:
+      return "Heartbeat";
+    case Session::Packet::Handshake:
+      return "Handshake";
+    case Session::Packet::Authenticate:
+      return "Authenticate";
+    case Session::Packet::Messages:
+      return "Messages";
+    case Session::Packet::FederationProcessAdded:
+      return "FederationProcessAdded";
+    case Session::Packet::FederationProcessRemoved:
+      return "FederationProcessRemoved";
+    case Session::Packet::FederationHostingRequest:
+      return "FederationHostingRequest";
+  }
+  return "?";
+}
+
+
 const char* Session::messageToString(Session::Message message) {
   switch (message) {
     case Session::Message::None:
@@ -1153,5 +1491,10 @@ const char* Session::messageToString(Session::Message message) {
       return "RoutingUpstreamDenied";
     case Session::Message::RoutingDisable:
       return "RoutingDisable";
+    case Session::Message::InterestUpdate:
+      return "InterestUpdate";
+    case Session::Message::ObjectSnapshot:
+      return "ObjectSnapshot";
   }
+  return "?";
 }
@@ -5,11 +5,19 @@
 #define WARSTAGE__RUNTIME__SESSION_H
 
 #include "./federate.h"
+#include "./object-changes.h"
+#include "./object-schema.h"
 #include "./runtime.h"
 #include "async/shutdownable.h"
-#include <map>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <optional>
 
 class Endpoint;
+class MetricsCounter;
+class MetricsGauge;
+class MetricsHistogram;
 class Session;
 class SessionFederate;
 
@@ -39,6 +47,45 @@ private:
 };
 
 
+// A federation as known by the remote process, indexed
+// by the federation handle assigned by the remote process.
+struct RemoteFederation {
+  ObjectId federationId{};
+  std::weak_ptr<Federate> federate{};
+  ObjectChangesDecoder objectChanges{};
+};
+
+
+// Backpressure counters, sampled by metrics and debug logging.
+struct SessionCounters {
+  std::uint64_t coalescedUpdates{}; // property updates replaced by a newer value before being sent
+  std::uint64_t deferredUpdates{}; // object updates held back while the outgoing queue was full
+  std::uint64_t outgoingQueueFull{}; // times the outgoing queue went over the byte budget
+  std::size_t peakOutgoingQueueSize{};
+};
+
+
+// Metrics series of a session, resolved when the remote process is known.
+struct SessionMetrics {
+  static constexpr std::size_t MaxPacketType = 7; // Session::Packet::FederationHostingRequest + 1
+  static constexpr std::size_t MaxMessageType = 14; // Session::Message::ObjectSnapshot + 1
+  std::string labels{};
+  MetricsCounter* bytesIn{};
+  MetricsCounter* bytesOut{};
+  MetricsCounter* compressorIn{};
+  MetricsCounter* compressorOut{};
+  MetricsHistogram* compressionRatio{};
+  MetricsGauge* outgoingQueueSize{};
+  MetricsCounter* coalescedUpdates{};
+  MetricsCounter* deferredUpdates{};
+  MetricsCounter* outgoingQueueFull{};
+  std::array<MetricsCounter*, MaxPacketType> packetsIn{};
+  std::array<MetricsCounter*, MaxPacketType> packetsOut{};
+  std::array<MetricsCounter*, MaxMessageType> messagesIn{};
+  std::array<MetricsCounter*, MaxMessageType> messagesOut{};
+};
+
+
 class Session :
     public RuntimeObserver,
     public Shutdownable,
@@ -54,6 +101,10 @@ protected:
   static constexpr std::chrono::duration HeartbeatInterval = std::chrono::milliseconds{1000};
   static constexpr int FederationForgetTimeout = 15 * 1000; // milliseconds
 
+  // Sent in the handshake. A handshake with a different version, or
+  // none, is ignored, as the peers would misread each other's messages.
+  static constexpr int ProtocolVersion = 1;
+
   enum class Packet {
     Heartbeat = 0,
     Handshake = 1,
@@ -76,7 +127,9 @@ protected:
     RoutingRequestUpstream = 9,
     RoutingEnableUpstream = 10,
     RoutingUpstreamDenied = 8,
-    RoutingDisable = 11
+    RoutingDisable = 11,
+    InterestUpdate = 12,
+    ObjectSnapshot = 13
   };
 
 protected:
@@ -90,12 +143,26 @@ private:
   ProcessType processType_{};
   std::string subjectId_{};
 
-  std::map<int, Promise<Value>> serviceRequests_{};
-  int lastServiceRequestId_{};
+  struct PendingServiceRequest {
+    Promise<Value> deferred;
+    std::chrono::system_clock::time_point deadline;
+    bool pending{};
+  };
+  std::deque<PendingServiceRequest> serviceRequests_{}; // _mutex, at requestId - firstServiceRequestId_
+  int firstServiceRequestId_{1}; // _mutex
+  std::chrono::milliseconds serviceRequestTimeout_{};
   std::unordered_map<ObjectId, std::shared_ptr<Federate>> federates_{}; // _mutex
+  std::unordered_map<ObjectId, int> federationHandles_{}; // _mutex
+  std::vector<std::unique_ptr<RemoteFederation>> remoteFederations_{}; // _strand
   std::vector<Value> outgoingPacketQueue_{};
+  std::size_t outgoingPacketQueueSize_{};
+  std::size_t outgoingByteBudget_{};
+  bool outgoingQueueFull_{};
+  SessionCounters counters_{};
+  std::unique_ptr<SessionMetrics> metrics_{}; // strand
   bool connected_{};
   bool handshakeSent_{};
+  ObjectSchema objectSchema_{}; // strand, agreed in the handshake
   std::mutex mutex_{};
   LatencyTracker latencyTracker_{};
   std::shared_ptr<IntervalObject> heartbeatInterval_{};
@@ -115,12 +182,25 @@ public:
   [[nodiscard]] Strand_base& getStrand() const { return *strand_; }
   [[nodiscard]] SessionFederate* getSessionFederate_safe(ObjectId federationId);
 
+  void setOutgoingByteBudget(std::size_t value) { outgoingByteBudget_ = value; }
+  [[nodiscard]] const SessionCounters& getCounters_strand() const { return counters_; }
+
 protected:
   void receivePacket_strand(const Value& packet);
   void sendPacket_strand(const Value& packet);
 
   virtual void sendPacketImpl_strand(const Value& packet) = 0;
+  [[nodiscard]] virtual std::size_t getPendingWriteSize_strand() { return 0; }
+
+  void outgoingQueueDrained_strand();
+
+  [[nodiscard]] SessionMetrics* getMetrics_strand();
+  void releaseMetrics_strand();
+  void sampleOutgoingMessage_strand(int messageType);
+  void sampleCompressor_strand(std::size_t inputSize, std::size_t outputSize);
 
+  [[nodiscard]] bool isHandshakeSent_strand() const { return handshakeSent_; }
+  [[nodiscard]] const ObjectSchema* getObjectSchema_strand() const { return objectSchema_.empty() ? nullptr : &objectSchema_; }
   void sendHandshake_strand();
 
 private:
@@ -132,6 +212,8 @@ private:
   void sendHostRequest_strand(ObjectId lobbyId, ObjectId matchId);
 
   [[nodiscard]] std::pair<int, Promise<Value>> generateServiceRequest_strand();
+  [[nodiscard]] std::optional<Promise<Value>> takeServiceRequest_unsafe(int requestId);
+  void rejectServiceRequests_strand(std::chrono::system_clock::time_point deadline, int reasonCode, const char* reasonText);
 
   void startHeartbeatInterval_strand();
   void stopHeartbeatInterval_strand();
@@ -147,7 +229,9 @@ private:
   void onIncomingMessages_strand(const Value& packet);
   void dispatchMessage_strand(const Value& message);
   void onIncomingObjectChanges_strand(const Value& message);
-  bool tryAutoCorrectRouting(Federate& federate, const char* federationId, ObjectId objectId, Property& property, ObjectId processId);
+  void onIncomingObjectSnapshot_strand(const Value& message);
+  void applyObjectChanges_strand(Federate& federate, const ObjectChangesMessage& changes);
+  bool tryAutoCorrectRouting(Federate& federate, ObjectId objectId, Property& property, ObjectId processId);
 
   void onIncomingEvent_strand(const Value& message);
 
@@ -156,6 +240,7 @@ private:
   void onIncomingServiceFulfill_strand(const Value& message);
   void onIncomingServiceReject_strand(const Value& message);
   void onIncomingRoutingMessage_strand(const Value& message, Message msg, OwnershipOperation operation);
+  void onIncomingInterestUpdate_strand(const Value& message);
 
   void onIncomingFederationProcessAdded_strand(const Value& packet);
   void onIncomingFederationProcessRemoved_strand(const Value& packet);
@@ -164,15 +249,19 @@ private:
   void trySendOutgoingPacket_strand(const Value& packet);
   void enqueueOutgoingPacket_strand(const Value& packet);
   void emptyOutgoingPacketQueue_strand();
+  [[nodiscard]] bool isOutgoingQueueFull_strand();
 
+  [[nodiscard]] RemoteFederation* findRemoteFederation_strand(const Value& message, const char* method);
+  [[nodiscard]] std::shared_ptr<Federate> findFederate_strand(RemoteFederation& remoteFederation);
   [[nodiscard]] std::shared_ptr<Federate> findFederate_strand(ObjectId federationId);
   [[nodiscard]] bool isKnownFederation_safe(ObjectId federationId);
 
   char getDoNotDistributePrefix_strand() const;
 
 protected:
-  void onProcessAuthenticated_main(ObjectId processId, const ProcessAuth& processAuth) override;
+  void onProcessAuthenticated_strand(ObjectId processId, const ProcessAuth& processAuth) override;
 
+  [[nodiscard]] static const char* packetToString(Packet packet);
   [[nodiscard]] static const char* messageToString(Message message);
 };
 
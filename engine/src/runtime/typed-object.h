@@ -0,0 +1,176 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__RUNTIME__TYPED_OBJECT_H
+#define WARSTAGE__RUNTIME__TYPED_OBJECT_H
+
+#include "./object.h"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+// A typed schema declares the properties of an object class as members
+// of a plain struct, by specializing TypedSchema for the struct:
+//
+//   struct CameraState {
+//     glm::vec3 position{};
+//     float facing{};
+//   };
+//
+//   template <> struct TypedSchema<CameraState> {
+//     static constexpr auto properties = std::make_tuple(
+//         typedProperty("position", &CameraState::position),
+//         typedProperty("facing", &CameraState::facing));
+//   };
+//
+// A TypedObject then keeps the property values of an object decoded in
+// the struct, and only decodes a property again when its version has
+// changed. Properties are still stored and synchronized as values, so
+// processes without the schema see an ordinary dynamic object.
+
+template <typename T> struct TypedSchema;
+
+template <typename T, typename M> struct TypedProperty {
+  const char* name;
+  M T::* member;
+};
+
+template <typename T, typename M>
+constexpr TypedProperty<T, M> typedProperty(const char* name, M T::* member) {
+  return {name, member};
+}
+
+
+template <typename M> struct TypedMember;
+template <typename T, typename M> struct TypedMember<M T::*> {
+  using type = M;
+};
+
+
+template <typename M> void decodeTypedValue(const ValueBase& value, M& result) {
+  result = value.cast<M>();
+}
+
+inline void decodeTypedValue(const ValueBase& value, std::string& result) {
+  auto s = value._c_str();
+  result = s ? s : "";
+}
+
+
+namespace typed_object_detail {
+  template <typename T> constexpr std::size_t count() {
+    return std::tuple_size_v<std::decay_t<decltype(TypedSchema<T>::properties)>>;
+  }
+
+  template <auto A, auto B> constexpr bool sameMember() {
+    if constexpr (std::is_same_v<decltype(A), decltype(B)>) {
+      return A == B;
+    } else {
+      return false;
+    }
+  }
+
+  template <typename T, auto Member, std::size_t I = 0> constexpr std::size_t index() {
+    if constexpr (I == count<T>()) {
+      static_assert(I != count<T>(), "member is not a property in the typed schema");
+      return I;
+    } else if constexpr (sameMember<std::get<I>(TypedSchema<T>::properties).member, Member>()) {
+      return I;
+    } else {
+      return index<T, Member, I + 1>();
+    }
+  }
+}
+
+
+template <typename T> class TypedObject {
+  static constexpr std::size_t Count = typed_object_detail::count<T>();
+
+  ObjectRef object_{};
+  mutable T value_{};
+  mutable std::array<Property*, Count> properties_{};
+  mutable std::array<int, Count> versions_{};
+
+public:
+  TypedObject() = default;
+  explicit TypedObject(ObjectRef object) : object_{std::move(object)} {
+    versions_.fill(-1);
+  }
+
+  explicit operator bool() const { return static_cast<bool>(object_); }
+  bool operator!() const { return !object_; }
+
+  [[nodiscard]] const ObjectRef& getObject() const { return object_; }
+
+  // AssertFederateStrand, decodes the properties changed since the last call
+  [[nodiscard]] const T& get() const {
+    refresh(std::make_index_sequence<Count>{});
+    return value_;
+  }
+
+  template <auto Member> [[nodiscard]] const typename TypedMember<decltype(Member)>::type& get() const {
+    refresh<typed_object_detail::index<T, Member>()>();
+    return value_.*Member;
+  }
+
+  template <auto Member> [[nodiscard]] Property& getProperty() {
+    return property<typed_object_detail::index<T, Member>()>();
+  }
+
+  /*
+   * Assigns the property like Property::operator= does, but compares
+   * with the decoded value first so unchanged values are neither
+   * encoded nor synchronized. The decoded value is only updated if the
+   * property accepted the assignment (see Property::setValue).
+   */
+  template <auto Member> void set(const typename TypedMember<decltype(Member)>::type& value) {
+    constexpr auto I = typed_object_detail::index<T, Member>();
+    refresh<I>();
+    if (versions_[I] > 0 && value_.*Member == value) {
+      return;
+    }
+    auto& p = property<I>();
+    p = value;
+    if (int version = p.getVersion(); version != versions_[I]) {
+      versions_[I] = version;
+      value_.*Member = value;
+    }
+  }
+
+  void set(const T& value) {
+    set(value, std::make_index_sequence<Count>{});
+  }
+
+private:
+  template <std::size_t I> Property& property() const {
+    auto& result = properties_[I];
+    if (!result) {
+      auto object = object_;
+      result = &object[std::get<I>(TypedSchema<T>::properties).name];
+    }
+    return *result;
+  }
+
+  template <std::size_t I> void refresh() const {
+    auto& p = property<I>();
+    if (int version = p.getVersion(); version != versions_[I]) {
+      versions_[I] = version;
+      decodeTypedValue(p.getValue(), value_.*std::get<I>(TypedSchema<T>::properties).member);
+    }
+  }
+
+  template <std::size_t... I> void refresh(std::index_sequence<I...>) const {
+    (refresh<I>(), ...);
+  }
+
+  template <std::size_t... I> void set(const T& value, std::index_sequence<I...>) {
+    (set<std::get<I>(TypedSchema<T>::properties).member>(value.*std::get<I>(TypedSchema<T>::properties).member), ...);
+  }
+};
+
+
+#endif
@@ -0,0 +1,84 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "runtime-fixture.h"
+#include "runtime/typed-object.h"
+
+namespace {
+    struct FooState {
+        int bar{};
+        float baz{};
+        bool flag{};
+        glm::vec2 position{};
+        ObjectId target{};
+        std::string name{};
+    };
+}
+
+template <> struct TypedSchema<FooState> {
+    static constexpr auto properties = std::make_tuple(
+            typedProperty("bar", &FooState::bar),
+            typedProperty("baz", &FooState::baz),
+            typedProperty("flag", &FooState::flag),
+            typedProperty("position", &FooState::position),
+            typedProperty("target", &FooState::target),
+            typedProperty("name", &FooState::name));
+};
+
+BOOST_AUTO_TEST_SUITE(runtime_typed_object)
+
+    BOOST_AUTO_TEST_CASE(should_synchronize_typed_properties) {
+        LocalFixture f{};
+        auto target = ObjectId::parse("111122223333444455556666");
+        f.strand->execute([&]() {
+            auto foo = TypedObject<FooState>{f.federate1->getObjectClass("Foo").create()};
+            foo.set<&FooState::bar>(47);
+            foo.set<&FooState::position>(glm::vec2{1.0f, 2.0f});
+            foo.set<&FooState::target>(target);
+            foo.set<&FooState::name>("foo");
+            BOOST_CHECK_EQUAL(47, foo.get<&FooState::bar>());
+            BOOST_CHECK_EQUAL(47, foo.getObject()["bar"_int]);
+        });
+        f.strand->runUntilDone();
+        f.strand->execute([&]() {
+            auto object = f.federate2->getObjectClass("Foo").find([](auto) { return true; });
+            auto foo = TypedObject<FooState>{object};
+            const auto& state = foo.get();
+            BOOST_CHECK_EQUAL(47, state.bar);
+            BOOST_CHECK_EQUAL(0.0f, state.baz);
+            BOOST_CHECK(!state.flag);
+            BOOST_CHECK_EQUAL(2.0f, state.position.y);
+            BOOST_CHECK(target == state.target);
+            BOOST_CHECK_EQUAL("foo", state.name);
+            object["baz"] = 0.25;
+            BOOST_CHECK_EQUAL(0.25f, foo.get<&FooState::baz>());
+        });
+        f.strand->runUntilDone();
+        f.strand->execute([&]() {
+            auto foo = TypedObject<FooState>{f.federate1->getObjectClass("Foo").find([](auto) { return true; })};
+            BOOST_CHECK_EQUAL(0.25f, foo.get().baz);
+        });
+    }
+
+    BOOST_AUTO_TEST_CASE(should_not_assign_unchanged_values) {
+        LocalFixture f{};
+        f.strand->execute([&]() {
+            auto foo = TypedObject<FooState>{f.federate1->getObjectClass("Foo").create()};
+            foo.set<&FooState::flag>(false);
+            BOOST_CHECK(foo.getObject()["flag"_value].is_boolean());
+            foo.set<&FooState::position>(glm::vec2{1.0f, 2.0f});
+            auto version = foo.getProperty<&FooState::position>().getVersion();
+            foo.set<&FooState::position>(glm::vec2{1.0f, 2.0f});
+            BOOST_CHECK_EQUAL(version, foo.getProperty<&FooState::position>().getVersion());
+
+            auto state = foo.get();
+            state.position.x = 3.0f;
+            foo.set(state);
+            BOOST_CHECK_EQUAL(version + 1, foo.getProperty<&FooState::position>().getVersion());
+            BOOST_CHECK_EQUAL(3.0f, foo.getObject()["position"_vec2].x);
+        });
+        f.strand->runUntilDone();
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 
 #include <boost/asio/buffer.hpp>
 #include <boost/asio.hpp>
+#include <algorithm>
 
 using namespace std::placeholders;
 
@@ -329,29 +330,21 @@ void WebSocketSession::onRead(error_code ec, std::size_t bytes_transferred) {
 
     activity();
 
-    decodeBuffer_.clear();
-    {
-        const auto d = readBuffer_.data();
-        auto i = boost::asio::buffer_sequence_begin(d);
-        auto j = boost::asio::buffer_sequence_end(d);
-        while (i != j) {
-            auto p = static_cast<const char*>((*i).data());
-            auto q = p + (*i).size();
-            decodeBuffer_.insert(decodeBuffer_.end(), p, q);
-            ++i;
+    // a message may hold several packets written back to back, see tryWrite
+    const auto data = readBuffer_.data();
+    auto p = static_cast<const char*>(data.data());
+    auto remaining = data.size();
+    while (remaining != 0) {
+        if (!decompressor_.decode(p + data.size() - remaining, remaining)) {
+            readBuffer_.consume(readBuffer_.size());
+            return onError(ec, "decompressor_decode");
         }
-        readBuffer_.consume(decodeBuffer_.size());
+        remaining = decompressor_.remaining();
+        receivePacket_strand(Value{decompressor_.release_buffer(bufferPool_)});
     }
+    readBuffer_.consume(readBuffer_.size());
 
-    if (decompressor_.decode(decodeBuffer_.data(), decodeBuffer_.size())) {
-        auto data = reinterpret_cast<const char*>(decompressor_.data());
-        auto size = decompressor_.size();
-        auto buffer = std::make_shared<ValueBuffer>(std::string{data, size});
-        receivePacket_strand(Value{buffer});
-        doRead();
-    } else {
-        onError(ec, "decompressor_decode");
-    }
+    doRead();
 }
 
 
@@ -361,24 +354,38 @@ void WebSocketSession::doWrite(const Value& packet) {
     std::lock_guard lock{writeMutex_};
 
     compressor_.encode(packet);
-    // if (auto analytics = runtime_->getAnalytics()) {
-    //   analytics->sampleCompressor(packet.size(), compressor_.size());
-    // }
+    sampleCompressor_strand(packet.size(), compressor_.size());
 
+    if (writeCount_ == writeRing_.size()) {
+        growWriteRing();
+    }
+    auto& buffer = writeRing_[(writeHead_ + writeCount_) & (writeRing_.size() - 1)];
     auto p = static_cast<const char*>(compressor_.data());
-    auto q = p + compressor_.size();
-    writeQueue_.emplace_back(p, q);
+    buffer.assign(p, p + compressor_.size());
+    ++writeCount_;
+    writeQueueSize_ += buffer.size();
     tryWrite();
 }
 
 
+/*
+ * Queued packets are written back to back as a single message, up
+ * to MaxGatherWriteSize bytes, the receiver decodes packets until the
+ * message is consumed (see onRead).
+ */
 void WebSocketSession::tryWrite() {
     LOG_ASSERT(getStrand().isCurrent());
 
     // NOTE: requires _writeMutex lock
-    if (writeBuffer_.empty() && !writeQueue_.empty()) {
-        writeBuffer_ = std::move(writeQueue_.front());
-        writeQueue_.erase(writeQueue_.begin());
+    if (writingCount_ == 0 && writeCount_ != 0) {
+        std::size_t size = 0;
+        writeBuffers_.clear();
+        while (writingCount_ != writeCount_ && (writingCount_ == 0 || size < MaxGatherWriteSize)) {
+            const auto& buffer = writeRing_[(writeHead_ + writingCount_) & (writeRing_.size() - 1)];
+            writeBuffers_.emplace_back(buffer.data(), buffer.size());
+            size += buffer.size();
+            ++writingCount_;
+        }
 
         auto handler = boost::asio::bind_executor(getAsioStrand(), [weak_ = weak_from_this()](auto ec, auto n) {
             if (auto this_ = std::static_pointer_cast<WebSocketSession>(weak_.lock())) {
@@ -387,8 +394,20 @@ void WebSocketSession::tryWrite() {
                 this_->onWrite(ec, n);
             }
         });
-        stream_.async_write(boost::asio::buffer(writeBuffer_), std::move(handler));
+        stream_.async_write(writeBuffers_, std::move(handler));
+    }
+}
+
+
+void WebSocketSession::growWriteRing() {
+    // NOTE: requires _writeMutex lock
+    // moving the buffers keeps their data in place, for writes in progress
+    std::vector<std::vector<char>> ring(std::max(InitialWriteRingSize, 2 * writeRing_.size()));
+    for (std::size_t i = 0; i != writeRing_.size(); ++i) {
+        ring[i] = std::move(writeRing_[(writeHead_ + i) & (writeRing_.size() - 1)]);
     }
+    writeRing_ = std::move(ring);
+    writeHead_ = 0;
 }
 
 
@@ -399,9 +418,24 @@ void WebSocketSession::onWrite(error_code ec, std::size_t bytes_transferred) {
         return onError(ec, "async_write");
     }
 
-    std::lock_guard lock{writeMutex_};
-    writeBuffer_.clear();
+    std::unique_lock lock{writeMutex_};
+    for (; writingCount_ != 0; --writingCount_, --writeCount_) {
+        auto& buffer = writeRing_[writeHead_];
+        writeQueueSize_ -= buffer.size();
+        if (buffer.capacity() > MaxPooledBufferCapacity) {
+            buffer = std::vector<char>{};
+        } else {
+            buffer.clear();
+        }
+        writeHead_ = (writeHead_ + 1) & (writeRing_.size() - 1);
+    }
     tryWrite();
+    bool drained = writeCount_ == 0;
+    lock.unlock();
+
+    if (drained) {
+        outgoingQueueDrained_strand();
+    }
 }
 
 
@@ -453,3 +487,9 @@ bool WebSocketSession::isExpectedError(WebSocketSession::error_code ec) {
 void WebSocketSession::sendPacketImpl_strand(const Value& packet) {
     doWrite(packet);
 }
+
+
+std::size_t WebSocketSession::getPendingWriteSize_strand() {
+    std::lock_guard lock{writeMutex_};
+    return writeQueueSize_;
+}
@@ -31,20 +31,27 @@ class WebSocketSession : public Session {
 
   static constexpr std::chrono::duration PingTimeout = std::chrono::seconds(15);
   static constexpr int ShutdownTimeoutMilliseconds = 2500;
+  static constexpr std::size_t InitialWriteRingSize = 16; // power of two
+  static constexpr std::size_t MaxGatherWriteSize = 64 * 1024;
+  static constexpr std::size_t MaxPooledBufferCapacity = 256 * 1024;
 
   std::weak_ptr<WebSocketEndpoint> endpoint_{};
   std::shared_ptr<boost::asio::io_context> ioc_{};
   stream stream_;
-  boost::beast::multi_buffer readBuffer_{};
-  std::string decodeBuffer_{};
-  std::string writeBuffer_{};
-  std::vector<std::string> writeQueue_{};
+  boost::beast::flat_buffer readBuffer_{};
+  std::vector<std::vector<char>> writeRing_{};
+  std::size_t writeHead_{};
+  std::size_t writeCount_{};
+  std::size_t writingCount_{};
+  std::size_t writeQueueSize_{};
+  std::vector<boost::asio::const_buffer> writeBuffers_{};
   std::mutex writeMutex_{};
   boost::asio::steady_timer pingTimer_;
   char pingState_ = 0;
   std::string host_{};
   ValueCompressor compressor_{};
   ValueDecompressor decompressor_{};
+  ValueBufferPool bufferPool_{}; // strand
 
 public:
   WebSocketSession(std::shared_ptr<boost::asio::io_context> ioc, WebSocketEndpoint& endpoint, socket socket);
@@ -83,6 +90,7 @@ public:
 
   void doWrite(const Value& packet);
   void tryWrite();
+  void growWriteRing();
   void onWrite(error_code ec, std::size_t bytes_transferred);
 
   void onError(error_code ec, const char* op);
@@ -91,6 +99,7 @@ public:
 
 protected:
   void sendPacketImpl_strand(const Value& packet) override;
+  [[nodiscard]] std::size_t getPendingWriteSize_strand() override;
 };
 
 
@@ -0,0 +1,152 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./block-codec.h"
+#include <cstring>
+#include <limits>
+
+static constexpr std::size_t MinMatch = 4;
+static constexpr std::size_t MaxOffset = 0xffff;
+static constexpr unsigned int HashBits = 14;
+
+
+static std::uint32_t load_uint32(const unsigned char* p) {
+    std::uint32_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+
+static std::uint32_t hash_uint32(std::uint32_t value) {
+    return (value * 2654435761u) >> (32u - HashBits);
+}
+
+
+static void add_length(std::string& output, std::size_t length) {
+    while (length >= 255) {
+        output.push_back(static_cast<char>(0xffu));
+        length -= 255;
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+
+static void add_sequence(std::string& output, const unsigned char* literals, std::size_t literal_length, std::size_t offset, std::size_t match_length) {
+    auto m = match_length != 0 ? match_length - MinMatch : 0;
+    unsigned char token = static_cast<unsigned char>((literal_length < 15 ? literal_length : 15) << 4u);
+    token |= static_cast<unsigned char>(m < 15 ? m : 15);
+    output.push_back(static_cast<char>(token));
+    if (literal_length >= 15) {
+        add_length(output, literal_length - 15);
+    }
+    output.append(reinterpret_cast<const char*>(literals), literal_length);
+    if (match_length != 0) {
+        output.push_back(static_cast<char>((offset >> 8u) & 0xffu));
+        output.push_back(static_cast<char>(offset & 0xffu));
+        if (m >= 15) {
+            add_length(output, m - 15);
+        }
+    }
+}
+
+
+/*
+ * Greedy matching with a single candidate per hash, like LZ4. When
+ * nothing matches the step grows, so that data that does not compress
+ * (e.g. already compressed) is skipped quickly. The table is not
+ * cleared between blocks, instead each block stores its positions
+ * above the positions of the blocks before it.
+ */
+void ValueBlockCodec::compress(const void* data, std::size_t size, std::string& output) {
+    auto src = static_cast<const unsigned char*>(data);
+    if (table_.empty() || size > std::numeric_limits<std::uint32_t>::max() - base_) {
+        table_.assign(std::size_t{1} << HashBits, 0);
+        base_ = 0;
+    }
+
+    std::size_t anchor = 0;
+    std::size_t i = 0;
+    while (i + MinMatch <= size) {
+        auto sequence = load_uint32(src + i);
+        auto& entry = table_[hash_uint32(sequence)];
+        bool found = entry >= base_;
+        std::size_t candidate = entry - base_;
+        entry = base_ + static_cast<std::uint32_t>(i);
+        if (found && candidate < i && i - candidate <= MaxOffset && load_uint32(src + candidate) == sequence) {
+            std::size_t length = MinMatch;
+            while (i + length < size && src[candidate + length] == src[i + length]) {
+                ++length;
+            }
+            add_sequence(output, src + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        } else {
+            i += 1 + ((i - anchor) >> 6u);
+        }
+    }
+    add_sequence(output, src + anchor, size - anchor, 0, 0);
+    base_ += static_cast<std::uint32_t>(size);
+}
+
+
+static bool read_length(const unsigned char*& ptr, const unsigned char* end, std::size_t& length) {
+    unsigned char byte;
+    do {
+        if (ptr == end) {
+            return false;
+        }
+        byte = *ptr++;
+        length += byte;
+    } while (byte == 0xffu);
+    return true;
+}
+
+
+bool ValueBlockCodec::decompress(const void* block, std::size_t block_size, void* data, std::size_t size) {
+    auto ptr = static_cast<const unsigned char*>(block);
+    auto end = ptr + block_size;
+    auto dst = static_cast<unsigned char*>(data);
+    std::size_t pos = 0;
+
+    while (ptr != end) {
+        unsigned char token = *ptr++;
+
+        std::size_t literal_length = token >> 4u;
+        if (literal_length == 15 && !read_length(ptr, end, literal_length)) {
+            return false;
+        }
+        if (literal_length > static_cast<std::size_t>(end - ptr) || literal_length > size - pos) {
+            return false;
+        }
+        std::memcpy(dst + pos, ptr, literal_length);
+        ptr += literal_length;
+        pos += literal_length;
+        if (ptr == end) {
+            break;
+        }
+
+        if (end - ptr < 2) {
+            return false;
+        }
+        std::size_t offset = static_cast<std::size_t>(ptr[0]) << 8u | ptr[1];
+        ptr += 2;
+        std::size_t match_length = token & 0x0fu;
+        if (match_length == 15 && !read_length(ptr, end, match_length)) {
+            return false;
+        }
+        match_length += MinMatch;
+        if (offset == 0 || offset > pos || match_length > size - pos) {
+            return false;
+        }
+        auto match = dst + pos - offset;
+        if (offset >= match_length) {
+            std::memcpy(dst + pos, match, match_length);
+        } else {
+            for (std::size_t k = 0; k != match_length; ++k) {
+                dst[pos + k] = match[k]; // overlapping, repeats the last offset bytes
+            }
+        }
+        pos += match_length;
+    }
+    return pos == size;
+}
@@ -0,0 +1,36 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__VALUE__BLOCK_CODEC_H
+#define WARSTAGE__VALUE__BLOCK_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// An LZ77 block codec, for the large and repetitive binaries and
+// packets sent over the wire (terrain maps, unit type catalogues).
+// The block is a sequence of LZ4 style sequences:
+//
+// llll mmmm, [<literal length bytes>], <literals>, <2 byte offset>, [<match length bytes>]
+//
+// where a length nibble of 15 continues with bytes that are added to
+// the length until a byte is not 255, and the match length is m + 4.
+// The last sequence has literals only and ends the block. The size of
+// the decompressed data is not stored in the block.
+
+class ValueBlockCodec {
+    std::vector<std::uint32_t> table_{}; // base_ + position by hash of 4 bytes
+    std::uint32_t base_{}; // entries below are from earlier blocks
+
+public:
+    // appends the compressed block to the output
+    void compress(const void* data, std::size_t size, std::string& output);
+
+    // decompresses a block that must expand to exactly size bytes,
+    // returns false if the block is invalid
+    static bool decompress(const void* block, std::size_t block_size, void* data, std::size_t size);
+};
+
+#endif
@@ -0,0 +1,102 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./buffer-pool.h"
+#include <atomic>
+
+
+ValueBufferPool::ValueBufferPool(std::size_t max_buffers, std::size_t max_capacity) :
+    max_buffers_{max_buffers},
+    max_capacity_{max_capacity} {
+}
+
+
+/*
+ * Builder buffers are mostly small messages, so the local pool
+ * drops the large buffers sooner than a session pool.
+ */
+ValueBufferPool& ValueBufferPool::local() {
+    thread_local ValueBufferPool pool{32, 64 * 1024};
+    return pool;
+}
+
+
+/*
+ * Values are usually built one or two at a time, and a larger buffer
+ * is fine, so the free buffer closest in size is used. Free buffers
+ * that have grown past the max capacity give back their memory. When
+ * all pooled buffers are in use, the buffer is not pooled.
+ */
+std::shared_ptr<ValueBuffer> ValueBufferPool::acquire(std::size_t size_hint) {
+    std::shared_ptr<ValueBuffer>* best = nullptr;
+    for (auto& buffer : buffers_) {
+        if (is_free(buffer)) {
+            if (buffer->value_.capacity() > max_capacity_) {
+                buffer->value_ = std::string{};
+            }
+            auto capacity = buffer->value_.capacity();
+            auto best_capacity = best ? (*best)->value_.capacity() : 0;
+            bool better = !best
+                || (capacity >= size_hint ? best_capacity < size_hint || capacity < best_capacity : capacity > best_capacity);
+            if (better) {
+                best = &buffer;
+            }
+        }
+    }
+
+    if (best) {
+        (*best)->value_.clear();
+        (*best)->level_ = 0;
+        (*best)->clear_field_index();
+    } else if (buffers_.size() < max_buffers_) {
+        best = &buffers_.emplace_back(std::make_shared<ValueBuffer>());
+    } else {
+        auto buffer = std::make_shared<ValueBuffer>();
+        buffer->value_.reserve(size_hint);
+        return buffer;
+    }
+    if ((*best)->value_.capacity() < size_hint) {
+        (*best)->value_.reserve(size_hint);
+    }
+    return *best;
+}
+
+
+/*
+ * The copy is only made when the buffer has grown to several KB more
+ * than twice the value, which is rare as acquire() prefers small
+ * buffers, so that a small value kept for long does not pin it.
+ */
+std::shared_ptr<ValueBuffer> ValueBufferPool::share(std::shared_ptr<ValueBuffer> buffer) {
+    auto size = buffer->size();
+    auto capacity = buffer->value_.capacity();
+    if (capacity > 2 * size && capacity - size > MaxSlack) {
+        return std::make_shared<ValueBuffer>(buffer->data(), size);
+    }
+    return buffer;
+}
+
+
+std::size_t ValueBufferPool::pooled() const {
+    std::size_t result = 0;
+    for (const auto& buffer : buffers_) {
+        if (is_free(buffer)) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+
+/*
+ * The last Value may have been destroyed on another thread. use_count()
+ * is a relaxed load, so the fence orders the reuse of the buffer after
+ * the release of that reference.
+ */
+bool ValueBufferPool::is_free(const std::shared_ptr<ValueBuffer>& buffer) {
+    if (buffer.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
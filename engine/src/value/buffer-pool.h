@@ -0,0 +1,44 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__VALUE__BUFFER_POOL_H
+#define WARSTAGE__VALUE__BUFFER_POOL_H
+
+#include "./buffer.h"
+#include <memory>
+#include <vector>
+
+
+// Keeps value buffers for reuse. Values share the pooled buffer itself,
+// and the pool keeps a reference of its own, so a buffer is free again
+// when the last Value referring to it is destroyed, on any thread. A pool
+// hands out buffers to one thread or strand only, and takes no locks.
+
+class ValueBufferPool {
+    static constexpr std::size_t MaxSlack = 4 * 1024;
+
+    std::vector<std::shared_ptr<ValueBuffer>> buffers_{};
+    std::size_t max_buffers_{};
+    std::size_t max_capacity_{};
+
+public:
+    explicit ValueBufferPool(std::size_t max_buffers = 16, std::size_t max_capacity = 256 * 1024);
+
+    // the pool of the calling thread, which the value builders draw from
+    [[nodiscard]] static ValueBufferPool& local();
+
+    // a free buffer with at least size_hint bytes reserved, preferring
+    // the smallest pooled buffer that is large enough
+    [[nodiscard]] std::shared_ptr<ValueBuffer> acquire(std::size_t size_hint = 0);
+
+    // the buffer itself, or an exact size copy if the buffer is much
+    // larger than its value, so that the value does not pin it
+    [[nodiscard]] static std::shared_ptr<ValueBuffer> share(std::shared_ptr<ValueBuffer> buffer);
+
+    [[nodiscard]] std::size_t pooled() const;
+
+private:
+    [[nodiscard]] static bool is_free(const std::shared_ptr<ValueBuffer>& buffer);
+};
+
+#endif
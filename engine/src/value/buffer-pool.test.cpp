@@ -0,0 +1,100 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "./buffer-pool.h"
+#include "./builder.h"
+#include <thread>
+
+
+BOOST_AUTO_TEST_SUITE(value_buffer_pool)
+
+    BOOST_AUTO_TEST_CASE(released_buffer_is_reused) {
+        ValueBufferPool pool{};
+        auto buffer = pool.acquire(1000);
+        buffer->value_.append("abc");
+        auto data = buffer->data();
+        auto shared = ValueBufferPool::share(std::move(buffer));
+        BOOST_CHECK_EQUAL(data, shared->data());
+        BOOST_CHECK_EQUAL(0, pool.pooled());
+        shared.reset();
+        BOOST_CHECK_EQUAL(1, pool.pooled());
+
+        auto reused = pool.acquire();
+        BOOST_CHECK_EQUAL(data, reused->data());
+        BOOST_CHECK_EQUAL(0, reused->size());
+        BOOST_CHECK_EQUAL(0, pool.pooled());
+    }
+
+    BOOST_AUTO_TEST_CASE(small_values_take_small_buffers) {
+        ValueBufferPool pool{};
+        auto large = pool.acquire(64 * 1024);
+        auto small = pool.acquire(100);
+        auto large_data = large->data();
+        auto small_data = small->data();
+        large.reset();
+        small.reset();
+
+        auto first = pool.acquire(10);
+        BOOST_CHECK_EQUAL(small_data, first->data());
+        auto second = pool.acquire(10000);
+        BOOST_CHECK_EQUAL(large_data, second->data());
+    }
+
+    BOOST_AUTO_TEST_CASE(oversized_buffer_is_copied) {
+        ValueBufferPool pool{};
+        auto buffer = pool.acquire(64 * 1024);
+        buffer->value_.append("abc");
+        auto data = buffer->data();
+        auto shared = ValueBufferPool::share(std::move(buffer));
+        BOOST_CHECK_NE(data, shared->data());
+        BOOST_CHECK_EQUAL(3, shared->size());
+        BOOST_CHECK_EQUAL(1, pool.pooled());
+    }
+
+    BOOST_AUTO_TEST_CASE(buffer_released_on_another_thread) {
+        ValueBufferPool pool{};
+        auto shared = ValueBufferPool::share(pool.acquire());
+        auto data = shared->data();
+        std::thread{[shared = std::move(shared)]() mutable {
+            shared.reset();
+        }}.join();
+        BOOST_CHECK_EQUAL(1, pool.pooled());
+        BOOST_CHECK_EQUAL(data, pool.acquire()->data());
+    }
+
+    BOOST_AUTO_TEST_CASE(shared_buffer_outlives_pool) {
+        auto pool = std::make_unique<ValueBufferPool>();
+        auto buffer = ValueBufferPool::share(pool->acquire());
+        pool.reset();
+        buffer.reset();
+    }
+
+    BOOST_AUTO_TEST_CASE(builders_reuse_local_buffers) {
+        auto& pool = ValueBufferPool::local();
+        const void* data;
+        {
+            auto value = Struct{} << "x" << 1 << ValueEnd{};
+            data = value.data();
+            BOOST_CHECK_EQUAL(1, value["x"_int]);
+        }
+        auto pooled = pool.pooled();
+        BOOST_CHECK_LE(1, pooled);
+        auto value = Struct{} << "y" << 2 << ValueEnd{};
+        BOOST_CHECK_EQUAL(data, value.data());
+        BOOST_CHECK_EQUAL(pooled - 1, pool.pooled());
+
+        auto reserved = pool.acquire(5000);
+        BOOST_CHECK_LE(5000, reserved->value_.capacity());
+    }
+
+    BOOST_AUTO_TEST_CASE(builder_buffer_outlives_thread) {
+        Value value{};
+        std::thread{[&value]() {
+            value = Struct{} << "x" << 1 << ValueEnd{};
+        }}.join();
+        BOOST_CHECK_EQUAL(1, value["x"_int]);
+        value = Value{};
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
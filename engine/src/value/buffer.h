@@ -4,12 +4,15 @@
 #ifndef WARSTAGE__VALUE__BUFFER_H
 #define WARSTAGE__VALUE__BUFFER_H
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <string>
 
 
 class Value;
+class ValueFieldIndex;
 
 enum class ValueType : unsigned char {
     _undefined = 0x00,
@@ -35,6 +38,9 @@ struct Binary {
 
 
 class ValueBuffer {
+    mutable std::atomic<ValueFieldIndex*> field_index_{};
+    mutable std::atomic<std::uint32_t> lookups_{};
+
 public:
     std::string value_;
     int level_{};
@@ -42,6 +48,9 @@ public:
     ValueBuffer() = default;
     explicit ValueBuffer(std::string s) : value_(std::move(s)) {}
     ValueBuffer(const void* data, std::size_t size) : value_{reinterpret_cast<const char*>(data), size} {}
+    ValueBuffer(ValueBuffer&& other) noexcept;
+    ValueBuffer& operator=(ValueBuffer&& other) noexcept;
+    ~ValueBuffer();
 
     [[nodiscard]] const void* data() const { return value_.data(); }
     [[nodiscard]] std::size_t size() const { return value_.size(); }
@@ -68,6 +77,11 @@ public:
         std::memcpy(&value_[offset], &value, 4);
     }
 
+    // created after repeated lookups, or nullptr before that,
+    // the buffer must not change after the first lookup
+    [[nodiscard]] ValueFieldIndex* field_index() const;
+    void clear_field_index();
+
     static double get_double(const void* data);
     static std::int32_t get_int32(const void* data);
 };
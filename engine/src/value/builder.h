@@ -5,6 +5,7 @@
 #define WARSTAGE__VALUE__BUILDER_H
 
 #include "./buffer.h"
+#include "./buffer-pool.h"
 #include "./value.h"
 #include <cassert>
 #include <memory>
@@ -15,27 +16,37 @@ struct Struct {};
 struct Array {};
 struct ValueEnd {};
 
+// Builders draw their buffers from the pool of the current thread, and
+// the built Value keeps the buffer, which is free for the next builder
+// when the last Value is destroyed, so messages reuse memory that has
+// already grown instead of reallocating.
+
+inline std::shared_ptr<ValueBuffer> make_builder_buffer(std::size_t size_hint = 0) {
+    return ValueBufferPool::local().acquire(size_hint);
+}
+
 struct ValueBuilder {
     std::shared_ptr<ValueBuffer> buffer_{};
     explicit ValueBuilder(std::shared_ptr<ValueBuffer> buffer) :
         buffer_{std::move(buffer)} {
     }
     Value end_() {
-        return Value{std::move(buffer_)};
+        return Value{ValueBufferPool::share(std::move(buffer_))};
     }
 };
 
 struct ArrayValueBuilder {
     std::shared_ptr<ValueBuffer> buffer_{};
-    ArrayValueBuilder() : buffer_{std::make_shared<ValueBuffer>()} {
+    explicit ArrayValueBuilder(std::size_t size_hint = 0) : buffer_{make_builder_buffer(size_hint)} {
         buffer_->add_byte(static_cast<char>(ValueType::_array));
         buffer_->add_byte('_');
         buffer_->add_byte(0);
     }
     Value end_() {
-        const char* ptr = reinterpret_cast<const char*>(buffer_->data());
-        const char* end = ptr + buffer_->size();
-        return Value{std::move(buffer_), ptr, end};
+        auto buffer = ValueBufferPool::share(std::move(buffer_));
+        const char* ptr = reinterpret_cast<const char*>(buffer->data());
+        const char* end = ptr + buffer->size();
+        return Value{std::move(buffer), ptr, end};
     }
 };
 
@@ -70,8 +81,8 @@ struct StructBuilder {
     }
 };
 
-inline StructBuilder<ValueBuilder> build_document() {
-    auto buffer = std::make_shared<ValueBuffer>();
+inline StructBuilder<ValueBuilder> build_document(std::size_t size_hint = 0) {
+    auto buffer = make_builder_buffer(size_hint);
     auto buffer_ptr = buffer.get();
     return StructBuilder<ValueBuilder>{buffer_ptr, ValueBuilder{std::move(buffer)}};
 }
@@ -129,8 +140,8 @@ struct ArrayBuilder {
     }
 };
 
-inline ArrayBuilder<ArrayValueBuilder> build_array() {
-    ArrayValueBuilder builder{};
+inline ArrayBuilder<ArrayValueBuilder> build_array(std::size_t size_hint = 0) {
+    ArrayValueBuilder builder{size_hint};
     auto buffer = builder.buffer_.get();
     return ArrayBuilder<ArrayValueBuilder>{buffer, std::move(builder)};
 }
@@ -139,7 +150,7 @@ inline ArrayBuilder<ArrayValueBuilder> build_array() {
 /* Document << End */
 
 inline Value operator<<(Struct, ValueEnd) {
-    auto buffer = std::make_shared<ValueBuffer>();
+    auto buffer = make_builder_buffer();
     auto buffer_ptr = buffer.get();
     return StructBuilder<ValueBuilder>{buffer_ptr, ValueBuilder{std::move(buffer)}}.end();
 }
@@ -166,7 +177,7 @@ inline Value operator<<(Array, ValueEnd) {
 /* Document << Member */
 
 inline MemberBuilder<StructBuilder<ValueBuilder>> operator<<(Struct, const char* member) {
-    auto buffer = std::make_shared<ValueBuffer>();
+    auto buffer = make_builder_buffer();
     auto buffer_ptr = buffer.get();
     auto builder = StructBuilder<ValueBuilder>{buffer_ptr, ValueBuilder{std::move(buffer)}};
     return MemberBuilder<StructBuilder<ValueBuilder>>{buffer_ptr, builder, member};
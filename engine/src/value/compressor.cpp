@@ -4,17 +4,94 @@
 #include "./compressor.h"
 
 
+static void set_uint32(std::string& buffer, std::size_t offset, unsigned int value) {
+    buffer[offset] = static_cast<char>((value >> 24u) & 0xffu);
+    buffer[offset + 1] = static_cast<char>((value >> 16u) & 0xffu);
+    buffer[offset + 2] = static_cast<char>((value >> 8u) & 0xffu);
+    buffer[offset + 3] = static_cast<char>(value & 0xffu);
+}
+
+
 void ValueCompressor::encode(const Value& value) {
     buffer_.clear();
+    blockBytes_ = 0;
     for (auto& v : value) {
         write(v, v.name());
     }
     add_byte(0x00u);
+    if (buffer_.size() - blockBytes_ >= PacketBlockThreshold) {
+        compress_packet();
+    }
+}
+
+
+void ValueCompressor::begin() {
+    buffer_.clear();
+    blockBytes_ = 0;
+}
+
+
+void ValueCompressor::append(const Value& value) {
+    write(value, nullptr);
+}
+
+
+/*
+ * Floats in the value are written as the xor with the float at
+ * the same position when the previous value was appended with this
+ * history. Slowly changing floats, like positions, keep their sign,
+ * exponent and high mantissa bits, and mostly send one or two bytes.
+ * With an encoding, the value is written as declared instead, and
+ * the decompressor must decode it with the same encoding.
+ */
+void ValueCompressor::append(const Value& value, ValueHistory& history, const ValueEncoding* encoding) {
+    history_ = &history;
+    encoding_ = encoding;
+    history.rewind();
+    write(value, nullptr);
+    history_ = nullptr;
+    encoding_ = nullptr;
+}
+
+
+void ValueCompressor::append(const Value& value, const ValueEncoding* encoding) {
+    encoding_ = encoding;
+    write(value, nullptr);
+    encoding_ = nullptr;
+}
+
+
+void ValueCompressor::append_int32(std::int32_t value) {
+    write_int32(value, 0x8000u, nullptr);
+}
+
+
+void ValueCompressor::append_float(float value) {
+    write_float(value, 0x8000u, nullptr);
+}
+
+
+void ValueCompressor::append_string(const char* value) {
+    write_string(value, 0x8000u, nullptr);
+}
+
+
+void ValueCompressor::append_ObjectId(ObjectId value) {
+    write_ObjectId(value, 0x8000u, nullptr);
+}
+
+
+void ValueCompressor::end() {
+    add_byte(0x00u);
 }
 
 
 void ValueCompressor::write(const Value& value, const char* property_name) {
     auto property_id = property_name ? get_or_add_property_id(property_name) : 0x8000u;
+    if (encoding_ && encoding_->type == ValueEncoding::Type::UnitVector && (value.is_document() || value.is_array())) {
+        write_int32(ValueEncoding::encode_direction(value._vec2()), property_id, property_name);
+        return;
+    }
     unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
     switch (value.type()) {
         case ValueType::_null: {
@@ -50,94 +127,32 @@ void ValueCompressor::write(const Value& value, const char* property_name) {
             break;
         }
         case ValueType::_double: {
-            header |= 0x06u;
-            float v = value._float();
-            add_byte(header);
-            add_property(property_id, property_name);
-            add_binary(&v, sizeof(float));
+            write_number(value._float(), property_id, property_name);
             break;
         }
         case ValueType::_ObjectId: {
-            header |= 0x08u;
-            std::uint32_t v = get_or_add_object_id(value._ObjectId());
-            header |= (v & 0x700u) >> 8u;
-            add_byte(header);
-            add_property(property_id, property_name);
-            add_byte(v & 0xffu);
-            if (v == 0 || v == 0x7ff) {
-                add_binary(value.data(), value.size());
-            }
+            write_ObjectId(value._ObjectId(), property_id, property_name);
             break;
         }
         case ValueType::_int32: {
-            std::uint32_t v = value._int32();
-            if (v >= 0 && v < 24) {
-                header |= 0x20u;
-                header |= v;
-                add_byte(header);
-                add_property(property_id, property_name);
+            if (encoding_) {
+                write_number(static_cast<float>(value._int32()), property_id, property_name);
             } else {
-                header |= 0x38u;
-                if ((v & 0x80000000u) != 0) {
-                    header |= 0x04u;
-                    v ^= 0xffffffffu;
-                }
-                if (v < 0x100u) {
-                    add_byte(header);
-                    add_property(property_id, property_name);
-                    add_byte(v & 0xffu);
-                } else if (v < 0x10000u) {
-                    header |= 0x01u;
-                    add_byte(header);
-                    add_property(property_id, property_name);
-                    add_uint16(v);
-                } else {
-                    header |= 0x02u;
-                    add_byte(header);
-                    add_property(property_id, property_name);
-                    add_uint32(v);
-                }
+                write_int32(value._int32(), property_id, property_name);
             }
             break;
         }
         case ValueType::_binary: {
             auto v = value._binary();
-            if (v.size != 0 && v.size < 0x1f) {
-                header |= 0x40u;
-                header |= v.size;
-                add_byte(header);
-                add_property(property_id, property_name);
-                add_binary(v.data, v.size);
-            } else if (v.size < 0x10000) {
-                header |= 0x40u;
-                add_byte(header);
-                add_property(property_id, property_name);
-                add_uint16(static_cast<unsigned int>(v.size));
-                add_binary(v.data, v.size);
-            } else /* if (v.size < 0x100000000) */ {
-                header |= 0x5fu;
-                add_byte(header);
-                add_property(property_id, property_name);
-                add_uint32(static_cast<unsigned int>(v.size));
-                add_binary(v.data, v.size);
-            }
+            write_binary(v.data, v.size, property_id, property_name);
             break;
         }
         case ValueType::_string: {
-            const char* v = value._c_str();
-            std::size_t length = std::strlen(v);
-            if (length != 0 && length < 0x20) {
-                header |= 0x60u;
-                header |= length;
-                add_byte(header);
-                add_property(property_id, property_name);
-                add_binary(v, length);
+            int index = encoding_ && encoding_->type == ValueEncoding::Type::Enum ? encoding_->find_name(value._c_str()) : -1;
+            if (index != -1) {
+                write_int32(index, property_id, property_name);
             } else {
-                header |= 0x60u;
-                add_byte(header);
-                add_property(property_id, property_name);
-                add_binary(v, length);
-                add_byte(0);
+                write_string(value._c_str(), property_id, property_name);
             }
             break;
         }
@@ -147,6 +162,192 @@ void ValueCompressor::write(const Value& value, const char* property_name) {
 }
 
 
+void ValueCompressor::write_number(float value, std::uint16_t property_id, const char* property_name) {
+    if (encoding_ && encoding_->is_numeric()) {
+        write_int32(encoding_->encode_float(value), property_id, property_name);
+    } else if (history_) {
+        write_float_xor(value, property_id, property_name);
+    } else {
+        write_float(value, property_id, property_name);
+    }
+}
+
+
+void ValueCompressor::write_float(float value, std::uint16_t property_id, const char* property_name) {
+    unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
+    header |= 0x06u;
+    add_byte(header);
+    add_property(property_id, property_name);
+    add_binary(&value, sizeof(float));
+}
+
+
+void ValueCompressor::write_float_xor(float value, std::uint16_t property_id, const char* property_name) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    auto& previous = history_->next();
+    std::uint32_t v = bits ^ previous;
+    previous = bits;
+
+    unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
+    if (v == 0) {
+        header |= 0x07u;
+        add_byte(header);
+        add_property(property_id, property_name);
+        return;
+    }
+
+    int trailing = 0;
+    while ((v & 0xffu) == 0) {
+        v >>= 8u;
+        ++trailing;
+    }
+    int n = 1;
+    while (n < 4 && (v >> (8u * n)) != 0) {
+        ++n;
+    }
+    header |= 0x10u;
+    header |= static_cast<unsigned char>(trailing << 2u);
+    header |= static_cast<unsigned char>(n - 1);
+    add_byte(header);
+    add_property(property_id, property_name);
+    while (n != 0) {
+        --n;
+        add_byte((v >> (8u * n)) & 0xffu);
+    }
+}
+
+
+void ValueCompressor::write_ObjectId(ObjectId value, std::uint16_t property_id, const char* property_name) {
+    unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
+    header |= 0x08u;
+    std::uint32_t v = get_or_add_object_id(value);
+    header |= (v & 0x700u) >> 8u;
+    add_byte(header);
+    add_property(property_id, property_name);
+    add_byte(v & 0xffu);
+    if (v == 0 || v == 0x7ff) {
+        add_binary(value.data(), value.size());
+    }
+}
+
+
+void ValueCompressor::write_int32(std::int32_t value, std::uint16_t property_id, const char* property_name) {
+    unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
+    auto v = static_cast<std::uint32_t>(value);
+    if (v < 24) {
+        header |= 0x20u;
+        header |= v;
+        add_byte(header);
+        add_property(property_id, property_name);
+    } else {
+        header |= 0x38u;
+        if ((v & 0x80000000u) != 0) {
+            header |= 0x04u;
+            v ^= 0xffffffffu;
+        }
+        if (v < 0x100u) {
+            add_byte(header);
+            add_property(property_id, property_name);
+            add_byte(v & 0xffu);
+        } else if (v < 0x10000u) {
+            header |= 0x01u;
+            add_byte(header);
+            add_property(property_id, property_name);
+            add_uint16(v);
+        } else {
+            header |= 0x02u;
+            add_byte(header);
+            add_property(property_id, property_name);
+            add_uint32(v);
+        }
+    }
+}
+
+
+void ValueCompressor::write_string(const char* value, std::uint16_t property_id, const char* property_name) {
+    unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
+    std::size_t length = std::strlen(value);
+    if (length != 0 && length < 0x20) {
+        header |= 0x60u;
+        header |= length;
+        add_byte(header);
+        add_property(property_id, property_name);
+        add_binary(value, length);
+    } else {
+        header |= 0x60u;
+        add_byte(header);
+        add_property(property_id, property_name);
+        add_binary(value, length);
+        add_byte(0);
+    }
+}
+
+
+void ValueCompressor::write_binary(const void* data, std::size_t size, std::uint16_t property_id, const char* property_name) {
+    if (size >= BinaryBlockThreshold && write_binary_block(data, size, property_id, property_name)) {
+        return;
+    }
+    unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
+    if (size != 0 && size < 0x1f) {
+        header |= 0x40u;
+        header |= size;
+        add_byte(header);
+        add_property(property_id, property_name);
+        add_binary(data, size);
+    } else if (size < 0x10000) {
+        header |= 0x40u;
+        add_byte(header);
+        add_property(property_id, property_name);
+        add_uint16(static_cast<unsigned int>(size));
+        add_binary(data, size);
+    } else /* if (size < 0x100000000) */ {
+        header |= 0x5fu;
+        add_byte(header);
+        add_property(property_id, property_name);
+        add_uint32(static_cast<unsigned int>(size));
+        add_binary(data, size);
+    }
+}
+
+
+/*
+ * The binary is compressed in place, after the header, and the header
+ * is taken back if the block would not save more than the size fields.
+ */
+bool ValueCompressor::write_binary_block(const void* data, std::size_t size, std::uint16_t property_id, const char* property_name) {
+    auto start = buffer_.size();
+    unsigned char header = (property_id & 0x100u) ? 0x80u : 0x00u;
+    header |= 0x3bu;
+    add_byte(header);
+    add_property(property_id, property_name);
+    add_uint32(static_cast<unsigned int>(size));
+    add_uint32(0);
+    auto block = buffer_.size();
+    codec_.compress(data, size, buffer_);
+    auto block_size = buffer_.size() - block;
+    if (block_size + 8 >= size) {
+        buffer_.resize(start);
+        return false;
+    }
+    set_uint32(buffer_, block - 4, static_cast<unsigned int>(block_size));
+    blockBytes_ += block_size;
+    return true;
+}
+
+
+void ValueCompressor::compress_packet() {
+    block_.assign(9, '\0');
+    block_[0] = static_cast<char>(0x3fu);
+    set_uint32(block_, 1, static_cast<unsigned int>(buffer_.size()));
+    codec_.compress(buffer_.data(), buffer_.size(), block_);
+    set_uint32(block_, 5, static_cast<unsigned int>(block_.size() - 9));
+    if (block_.size() < buffer_.size()) {
+        std::swap(buffer_, block_);
+    }
+}
+
+
 void ValueCompressor::add_byte(unsigned char value) {
     buffer_.push_back(static_cast<char>(value));
 }
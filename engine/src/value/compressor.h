@@ -5,7 +5,10 @@
 #define WARSTAGE__VALUE__COMPRESSOR_H
 
 #include "./value.h"
+#include "./block-codec.h"
 #include "./dictionary.h"
+#include "./encoding.h"
+#include "./history.h"
 #include <unordered_map>
 
 
@@ -21,19 +24,30 @@
 // p000 0100 - document
 // p000 0101 - array
 // p000 0110 - float
-// p000 0111 - double (not used)
+// p000 0111 - float, same as previous
 
 // p000 1000, pppp pppp, 0000 0000, <object id> - added object id
 // p000 1111, pppp pppp, 1111 1111, <object id> - reset object id
 // p000 1nnn, pppp pppp, nnnn nnnn - existing object id N
 
+// floats xor-ed with the previous float at the same position in
+// the value, with leading and trailing zero bytes left out
+// p001 ttnn, <n+1 bytes> - float (t = trailing zero bytes)
+
 // ints (i: 0=normal, 1=inverted)
 // p010 nnnn - int (0 - 15)
 // p011 0nnn - int (16 - 23)
 // p011 1i00, <1 byte>
 // p011 1i01, <2 bytes>
 // p011 1i10, <4 bytes>
-// p011 1i11, <8 bytes> (not used)
+// p011 1011, <4 byte size>, <4 byte block size>, <block> - binary, lz compressed
+
+// binaries of BinaryBlockThreshold bytes or more, and packets of
+// PacketBlockThreshold bytes or more, are compressed with the block
+// codec when that makes them smaller, a compressed packet is written as
+// 0011 1111, <4 byte size>, <4 byte block size>, <block>
+// where the block decompresses to the encoded packet, the first byte
+// is otherwise never written since 8 byte ints are not used
 
 // p100 0000 - binary (2 byte size)
 // p10s ssss - binary (size = sssss)
@@ -44,20 +58,51 @@
 
 
 class ValueCompressor {
+public:
+    static constexpr std::size_t BinaryBlockThreshold = 256;
+    static constexpr std::size_t PacketBlockThreshold = 1024;
+
+private:
     Dictionary<std::uint16_t> properties_{};
     std::unordered_map<ObjectId, std::uint16_t> objects_{};
     std::uint16_t lastPropertyId_{};
     std::uint16_t lastObjectId_{};
+    ValueHistory* history_{};
+    const ValueEncoding* encoding_{};
+    ValueBlockCodec codec_{};
     std::string buffer_{};
+    std::string block_{};
+    std::size_t blockBytes_{}; // already compressed bytes in the buffer
 
 public:
     void encode(const Value &value);
 
+    // streaming api, for writing a sequence of unnamed elements
+    // that decodes as an array, see ValueDecompressor::decode_array
+    void begin();
+    void append(const Value& value);
+    void append(const Value& value, ValueHistory& history, const ValueEncoding* encoding = nullptr);
+    void append(const Value& value, const ValueEncoding* encoding);
+    void append_int32(std::int32_t value);
+    void append_float(float value);
+    void append_string(const char* value);
+    void append_ObjectId(ObjectId value);
+    void end();
+
     [[nodiscard]] const void* data() const { return buffer_.data(); }
     [[nodiscard]] std::size_t size() const { return buffer_.size(); }
 
 private:
     void write(const Value &value, const char *propertyName);
+    void write_number(float value, std::uint16_t property_id, const char* property_name);
+    void write_float(float value, std::uint16_t property_id, const char* property_name);
+    void write_float_xor(float value, std::uint16_t property_id, const char* property_name);
+    void write_ObjectId(ObjectId value, std::uint16_t property_id, const char* property_name);
+    void write_int32(std::int32_t value, std::uint16_t property_id, const char* property_name);
+    void write_string(const char* value, std::uint16_t property_id, const char* property_name);
+    void write_binary(const void* data, std::size_t size, std::uint16_t property_id, const char* property_name);
+    bool write_binary_block(const void* data, std::size_t size, std::uint16_t property_id, const char* property_name);
+    void compress_packet();
 
     void add_byte(unsigned char value);
     void add_uint16(unsigned int value);
@@ -198,4 +198,258 @@ BOOST_AUTO_TEST_SUITE(value_compression)
         //  "1c000000037800140000000379000c000000107a002f000000000000"
     }
 
+    BOOST_AUTO_TEST_CASE(stream_of_elements) {
+        ValueCompressor c{};
+        c.begin();
+        c.append_int32(3);
+        c.append_string("A");
+        c.append_ObjectId(ObjectId::parse("111122223333444455556666"));
+        c.append_float(1.0f);
+        c.append(Struct() << "x" << 47 << ValueEnd());
+        c.end();
+        BOOST_CHECK_EQUAL(std::string("2361410800111122223333444455556666060000803f04380078002f0000"), hex(c.data(), c.size()));
+
+        ValueDecompressor d{};
+        BOOST_CHECK(d.decode_array(c.data(), c.size()));
+        auto value = Value{std::make_shared<ValueBuffer>(d.data(), d.size())};
+        BOOST_CHECK_EQUAL(3, value["0"_int]);
+        BOOST_CHECK_EQUAL(std::string("A"), value["1"_c_str]);
+        BOOST_CHECK(ObjectId::parse("111122223333444455556666") == value["2"_ObjectId]);
+        BOOST_CHECK_EQUAL(1.0f, value["3"_float]);
+        BOOST_CHECK_EQUAL(47, value["4"]["x"_int]);
+
+        c.begin();
+        c.append_ObjectId(ObjectId::parse("111122223333444455556666"));
+        c.end();
+        BOOST_CHECK_EQUAL(std::string("080100"), hex(c.data(), c.size()));
+    }
+
+    BOOST_AUTO_TEST_CASE(back_to_back_documents) {
+        ValueCompressor c{};
+        std::string data{};
+        c.encode(Struct() << "x" << 1 << ValueEnd());
+        data.append(static_cast<const char*>(c.data()), c.size());
+        c.encode(Struct() << "x" << 2 << ValueEnd());
+        data.append(static_cast<const char*>(c.data()), c.size());
+
+        ValueBufferPool pool{};
+        ValueDecompressor d{};
+        BOOST_CHECK(d.decode(data.data(), data.size()));
+        auto first = Value{d.release_buffer(pool)};
+        auto remaining = d.remaining();
+        BOOST_CHECK(d.decode(data.data() + data.size() - remaining, remaining));
+        auto second = Value{d.release_buffer(pool)};
+        BOOST_CHECK_EQUAL(0, d.remaining());
+        BOOST_CHECK_EQUAL(1, first["x"_int]);
+        BOOST_CHECK_EQUAL(2, second["x"_int]);
+    }
+
+    BOOST_AUTO_TEST_CASE(float_history) {
+        struct Floats : ValueVisitor {
+            std::vector<double> values{};
+            void visit_double(const char* name, double value) override { values.push_back(value); }
+        };
+
+        ValueHistory encoderHistory{};
+        ValueHistory decoderHistory{};
+        ValueCompressor c{};
+        ValueDecompressor d{};
+        Floats floats{};
+
+        c.begin();
+        c.append(Array() << 100.25 << 200.5 << ValueEnd(), encoderHistory);
+        c.end();
+        BOOST_CHECK_EQUAL(std::string("051642c880164348800000"), hex(c.data(), c.size()));
+        d.use_history(&decoderHistory);
+        BOOST_CHECK(d.visit_array(c.data(), c.size(), floats));
+
+        c.begin();
+        c.append(Array() << 100.5 << 200.5 << ValueEnd(), encoderHistory);
+        c.end();
+        BOOST_CHECK_EQUAL(std::string("05150180070000"), hex(c.data(), c.size()));
+        d.use_history(&decoderHistory);
+        BOOST_CHECK(d.visit_array(c.data(), c.size(), floats));
+        BOOST_CHECK((floats.values == std::vector<double>{100.25, 200.5, 100.5, 200.5}));
+
+        d.use_history(nullptr);
+        BOOST_CHECK(!d.visit_array(c.data(), c.size(), floats));
+    }
+
+    BOOST_AUTO_TEST_CASE(declared_encodings) {
+        auto fixed = ValueEncoding::fixed(0.0f, 1024.0f, 17);
+        auto half = ValueEncoding::float16();
+        auto direction = ValueEncoding::unit_vector();
+        auto names = ValueEncoding::enumeration({"line", "column", "square"});
+        auto value = Struct()
+            << "center" << glm::vec2{512.3f, 100.0f}
+            << "morale" << 0.75
+            << "facing" << glm::vec2{0.0f, 1.0f}
+            << "formation" << "column"
+            << "other" << "wedge"
+            << ValueEnd();
+
+        ValueHistory history{};
+        ValueCompressor c{};
+        ValueDecompressor d{};
+        auto decode = [&](const char* name, const ValueEncoding& encoding) -> Value {
+            c.begin();
+            c.append(value[name], history, &encoding);
+            c.end();
+            d.use_history(&history);
+            d.use_encoding(&encoding);
+            BOOST_CHECK(d.decode_array(c.data(), c.size()));
+            auto elements = Value{std::make_shared<ValueBuffer>(d.data(), d.size())};
+            return elements["0"];
+        };
+
+        auto center = decode("center", fixed)._vec2();
+        BOOST_CHECK_CLOSE(512.3f, center.x, 0.001);
+        BOOST_CHECK_CLOSE(100.0f, center.y, 0.001);
+        BOOST_CHECK_EQUAL(0.75, decode("morale", half)._double());
+        auto facing = decode("facing", direction)._vec2();
+        BOOST_CHECK_SMALL(facing.x, 0.0001f);
+        BOOST_CHECK_CLOSE(1.0f, facing.y, 0.0001);
+        BOOST_CHECK_EQUAL(std::string("column"), decode("formation", names)._c_str());
+        BOOST_CHECK_EQUAL(std::string("wedge"), decode("other", names)._c_str());
+
+        c.begin();
+        c.append(value["formation"], history, &names);
+        c.end();
+        BOOST_CHECK_EQUAL(std::string("2100"), hex(c.data(), c.size()));
+
+        BOOST_CHECK_EQUAL(0x7bff, half.encode_float(65504.0f));
+        BOOST_CHECK_EQUAL(65504.0f, half.decode_float(0x7bff));
+        BOOST_CHECK_EQUAL(0x0001, half.encode_float(5.9604645e-8f));
+        BOOST_CHECK_EQUAL(5.9604645e-8f, half.decode_float(0x0001));
+        BOOST_CHECK_EQUAL(-2.0f, half.decode_float(half.encode_float(-2.0f)));
+    }
+
+    BOOST_AUTO_TEST_CASE(visit_elements) {
+        struct Trace : ValueVisitor {
+            std::string s{};
+            void begin_document(const char* name) override { s += std::string{name} + "{"; }
+            void begin_array(const char* name) override { s += std::string{name} + "["; }
+            void end() override { s += "}"; }
+            void visit_null(const char* name) override { s += std::string{name} + "=null,"; }
+            void visit_boolean(const char* name, bool value) override { s += std::string{name} + (value ? "=true," : "=false,"); }
+            void visit_int32(const char* name, std::int32_t value) override { s += std::string{name} + "=" + std::to_string(value) + ","; }
+            void visit_double(const char* name, double value) override { s += std::string{name} + "=" + std::to_string(static_cast<int>(value * 10)) + ","; }
+            void visit_string(const char* name, const char* data, std::size_t size) override { s += std::string{name} + "='" + std::string{data, size} + "',"; }
+        };
+
+        ValueCompressor c{};
+        c.encode(Struct()
+            << "a" << 1000
+            << "b" << true
+            << "c" << static_cast<const char*>(nullptr)
+            << "d" << 1.5
+            << "e" << "foo"
+            << "f" << Array() << 1 << "bar" << ValueEnd()
+            << "g" << Struct() << "a" << -1 << ValueEnd()
+            << ValueEnd());
+
+        Trace trace{};
+        ValueDecompressor d{};
+        BOOST_CHECK(d.visit(c.data(), c.size(), trace));
+        BOOST_CHECK_EQUAL(std::string("a=1000,b=true,c=null,d=15,e='foo',f[0=1,1='bar',}g{a=-1,}"), trace.s);
+
+        ValueWriter writer{};
+        BOOST_CHECK(d.visit(c.data(), c.size(), writer));
+        BOOST_CHECK(d.decode(c.data(), c.size()));
+        BOOST_CHECK_EQUAL(d.size() - 5, writer.buffer().size());
+        BOOST_CHECK(std::memcmp(static_cast<const char*>(d.data()) + 4, writer.buffer().data(), writer.buffer().size()) == 0);
+    }
+
+    BOOST_AUTO_TEST_CASE(block_codec) {
+        std::string data{};
+        for (int i = 0; i != 2000; ++i) {
+            data.push_back(static_cast<char>(i % 7 == 0 ? i : 'x'));
+        }
+        data.append(300, 'y'); // overlapping match
+
+        ValueBlockCodec codec{};
+        std::string block{};
+        codec.compress(data.data(), data.size(), block);
+        BOOST_CHECK_LT(block.size(), data.size() / 2);
+
+        std::string output(data.size(), '\0');
+        BOOST_CHECK(ValueBlockCodec::decompress(block.data(), block.size(), output.data(), output.size()));
+        BOOST_CHECK(output == data);
+        BOOST_CHECK(!ValueBlockCodec::decompress(block.data(), block.size(), output.data(), output.size() - 1));
+        BOOST_CHECK(!ValueBlockCodec::decompress(block.data(), block.size() / 2, output.data(), output.size()));
+
+        block.clear();
+        codec.compress("abc", 3, block);
+        BOOST_CHECK_EQUAL(std::string("30616263"), hex(block.data(), block.size()));
+
+        // positions from earlier blocks are never matched
+        std::string expected{};
+        ValueBlockCodec{}.compress(data.data(), data.size(), expected);
+        for (int i = 0; i != 3; ++i) {
+            block.clear();
+            codec.compress(data.data(), data.size(), block);
+            BOOST_CHECK(block == expected);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(compressed_binaries_and_packets) {
+        std::vector<unsigned char> terrain(4096);
+        for (std::size_t i = 0; i != terrain.size(); ++i) {
+            terrain[i] = static_cast<unsigned char>(i / 100);
+        }
+        std::string incompressible{};
+        std::uint32_t seed = 1;
+        for (int i = 0; i != 300; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            incompressible.push_back(static_cast<char>(seed >> 24u));
+        }
+
+        ValueCompressor c{};
+        ValueDecompressor d{};
+        c.encode(Struct{}
+            << "terrain" << Binary{terrain.data(), terrain.size()}
+            << "noise" << Binary{incompressible.data(), incompressible.size()}
+            << ValueEnd{});
+        BOOST_CHECK_LT(c.size(), 700);
+        BOOST_CHECK_EQUAL(0x3b, static_cast<const unsigned char*>(c.data())[0]);
+        BOOST_CHECK(d.decode(c.data(), c.size()));
+        auto value = Value{std::make_shared<ValueBuffer>(d.data(), d.size())};
+        auto v = value["terrain"_binary];
+        BOOST_REQUIRE_EQUAL(terrain.size(), v.size);
+        BOOST_CHECK(std::memcmp(terrain.data(), v.data, v.size) == 0);
+        BOOST_CHECK(value["noise"_binary].size == incompressible.size());
+
+        std::string corrupt{static_cast<const char*>(c.data()), c.size()};
+        corrupt[13] = 0x7f; // block size
+        BOOST_CHECK(!ValueDecompressor{}.decode(corrupt.data(), corrupt.size()));
+
+        auto names = Struct{} << "names" << Array{};
+        for (int i = 0; i != 100; ++i) {
+            names = std::move(names) << Struct{} << "name" << "unit-type" << "index" << i << ValueEnd{};
+        }
+        auto catalogue = std::move(names) << ValueEnd{} << ValueEnd{};
+        std::string data{};
+        c.encode(catalogue);
+        BOOST_CHECK_EQUAL(0x3f, static_cast<const unsigned char*>(c.data())[0]);
+        data.append(static_cast<const char*>(c.data()), c.size());
+        c.encode(Struct{} << "x" << 1 << ValueEnd{});
+        data.append(static_cast<const char*>(c.data()), c.size());
+
+        BOOST_CHECK(d.decode(data.data(), data.size()));
+        auto first = Value{std::make_shared<ValueBuffer>(d.data(), d.size())};
+        int count = 0;
+        int sum = 0;
+        for (const auto& name : first["names"_value]) {
+            ++count;
+            sum += name["index"_int];
+        }
+        BOOST_CHECK_EQUAL(100, count);
+        BOOST_CHECK_EQUAL(99 * 100 / 2, sum);
+        auto remaining = d.remaining();
+        BOOST_CHECK(d.decode(data.data() + data.size() - remaining, remaining));
+        BOOST_CHECK_EQUAL(0, d.remaining());
+        auto second = Value{std::make_shared<ValueBuffer>(d.data(), d.size())};
+        BOOST_CHECK_EQUAL(1, second["x"_int]);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,63 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./corpus.h"
+#include <fstream>
+#include <iterator>
+
+
+ValueCorpus::ValueCorpus(std::size_t maxValues) :
+    maxValues_{maxValues} {
+}
+
+
+/*
+ * The document is copied, so that the corpus does not keep pooled
+ * buffers from going back to their pools.
+ */
+void ValueCorpus::record(const Value& value) {
+    if (!value.is_document()) {
+        return;
+    }
+    std::lock_guard lock{mutex_};
+    if (values_.size() < maxValues_) {
+        values_.emplace_back(std::make_shared<ValueBuffer>(value.data(), value.size()));
+    }
+}
+
+
+std::vector<Value> ValueCorpus::values() {
+    std::lock_guard lock{mutex_};
+    return values_;
+}
+
+
+bool ValueCorpus::save(const char* path) {
+    std::ofstream file{path, std::ios::binary};
+    std::lock_guard lock{mutex_};
+    for (const auto& value : values_) {
+        file.write(static_cast<const char*>(value.data()), static_cast<std::streamsize>(value.size()));
+    }
+    return file.good();
+}
+
+
+bool ValueCorpus::load(const char* path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        return false;
+    }
+    std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+    std::lock_guard lock{mutex_};
+    std::size_t offset = 0;
+    while (data.size() - offset >= 5) {
+        auto size = static_cast<std::size_t>(ValueBuffer::get_int32(data.data() + offset));
+        if (size < 5 || size > data.size() - offset) {
+            return false;
+        }
+        values_.emplace_back(std::make_shared<ValueBuffer>(data.data() + offset, size));
+        offset += size;
+    }
+    return offset == data.size();
+}
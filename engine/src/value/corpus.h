@@ -0,0 +1,33 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__VALUE__CORPUS_H
+#define WARSTAGE__VALUE__CORPUS_H
+
+#include "./value.h"
+#include <mutex>
+#include <vector>
+
+
+// A sequence of documents, such as the packets sent by sessions (see
+// Runtime::setPacketCorpus), kept for the codec benchmark. A corpus
+// file holds the bson documents back to back.
+
+class ValueCorpus {
+    std::mutex mutex_{};
+    std::vector<Value> values_{};
+    std::size_t maxValues_{};
+
+public:
+    explicit ValueCorpus(std::size_t maxValues = 100000);
+
+    // safe, documents after maxValues are ignored
+    void record(const Value& value);
+
+    [[nodiscard]] std::vector<Value> values();
+
+    bool save(const char* path);
+    bool load(const char* path); // appends to the recorded values
+};
+
+#endif
@@ -0,0 +1,33 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include <boost/test/unit_test.hpp>
+#include "./builder.h"
+#include "./corpus.h"
+#include <filesystem>
+
+
+BOOST_AUTO_TEST_SUITE(value_corpus)
+
+    BOOST_AUTO_TEST_CASE(save_and_load) {
+        ValueCorpus corpus{2};
+        corpus.record(Struct{} << "x" << 1 << ValueEnd{});
+        corpus.record(*(Array{} << 2 << ValueEnd{}).begin()); // not a document
+        corpus.record(Struct{} << "s" << "text" << ValueEnd{});
+        corpus.record(Struct{} << "x" << 3 << ValueEnd{}); // full
+        BOOST_REQUIRE_EQUAL(2, corpus.values().size());
+
+        auto path = (std::filesystem::temp_directory_path() / "warstage-corpus.test.bin").string();
+        BOOST_CHECK(corpus.save(path.c_str()));
+
+        ValueCorpus loaded{};
+        BOOST_CHECK(loaded.load(path.c_str()));
+        std::filesystem::remove(path);
+        auto values = loaded.values();
+        BOOST_REQUIRE_EQUAL(2, values.size());
+        BOOST_CHECK_EQUAL(1, values[0]["x"_int]);
+        BOOST_CHECK_EQUAL(std::string{"text"}, values[1]["s"_c_str]);
+        BOOST_CHECK(!loaded.load("/nonexistent/warstage-corpus.bin"));
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
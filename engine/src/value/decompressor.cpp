@@ -2,30 +2,91 @@
 // Licensed under GNU General Public License version 3 or later.
 
 #include "./decompressor.h"
-#include <sstream>
+#include <charconv>
 
 
 bool ValueDecompressor::decode(const void* data, std::size_t size) {
+    writer_.clear();
+    writer_.begin_document(nullptr);
+    visit_elements(writer_, true, data, size);
+    writer_.end();
+    return !failure_;
+}
+
+
+bool ValueDecompressor::decode_array(const void* data, std::size_t size) {
+    writer_.clear();
+    writer_.begin_document(nullptr);
+    visit_elements(writer_, false, data, size);
+    writer_.end();
+    return !failure_;
+}
+
+
+bool ValueDecompressor::visit(const void* data, std::size_t size, ValueVisitor& visitor) {
+    return visit_elements(visitor, true, data, size);
+}
+
+
+bool ValueDecompressor::visit_array(const void* data, std::size_t size, ValueVisitor& visitor) {
+    return visit_elements(visitor, false, data, size);
+}
+
+
+void ValueDecompressor::use_history(ValueHistory* history) {
+    history_ = history;
+    if (history_) {
+        history_->rewind();
+    }
+}
+
+
+std::shared_ptr<ValueBuffer> ValueDecompressor::release_buffer(ValueBufferPool& pool) {
+    auto buffer = pool.acquire();
+    std::swap(*buffer, writer_.buffer());
+    return ValueBufferPool::share(std::move(buffer));
+}
+
+
+template <typename Visitor>
+bool ValueDecompressor::visit_elements(Visitor& visitor, bool is_property, const void* data, std::size_t size) {
     failure_ = false;
-    
-    buffer_.value_.clear();
-    buffer_.level_ = 0;
-    
+
     ptr_ = reinterpret_cast<const unsigned char*>(data);
     end_ = ptr_ + size;
-    
-    auto start = buffer_.size();
-    buffer_.add_int32(0);
-    while (decode_element(true, 0)) {
+
+    const unsigned char* next = nullptr;
+    if (ptr_ != end_ && *ptr_ == 0x3fu) /* compressed packet */ {
+        ++ptr_;
+        if (!read_block(packet_)) {
+            failure_ = true;
+            return false;
+        }
+        next = ptr_;
+        ptr_ = reinterpret_cast<const unsigned char*>(packet_.data());
+        end_ = ptr_ + packet_.size();
+    }
+
+    int i = 0;
+    while (visit_element(visitor, is_property, i)) {
+        ++i;
+    }
+
+    if (next) {
+        ptr_ = next; // remaining() counts from after the block
+        end_ = reinterpret_cast<const unsigned char*>(data) + size;
     }
-    buffer_.add_byte(0);
-    buffer_.set_int32(start, buffer_.diff(start));
-    
     return !failure_;
 }
 
 
-bool ValueDecompressor::decode_element(bool is_property, int index) {
+/*
+ * The Visitor is either the ValueWriter, when decoding to a buffer,
+ * or a ValueVisitor, so that decoding does not pay for virtual calls.
+ * Element names are only valid until the next element is read.
+ */
+template <typename Visitor>
+bool ValueDecompressor::visit_element(Visitor& visitor, bool is_property, int index) {
     unsigned char header = read_byte();
     if (header == 0) {
         return false;
@@ -41,55 +102,57 @@ bool ValueDecompressor::decode_element(bool is_property, int index) {
     
     switch (type) {
         case 0x01: /* null */ {
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_null));
-            buffer_.add_string(property_name);
+            visitor.visit_null(property_name);
             return true;
         }
         case 0x02: /* false */ {
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_boolean));
-            buffer_.add_string(property_name);
-            buffer_.add_byte(0);
+            visitor.visit_boolean(property_name, false);
             return true;
         }
         case 0x03: /* true */ {
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_boolean));
-            buffer_.add_string(property_name);
-            buffer_.add_byte(1);
+            visitor.visit_boolean(property_name, true);
             return true;
         }
         case 0x04: /* document */ {
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_document));
-            buffer_.add_string(property_name);
-            auto start = buffer_.size();
-            buffer_.add_int32(0);
-            while (decode_element(true, 0)) {
+            visitor.begin_document(property_name);
+            while (visit_element(visitor, true, 0)) {
             }
-            buffer_.add_byte(0);
-            buffer_.set_int32(start, buffer_.diff(start));
+            visitor.end();
             return !failure_;
         }
         case 0x05: /* array */ {
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_array));
-            buffer_.add_string(property_name);
-            auto start = buffer_.size();
-            buffer_.add_int32(0);
+            visitor.begin_array(property_name);
             int i = 0;
-            while (decode_element(false, i)) {
+            while (visit_element(visitor, false, i)) {
                 ++i;
             }
-            buffer_.add_byte(0);
-            buffer_.set_int32(start, buffer_.diff(start));
+            visitor.end();
             return !failure_;
         }
         case 0x06: /* float */ {
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_double));
-            buffer_.add_string(property_name);
-            buffer_.add_double(read_float());
+            visitor.visit_double(property_name, read_float());
+            return true;
+        }
+        case 0x07: /* float, same as previous */ {
+            if (!history_) {
+                failure_ = true;
+                return false; // error
+            }
+            visitor.visit_double(property_name, read_float_xor(type));
             return true;
         }
         default:
             break;
     }
+
+    if ((type & 0x70u) == 0x10u) /* float, xor-ed with previous */ {
+        if (!history_ || ptr_ + (type & 0x03u) + 1 > end_) {
+            failure_ = true;
+            return false; // error
+        }
+        visitor.visit_double(property_name, read_float_xor(type));
+        return true;
+    }
     
     if ((type & 0x78u) == 0x08) /* ObjectId */ {
         std::uint16_t obj = read_byte();
@@ -113,19 +176,27 @@ bool ValueDecompressor::decode_element(bool is_property, int index) {
             failure_ = true;
             return false; // error
         }
-        buffer_.add_byte(static_cast<unsigned char>(ValueType::_ObjectId));
-        buffer_.add_string(property_name);
-        buffer_.add_binary(v.data(), v.size());
+        visitor.visit_ObjectId(property_name, v);
         return true;
     }
     
+    if (type == 0x3bu) /* binary, lz compressed */ {
+        if (!read_block(binary_)) {
+            failure_ = true;
+            return false; // error
+        }
+        visitor.visit_binary(property_name, binary_.data(), binary_.size());
+        return true;
+    }
+
     switch (type & 0x60u) {
         case 0x20u: /* int */ {
             std::uint32_t n = type & 0x1fu;
             if (n < 24) {
-                buffer_.add_byte(static_cast<unsigned char>(ValueType::_int32));
-                buffer_.add_string(property_name);
-                buffer_.add_int32(n);
+                if (encoding_) {
+                    return visit_encoded(visitor, property_name, static_cast<std::int32_t>(n));
+                }
+                visitor.visit_int32(property_name, static_cast<std::int32_t>(n));
                 return true;
             }
             std::uint32_t v = 0;
@@ -144,9 +215,10 @@ bool ValueDecompressor::decode_element(bool is_property, int index) {
                 v ^= 0xffffffffu;
             }
 
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_int32));
-            buffer_.add_string(property_name);
-            buffer_.add_int32(v);
+            if (encoding_) {
+                return visit_encoded(visitor, property_name, static_cast<std::int32_t>(v));
+            }
+            visitor.visit_int32(property_name, static_cast<std::int32_t>(v));
             return true;
         }
         case 0x40u: /* binary */ {
@@ -160,11 +232,7 @@ bool ValueDecompressor::decode_element(bool is_property, int index) {
                 failure_ = true;
                 return false; // error
             }
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_binary));
-            buffer_.add_string(property_name);
-            buffer_.add_int32(size);
-            buffer_.add_byte(0);
-            buffer_.add_binary(ptr_, size);
+            visitor.visit_binary(property_name, ptr_, size);
             ptr_ += size;
             return true;
         }
@@ -185,11 +253,7 @@ bool ValueDecompressor::decode_element(bool is_property, int index) {
                 }
                 ptr_ += size;
             }
-            buffer_.add_byte(static_cast<unsigned char>(ValueType::_string));
-            buffer_.add_string(property_name);
-            buffer_.add_int32(size + 1);
-            buffer_.add_binary(data, size);
-            buffer_.add_byte(0);
+            visitor.visit_string(property_name, data, size);
             return true;
         }
     }
@@ -199,6 +263,36 @@ bool ValueDecompressor::decode_element(bool is_property, int index) {
 }
 
 
+template <typename Visitor>
+bool ValueDecompressor::visit_encoded(Visitor& visitor, const char* property_name, std::int32_t value) {
+    switch (encoding_->type) {
+        case ValueEncoding::Type::Float16:
+        case ValueEncoding::Type::Fixed:
+            visitor.visit_double(property_name, encoding_->decode_float(value));
+            return true;
+        case ValueEncoding::Type::UnitVector: {
+            auto v = ValueEncoding::decode_direction(value);
+            visitor.begin_document(property_name); // as written by the builder
+            visitor.visit_double("x", v.x);
+            visitor.visit_double("y", v.y);
+            visitor.visit_double("0", v.x);
+            visitor.visit_double("1", v.y);
+            visitor.end();
+            return true;
+        }
+        case ValueEncoding::Type::Enum:
+            if (value >= 0 && value < static_cast<std::int32_t>(encoding_->names.size())) {
+                const auto& name = encoding_->names[value];
+                visitor.visit_string(property_name, name.data(), name.size());
+                return true;
+            }
+            break;
+    }
+    failure_ = true;
+    return false;
+}
+
+
 const char* ValueDecompressor::read_property(std::uint16_t header) {
     std::uint16_t index = read_byte();
     if ((header & 0x80u) != 0) {
@@ -235,11 +329,33 @@ const char* ValueDecompressor::read_property(std::uint16_t header) {
 }
 
 
+/*
+ * Reads the sizes and decompresses the block that follows. A block
+ * expands to at most 255 bytes per byte, so a corrupt size is caught
+ * before the output is allocated.
+ */
+bool ValueDecompressor::read_block(std::string& output) {
+    if (ptr_ + 8 > end_) {
+        return false;
+    }
+    auto size = read_uint32();
+    auto block_size = read_uint32();
+    if (block_size > static_cast<std::size_t>(end_ - ptr_) || size / 255 > block_size) {
+        return false;
+    }
+    output.resize(size);
+    if (!ValueBlockCodec::decompress(ptr_, block_size, output.data(), size)) {
+        return false;
+    }
+    ptr_ += block_size;
+    return true;
+}
+
+
 const char* ValueDecompressor::make_index(int index) {
-    std::ostringstream os{};
-    os << index;
-    index_ = os.str();
-    return index_.c_str();
+    auto result = std::to_chars(index_, index_ + sizeof(index_) - 1, index);
+    *result.ptr = '\0';
+    return index_;
 }
 
 
@@ -274,6 +390,22 @@ std::uint32_t ValueDecompressor::read_uint32() {
 }
 
 
+float ValueDecompressor::read_float_xor(unsigned char type) {
+    std::uint32_t v = 0;
+    if (type != 0x07u) {
+        for (auto n = (type & 0x03u) + 1; n != 0; --n) {
+            v = (v << 8u) | read_byte();
+        }
+        v <<= 8u * ((type & 0x0cu) >> 2u);
+    }
+    auto& previous = history_->next();
+    previous ^= v;
+    float value;
+    std::memcpy(&value, &previous, sizeof(float));
+    return value;
+}
+
+
 float ValueDecompressor::read_float() {
     if (ptr_ + 4 > end_) {
         return 0; // error
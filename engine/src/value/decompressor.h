@@ -4,7 +4,12 @@
 #ifndef WARSTAGE__VALUE__DECOMPRESSOR_H
 #define WARSTAGE__VALUE__DECOMPRESSOR_H
 
+#include "./block-codec.h"
+#include "./buffer-pool.h"
+#include "./encoding.h"
+#include "./history.h"
 #include "./value.h"
+#include "./visitor.h"
 #include <string>
 
 
@@ -14,26 +19,55 @@ class ValueDecompressor {
     std::vector<ObjectId> objectIds_{};
     const unsigned char* ptr_{};
     const unsigned char* end_{};
-    ValueBuffer buffer_{};
-    std::string index_{};
+    ValueHistory* history_{};
+    const ValueEncoding* encoding_{};
+    ValueWriter writer_{};
+    std::string packet_{}; // a decompressed packet
+    std::string binary_{}; // a decompressed binary
+    char index_[12]{};
     bool failure_{};
 
 public:
     bool decode(const void* data, std::size_t size);
+    bool decode_array(const void* data, std::size_t size);
 
-    const void* data() const { return buffer_.data(); }
-    std::size_t size() const { return buffer_.size(); }
+    // streams the elements to the visitor instead of building a
+    // document, the visitor sees the root elements at depth 0
+    bool visit(const void* data, std::size_t size, ValueVisitor& visitor);
+    bool visit_array(const void* data, std::size_t size, ValueVisitor& visitor);
+
+    const void* data() const { return writer_.buffer().data(); }
+    std::size_t size() const { return writer_.buffer().size(); }
+
+    // bytes left after the last decoded document, when
+    // several documents are written back to back
+    std::size_t remaining() const { return end_ - ptr_; }
+
+    // the history for xor-ed floats in the following elements, may be set
+    // by a visitor before an element is read, see ValueCompressor::append
+    void use_history(ValueHistory* history);
+
+    // the declared encoding of the following elements, see ValueCompressor::append
+    void use_encoding(const ValueEncoding* encoding) { encoding_ = encoding; }
+
+    // the buffer of the decoded document, the next document is
+    // decoded into a free buffer acquired from the pool
+    std::shared_ptr<ValueBuffer> release_buffer(ValueBufferPool& pool);
 
 private:
-    bool decode_element(bool is_property, int index);
+    template <typename Visitor> bool visit_elements(Visitor& visitor, bool is_property, const void* data, std::size_t size);
+    template <typename Visitor> bool visit_element(Visitor& visitor, bool is_property, int index);
+    template <typename Visitor> bool visit_encoded(Visitor& visitor, const char* property_name, std::int32_t value);
 
     const char* read_property(std::uint16_t header);
+    bool read_block(std::string& output);
     const char* make_index(int index);
 
     unsigned char read_byte();
     std::uint16_t read_uint16();
     std::uint32_t read_uint32();
     float read_float();
+    float read_float_xor(unsigned char type);
 };
 
 #endif
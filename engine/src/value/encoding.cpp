@@ -0,0 +1,136 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#include "./encoding.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+static std::uint16_t float_to_half(float value) {
+    std::uint32_t x;
+    std::memcpy(&x, &value, sizeof(float));
+    std::uint32_t sign = (x >> 16u) & 0x8000u;
+    std::uint32_t mantissa = x & 0x7fffffu;
+    int exponent = static_cast<int>((x >> 23u) & 0xffu);
+    if (exponent == 0xff) {
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+    exponent += 15 - 127;
+    if (exponent >= 31) {
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<std::uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        auto shift = static_cast<std::uint32_t>(14 - exponent);
+        auto half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1u) {
+            ++half;
+        }
+        return static_cast<std::uint16_t>(sign | half);
+    }
+    auto half = sign | (static_cast<std::uint32_t>(exponent) << 10u) | (mantissa >> 13u);
+    if (mantissa & 0x1000u) {
+        ++half; // may carry into the exponent, which rounds up correctly
+    }
+    return static_cast<std::uint16_t>(half);
+}
+
+
+static float half_to_float(std::uint16_t half) {
+    std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16u;
+    std::uint32_t mantissa = half & 0x3ffu;
+    int exponent = (half >> 10u) & 0x1f;
+    std::uint32_t x;
+    if (exponent == 0x1f) {
+        x = sign | 0x7f800000u | (mantissa << 13u);
+    } else if (exponent != 0) {
+        x = sign | (static_cast<std::uint32_t>(exponent + 127 - 15) << 23u) | (mantissa << 13u);
+    } else if (mantissa != 0) {
+        exponent = 1;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1u;
+            --exponent;
+        }
+        x = sign | (static_cast<std::uint32_t>(exponent + 127 - 15) << 23u) | ((mantissa & 0x3ffu) << 13u);
+    } else {
+        x = sign;
+    }
+    float value;
+    std::memcpy(&value, &x, sizeof(float));
+    return value;
+}
+
+
+ValueEncoding ValueEncoding::float16() {
+    return ValueEncoding{Type::Float16};
+}
+
+
+ValueEncoding ValueEncoding::fixed(float min, float max, int bits) {
+    return ValueEncoding{Type::Fixed, std::clamp(bits, 1, 31), min, max};
+}
+
+
+ValueEncoding ValueEncoding::unit_vector() {
+    return ValueEncoding{Type::UnitVector};
+}
+
+
+ValueEncoding ValueEncoding::enumeration(std::vector<std::string> names) {
+    return ValueEncoding{Type::Enum, 0, 0.0f, 0.0f, std::move(names)};
+}
+
+
+std::int32_t ValueEncoding::encode_float(float value) const {
+    switch (type) {
+        case Type::Float16:
+            return float_to_half(value);
+        case Type::Fixed: {
+            auto steps = static_cast<double>((1u << static_cast<unsigned>(bits)) - 1u);
+            auto t = max > min ? (static_cast<double>(value) - min) / (static_cast<double>(max) - min) : 0.0;
+            return static_cast<std::int32_t>(std::lround(std::clamp(t, 0.0, 1.0) * steps));
+        }
+        default:
+            return 0;
+    }
+}
+
+
+float ValueEncoding::decode_float(std::int32_t value) const {
+    switch (type) {
+        case Type::Float16:
+            return half_to_float(static_cast<std::uint16_t>(value));
+        case Type::Fixed: {
+            auto steps = static_cast<double>((1u << static_cast<unsigned>(bits)) - 1u);
+            return static_cast<float>(min + (static_cast<double>(max) - min) * value / steps);
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+
+std::int32_t ValueEncoding::encode_direction(glm::vec2 value) {
+    auto angle = std::atan2(static_cast<double>(value.y), static_cast<double>(value.x));
+    return static_cast<std::int32_t>(std::lround(angle * 32768.0 / M_PI)) & 0xffff;
+}
+
+
+glm::vec2 ValueEncoding::decode_direction(std::int32_t value) {
+    auto angle = static_cast<double>(value & 0xffff) * M_PI / 32768.0;
+    return {static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+}
+
+
+int ValueEncoding::find_name(const char* value) const {
+    for (std::size_t i = 0; i != names.size(); ++i) {
+        if (names[i] == value) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
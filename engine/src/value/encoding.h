@@ -0,0 +1,48 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__VALUE__ENCODING_H
+#define WARSTAGE__VALUE__ENCODING_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// A declared encoding of a property value (see ObjectSchema), written
+// as ints by the compressor and decoded by the decompressor. Numbers
+// in a value with an encoding are decoded as doubles, and ints are
+// sent as floats so they are not mistaken for encoded values.
+
+struct ValueEncoding {
+    enum class Type : unsigned char {
+        Float16 = 1, // 16-bit float
+        Fixed = 2, // fixed point with bits over [min, max], values are clamped
+        UnitVector = 3, // vec2 direction as a 16-bit angle, decoded as a document
+        Enum = 4 // strings as an index into names, other strings are sent as is
+    };
+
+    Type type{};
+    int bits{};
+    float min{};
+    float max{};
+    std::vector<std::string> names{};
+
+    [[nodiscard]] static ValueEncoding float16();
+    [[nodiscard]] static ValueEncoding fixed(float min, float max, int bits);
+    [[nodiscard]] static ValueEncoding unit_vector();
+    [[nodiscard]] static ValueEncoding enumeration(std::vector<std::string> names);
+
+    [[nodiscard]] bool is_numeric() const { return type == Type::Float16 || type == Type::Fixed; }
+
+    [[nodiscard]] std::int32_t encode_float(float value) const;
+    [[nodiscard]] float decode_float(std::int32_t value) const;
+    [[nodiscard]] static std::int32_t encode_direction(glm::vec2 value);
+    [[nodiscard]] static glm::vec2 decode_direction(std::int32_t value);
+    [[nodiscard]] int find_name(const char* value) const;
+
+    bool operator==(const ValueEncoding& other) const = default;
+};
+
+#endif
@@ -0,0 +1,91 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__VALUE__FIELD_INDEX_H
+#define WARSTAGE__VALUE__FIELD_INDEX_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+
+
+// Maps field names to element offsets for the large documents in a
+// value buffer. Looking up a field otherwise walks the document and
+// compares each name, which adds up for documents such as unit types
+// and shapes that are looked up over and over. A buffer gets an index
+// after repeated lookups, so buffers read once (e.g. incoming packets)
+// are only walked. Each document's fields are published through an
+// atomic pointer, and lookups take no locks.
+
+class ValueFieldIndex {
+public:
+    using Fields = std::unordered_map<std::string_view, std::size_t>;
+
+    static constexpr std::size_t Threshold = 256; // smaller documents are walked
+    static constexpr std::uint32_t Lookups = 4; // lookups in a buffer before it is indexed
+    static constexpr std::size_t NotFound = ~std::size_t{};
+    static constexpr std::size_t NotIndexed = NotFound - 1;
+
+private:
+    static constexpr std::size_t SlotCount = 16; // documents indexed per buffer
+
+    struct Slot {
+        std::atomic<std::size_t> document{}; // offset + 1, or 0 if unused
+        std::atomic<Fields*> fields{};
+    };
+    std::array<Slot, SlotCount> slots_{};
+
+public:
+    ValueFieldIndex() = default;
+    ValueFieldIndex(const ValueFieldIndex&) = delete;
+    ValueFieldIndex& operator=(const ValueFieldIndex&) = delete;
+
+    ~ValueFieldIndex() {
+        for (auto& slot : slots_) {
+            delete slot.fields.load(std::memory_order_relaxed);
+        }
+    }
+
+    // offsets are relative to the buffer data, build adds the fields of
+    // the document on the first lookup, and may run on two threads at once
+    template <typename Build>
+    [[nodiscard]] std::size_t find(std::size_t document, const char* name, Build&& build) {
+        auto slot = find_slot(document);
+        if (!slot) {
+            return NotIndexed;
+        }
+        auto fields = slot->fields.load(std::memory_order_acquire);
+        if (!fields) {
+            auto built = std::make_unique<Fields>();
+            build(*built);
+            if (slot->fields.compare_exchange_strong(fields, built.get(), std::memory_order_acq_rel)) {
+                fields = built.release();
+            }
+        }
+        auto i = fields->find(name);
+        return i != fields->end() ? i->second : NotFound;
+    }
+
+private:
+    [[nodiscard]] Slot* find_slot(std::size_t document) {
+        const std::size_t key = document + 1;
+        const std::size_t hash = (key * 0x9e3779b97f4a7c15ull) >> 32;
+        for (std::size_t i = 0; i != SlotCount; ++i) {
+            auto& slot = slots_[(hash + i) % SlotCount];
+            auto current = slot.document.load(std::memory_order_acquire);
+            if (current == 0 && slot.document.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                return &slot;
+            }
+            if (current == key) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+};
+
+#endif
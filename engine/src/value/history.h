@@ -0,0 +1,34 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__VALUE__HISTORY_H
+#define WARSTAGE__VALUE__HISTORY_H
+
+#include <cstdint>
+#include <vector>
+
+
+// The bits of the floats last written for a value, in the order they
+// appear in the value, so that each float can be sent as the xor with
+// its previous value (see ValueCompressor::append). The compressor and
+// decompressor must see the same sequence of values.
+
+class ValueHistory {
+    std::vector<std::uint32_t> floats_{};
+    std::size_t next_{};
+
+public:
+    void rewind() {
+        next_ = 0;
+    }
+
+    // the previous bits of the next float, zero if none
+    [[nodiscard]] std::uint32_t& next() {
+        if (next_ == floats_.size()) {
+            floats_.push_back(0);
+        }
+        return floats_[next_++];
+    }
+};
+
+#endif
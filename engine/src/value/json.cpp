@@ -2,256 +2,574 @@
 // Licensed under GNU General Public License version 3 or later.
 
 #include "./json.h"
+#include "./builder.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
 
 
 namespace {
 
-  bool isWhitespace(std::istream::int_type c) {
-    switch (c) {
-      case ' ':
-      case '\n':
-      case '\r':
-      case '\t':
-        return true;
-      default:
-        return false;
-    }
-  }
+  constexpr std::uint64_t Ones = 0x0101010101010101u;
+  constexpr std::uint64_t Highs = 0x8080808080808080u;
 
-  void parseWhitespace(std::istream& is) {
-    while (isWhitespace(is.peek())) {
-      is.get();
-    }
+  // non-zero if any of the eight bytes in x is zero
+  constexpr std::uint64_t hasZeroByte(std::uint64_t x) {
+    return (x - Ones) & ~x & Highs;
   }
 
-  void parseChar(std::istream& is, std::istream::int_type c) {
-    const auto v = is.get();
-    if (v != c) {
-      throw std::invalid_argument(std::string("expected ") + static_cast<char>(c)
-        + ", got " + static_cast<char>(v));
-    }
+  // non-zero if any of the eight bytes in x is less than n (n <= 128)
+  constexpr std::uint64_t hasByteLessThan(std::uint64_t x, std::uint64_t n) {
+    return (x - Ones * n) & ~x & Highs;
   }
 
-  Value parseValue(std::istream& is);
-  std::string parseString(std::istream& is);
-
-  Value parseObject(std::istream& is) {
-    auto result = build_document();
-    parseChar(is, '{');
-    parseWhitespace(is);
-    while (is.peek() != '}') {
-      auto key = parseString(is);
-      parseWhitespace(is);
-      parseChar(is, ':');
-      result = std::move(result) << key.c_str() << parseValue(is);
-      if (is.peek() == ',') {
-        is.get();
-        parseWhitespace(is);
+  /*
+   * Strings are scanned eight bytes at a time for the characters that
+   * end a run of plain characters, which are then copied in one go.
+   */
+  const char* scanString(const char* ptr, const char* end) {
+    while (end - ptr >= 8) {
+      std::uint64_t v;
+      std::memcpy(&v, ptr, sizeof(v));
+      if (hasZeroByte(v ^ (Ones * '"')) || hasZeroByte(v ^ (Ones * '\\'))) {
+        break;
       }
+      ptr += 8;
+    }
+    while (ptr != end && *ptr != '"' && *ptr != '\\') {
+      ++ptr;
     }
-    parseChar(is, '}');
-    return std::move(result) << ValueEnd{};
+    return ptr;
   }
 
-  Value parseArray(std::istream& is) {
-    auto result = build_array();
-    parseChar(is, '[');
-    parseWhitespace(is);
-    while (is.peek() != ']') {
-      result = std::move(result) << parseValue(is);
-      if (is.peek() == ',') {
-        is.get();
-        parseWhitespace(is);
+  const char* scanEscaped(const char* ptr, const char* end) {
+    while (end - ptr >= 8) {
+      std::uint64_t v;
+      std::memcpy(&v, ptr, sizeof(v));
+      if (hasZeroByte(v ^ (Ones * '"')) || hasZeroByte(v ^ (Ones * '\\'))
+          || hasZeroByte(v ^ (Ones * '/')) || hasByteLessThan(v, 0x20)) {
+        break;
       }
+      ptr += 8;
+    }
+    while (ptr != end && *ptr != '"' && *ptr != '\\' && *ptr != '/' && static_cast<unsigned char>(*ptr) >= 0x20) {
+      ++ptr;
     }
-    parseChar(is, ']');
-    return std::move(result) << ValueEnd{};
+    return ptr;
   }
 
-  std::string parseString(std::istream& is) {
-    auto result = std::string{};
-    parseChar(is, '"');
-    while (is.peek() != '"') {
-      if (is.peek() != '\\') {
-        result.push_back(is.get());
+
+  /*
+   * Writes the elements to the buffer as they are parsed, the same way
+   * as the builders do, without building intermediate values.
+   */
+  class JsonParser {
+    static constexpr int MaxDepth = 512;
+
+    const char* const begin_;
+    const char* ptr_;
+    const char* const end_;
+    ValueBuffer& buffer_;
+    std::string name_{};
+    char index_[12]{};
+    int depth_{};
+
+  public:
+    JsonParser(std::string_view text, ValueBuffer& buffer) :
+        begin_{text.data()}, ptr_{text.data()}, end_{text.data() + text.size()}, buffer_{buffer} {
+    }
+
+    // a document is written as the root of the buffer, other
+    // values as an element, like the array builder does
+    bool parseRoot() {
+      skipWhitespace();
+      bool isDocument = peek() == '{';
+      if (isDocument) {
+        parseDocument();
       } else {
-        is.get();
-        switch (is.get()) {
+        parseElement("_", 1);
+      }
+      skipWhitespace();
+      if (ptr_ != end_) {
+        fail("end of text");
+      }
+      return isDocument;
+    }
+
+  private:
+    [[nodiscard]] char peek() const {
+      return ptr_ != end_ ? *ptr_ : '\0';
+    }
+
+    [[noreturn]] void fail(const char* expected) const {
+      throw std::invalid_argument(std::string("expected ") + expected
+          + " at " + std::to_string(ptr_ - begin_));
+    }
+
+    void expect(char c) {
+      if (peek() != c) {
+        const char s[] = {c, '\0'};
+        fail(s);
+      }
+      ++ptr_;
+    }
+
+    void expectLiteral(const char* literal, std::size_t length) {
+      if (static_cast<std::size_t>(end_ - ptr_) < length || std::memcmp(ptr_, literal, length) != 0) {
+        fail(literal);
+      }
+      ptr_ += length;
+    }
+
+    void skipWhitespace() {
+      while (ptr_ != end_) {
+        switch (*ptr_) {
+          case ' ':
+          case '\n':
+          case '\r':
+          case '\t':
+            ++ptr_;
+            break;
+          default:
+            return;
+        }
+      }
+    }
+
+    void addHeader(ValueType type, const char* name, std::size_t length) {
+      buffer_.add_byte(static_cast<char>(type));
+      buffer_.value_.append(name, length);
+      buffer_.add_byte(0);
+    }
+
+    void parseElement(const char* name, std::size_t length) {
+      switch (peek()) {
+        case '{':
+          addHeader(ValueType::_document, name, length);
+          parseDocument();
+          break;
+        case '[':
+          addHeader(ValueType::_array, name, length);
+          parseArray();
+          break;
+        case '"': {
+          addHeader(ValueType::_string, name, length);
+          auto start = buffer_.size();
+          buffer_.add_int32(0);
+          parseString(buffer_.value_);
+          buffer_.add_byte(0);
+          buffer_.set_int32(start, buffer_.diff(start + 4));
+          break;
+        }
+        case 't':
+          expectLiteral("true", 4);
+          addHeader(ValueType::_boolean, name, length);
+          buffer_.add_byte(1);
+          break;
+        case 'f':
+          expectLiteral("false", 5);
+          addHeader(ValueType::_boolean, name, length);
+          buffer_.add_byte(0);
+          break;
+        case 'n':
+          expectLiteral("null", 4);
+          addHeader(ValueType::_null, name, length);
+          break;
+        default: {
+          auto value = parseNumber();
+          addHeader(ValueType::_double, name, length);
+          buffer_.add_double(value);
+          break;
+        }
+      }
+    }
+
+    void enter() {
+      if (++depth_ > MaxDepth) {
+        fail("less nesting");
+      }
+    }
+
+    // trailing commas are accepted, as by earlier versions of the parser
+    void parseDocument() {
+      enter();
+      auto start = buffer_.size();
+      buffer_.add_int32(0);
+      expect('{');
+      skipWhitespace();
+      while (peek() != '}') {
+        name_.clear();
+        parseString(name_);
+        skipWhitespace();
+        expect(':');
+        skipWhitespace();
+        parseElement(name_.data(), name_.size());
+        skipWhitespace();
+        if (peek() != ',') {
+          break;
+        }
+        ++ptr_;
+        skipWhitespace();
+      }
+      expect('}');
+      buffer_.add_byte(0);
+      buffer_.set_int32(start, buffer_.diff(start));
+      --depth_;
+    }
+
+    void parseArray() {
+      enter();
+      auto start = buffer_.size();
+      buffer_.add_int32(0);
+      expect('[');
+      skipWhitespace();
+      int index = 0;
+      while (peek() != ']') {
+        auto result = std::to_chars(index_, index_ + sizeof(index_), index++);
+        parseElement(index_, result.ptr - index_);
+        skipWhitespace();
+        if (peek() != ',') {
+          break;
+        }
+        ++ptr_;
+        skipWhitespace();
+      }
+      expect(']');
+      buffer_.add_byte(0);
+      buffer_.set_int32(start, buffer_.diff(start));
+      --depth_;
+    }
+
+    void parseString(std::string& output) {
+      expect('"');
+      while (true) {
+        auto run = scanString(ptr_, end_);
+        output.append(ptr_, run - ptr_);
+        ptr_ = run;
+        if (ptr_ == end_) {
+          fail("\"");
+        }
+        if (*ptr_++ == '"') {
+          return;
+        }
+        if (ptr_ == end_) {
+          fail("escape");
+        }
+        switch (*ptr_++) {
           case '"':
-            result.push_back('"');
+            output.push_back('"');
             break;
           case '\\':
-            result.push_back('\\');
+            output.push_back('\\');
             break;
           case '/':
-            result.push_back('/');
+            output.push_back('/');
             break;
           case 'b':
-            result.push_back('\b');
+            output.push_back('\b');
             break;
           case 'f':
-            result.push_back('\f');
+            output.push_back('\f');
             break;
           case 'n':
-            result.push_back('\n');
+            output.push_back('\n');
             break;
           case 'r':
-            result.push_back('\r');
+            output.push_back('\r');
             break;
           case 't':
-            result.push_back('\t');
+            output.push_back('\t');
             break;
           case 'u':
+            parseCodePoint(output);
             break;
           default:
-            throw std::invalid_argument("");
+            --ptr_;
+            fail("escape");
         }
       }
     }
-    parseChar(is, '"');
-    return result;
-  }
 
-  Value parseNumber(std::istream& is) {
-    auto result = 0.0f;
-    is >> result;
-    return *(Array{} << result << ValueEnd{}).begin();
-  }
+    std::uint32_t parseHex4() {
+      std::uint32_t result = 0;
+      for (int i = 0; i != 4; ++i) {
+        char c = peek();
+        result <<= 4u;
+        if (c >= '0' && c <= '9') {
+          result |= static_cast<std::uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+          result |= static_cast<std::uint32_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+          result |= static_cast<std::uint32_t>(c - 'A' + 10);
+        } else {
+          fail("hex digit");
+        }
+        ++ptr_;
+      }
+      return result;
+    }
+
+    void parseCodePoint(std::string& output) {
+      auto c = parseHex4();
+      if (c >= 0xd800u && c < 0xdc00u && end_ - ptr_ >= 6 && ptr_[0] == '\\' && ptr_[1] == 'u') {
+        ptr_ += 2;
+        auto low = parseHex4();
+        if (low < 0xdc00u || low >= 0xe000u) {
+          fail("low surrogate");
+        }
+        c = 0x10000u + ((c - 0xd800u) << 10u) + (low - 0xdc00u);
+      }
+      if (c < 0x80u) {
+        output.push_back(static_cast<char>(c));
+      } else if (c < 0x800u) {
+        output.push_back(static_cast<char>(0xc0u | (c >> 6u)));
+        output.push_back(static_cast<char>(0x80u | (c & 0x3fu)));
+      } else if (c < 0x10000u) {
+        output.push_back(static_cast<char>(0xe0u | (c >> 12u)));
+        output.push_back(static_cast<char>(0x80u | ((c >> 6u) & 0x3fu)));
+        output.push_back(static_cast<char>(0x80u | (c & 0x3fu)));
+      } else {
+        output.push_back(static_cast<char>(0xf0u | (c >> 18u)));
+        output.push_back(static_cast<char>(0x80u | ((c >> 12u) & 0x3fu)));
+        output.push_back(static_cast<char>(0x80u | ((c >> 6u) & 0x3fu)));
+        output.push_back(static_cast<char>(0x80u | (c & 0x3fu)));
+      }
+    }
+
+    /*
+     * Numbers with at most 15 significant digits and a small exponent
+     * are exact as the product or quotient of two doubles, which covers
+     * the numbers in mods and dumps, other numbers fall back to from_chars,
+     * which unlike strtod does not depend on the locale.
+     */
+    double parseNumber() {
+      static constexpr double powers[] = {
+          1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+          1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+      auto start = ptr_;
+      bool negative = peek() == '-';
+      if (negative) {
+        ++ptr_;
+      }
+      std::uint64_t mantissa = 0;
+      int digits = 0;
+      int exponent = 0;
+      auto isDigit = [this]() {
+        return ptr_ != end_ && *ptr_ >= '0' && *ptr_ <= '9';
+      };
+      auto addDigit = [&](int scale) {
+        int d = *ptr_++ - '0';
+        if (digits < 19) {
+          if (mantissa != 0 || d != 0) {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(d);
+            ++digits;
+          }
+          exponent -= scale;
+        } else {
+          exponent += 1 - scale;
+        }
+      };
+
+      if (!isDigit()) {
+        fail("number");
+      }
+      while (isDigit()) {
+        addDigit(0);
+      }
+      if (peek() == '.') {
+        ++ptr_;
+        if (!isDigit()) {
+          fail("digit");
+        }
+        while (isDigit()) {
+          addDigit(1);
+        }
+      }
+      if (peek() == 'e' || peek() == 'E') {
+        ++ptr_;
+        bool negativeExponent = peek() == '-';
+        if (negativeExponent || peek() == '+') {
+          ++ptr_;
+        }
+        if (!isDigit()) {
+          fail("digit");
+        }
+        int e = 0;
+        while (isDigit()) {
+          e = std::min(e * 10 + (*ptr_++ - '0'), 100000);
+        }
+        exponent += negativeExponent ? -e : e;
+      }
 
-  Value parseLiteral(std::istream& is, const char* literal, const Value& value) {
-    while (*literal != '\0') {
-      if (is.get() != *literal++) {
-        throw std::invalid_argument("");
+      double result;
+      if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+        result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+        return negative ? -result : result;
       }
+      // from_chars leaves the result untouched when out of range, where
+      // strtod would give infinity or zero
+      if (std::from_chars(start, ptr_, result).ec == std::errc::result_out_of_range) {
+        result = exponent > 0 ? HUGE_VAL : 0.0;
+        return negative ? -result : result;
+      }
+      return result;
+    }
+  };
+
+
+  void writeString(std::string& output, const char* s) {
+    if (s == nullptr) {
+      output.append("null");
+      return;
     }
-    return value;
+    auto end = s + std::strlen(s);
+    output.push_back('"');
+    while (true) {
+      auto run = scanEscaped(s, end);
+      output.append(s, run - s);
+      s = run;
+      if (s == end) {
+        break;
+      }
+      switch (*s) {
+        case '"':
+          output.append("\\\"");
+          break;
+        case '\\':
+          output.append("\\\\");
+          break;
+        case '/':
+          output.append("\\/");
+          break;
+        case '\b':
+          output.append("\\b");
+          break;
+        case '\f':
+          output.append("\\f");
+          break;
+        case '\n':
+          output.append("\\n");
+          break;
+        case '\r':
+          output.append("\\r");
+          break;
+        case '\t':
+          output.append("\\t");
+          break;
+        default:
+          output.push_back(*s);
+          break;
+      }
+      ++s;
+    }
+    output.push_back('"');
   }
 
-  Value parseValue(std::istream& is) {
-    auto result = Value{};
-    parseWhitespace(is);
-    switch (is.peek()) {
-      case '"':
-        result = Value(*(Array{} << parseString(is) << ValueEnd{}).begin());
+  /*
+   * Doubles are written like an ostream with the default precision
+   * does (%g), with a fast path for the common integral values.
+   */
+  void writeDouble(std::string& output, double value) {
+    char buffer[32];
+    if (value == std::trunc(value) && std::abs(value) < 1e6 && !(value == 0 && std::signbit(value))) {
+      auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<std::int32_t>(value));
+      output.append(buffer, result.ptr - buffer);
+    } else {
+      auto n = std::snprintf(buffer, sizeof(buffer), "%g", value);
+      output.append(buffer, static_cast<std::size_t>(n));
+    }
+  }
+
+  void writeValue(std::string& output, const ValueBase& value) {
+    switch (value.type()) {
+      case ValueType::_undefined:
+      case ValueType::_binary:
+      case ValueType::_null:
+        output.append("null");
+        break;
+      case ValueType::_string:
+        writeString(output, value._c_str());
         break;
-      case '{':
-        result = parseObject(is);
+      case ValueType::_document: {
+        output.push_back('{');
+        int index = 0;
+        for (const auto& i : value) {
+          if (index++ != 0) {
+            output.push_back(',');
+          }
+          writeString(output, i.name());
+          output.push_back(':');
+          writeValue(output, i);
+        }
+        output.push_back('}');
+        break;
+      }
+      case ValueType::_array: {
+        output.push_back('[');
+        int index = 0;
+        for (const auto& i : value) {
+          if (index++ != 0) {
+            output.push_back(',');
+          }
+          writeValue(output, i);
+        }
+        output.push_back(']');
         break;
-      case '[':
-        result = parseArray(is);
+      }
+      case ValueType::_ObjectId:
+        writeString(output, value._ObjectId().str().c_str());
         break;
-      case 't':
-        result = parseLiteral(is, "true", *(Array{} << true << ValueEnd{}).begin());
+      case ValueType::_boolean:
+        output.append(value._bool() ? "true" : "false");
         break;
-      case 'f':
-        result = parseLiteral(is, "false", *(Array{} << false << ValueEnd{}).begin());
+      case ValueType::_int32: {
+        char buffer[12];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value._int32());
+        output.append(buffer, result.ptr - buffer);
         break;
-      case 'n':
-        result = parseLiteral(is, "null", *(Array{} << nullptr << ValueEnd{}).begin());
+      }
+      case ValueType::_double:
+        writeDouble(output, value._double());
         break;
-      default:
-        result = parseNumber(is);
     }
-    parseWhitespace(is);
-    return result;
   }
 }
 
 
+/*
+ * The buffer is drawn from the builder pool and sized for the text,
+ * which is usually larger than the bson.
+ */
+Value parse_json(std::string_view text) {
+  auto buffer = make_builder_buffer(text.size() + 16);
+  if (JsonParser{text, *buffer}.parseRoot()) {
+    return Value{ValueBufferPool::share(std::move(buffer))};
+  }
+  buffer = ValueBufferPool::share(std::move(buffer));
+  const char* ptr = static_cast<const char*>(buffer->data());
+  const char* end = ptr + buffer->size();
+  return Value{std::move(buffer), ptr, end};
+}
+
 
-std::istream& operator>>(std::istream& is, Value& value) {
-  value = parseValue(is);
-  return is;
+void write_json(std::string& output, const Value& value) {
+  writeValue(output, value);
 }
 
 
-static void quoted_string(std::ostream& os, const char* s) {
-    if (s == nullptr) {
-        os << "null";
-    } else {
-        os << '"';
-        while (*s != '\0') {
-            switch (*s) {
-                case '"':
-                    os << '\\' << '"';
-                    break;
-                case '\\':
-                    os << '\\' << '\\';
-                    break;
-                case '/':
-                    os << '\\' << '/';
-                    break;
-                case '\b':
-                    os << '\\' << 'b';
-                    break;
-                case '\f':
-                    os << '\\' << 'f';
-                    break;
-                case '\n':
-                    os << '\\' << 'n';
-                    break;
-                case '\r':
-                    os << '\\' << 'r';
-                    break;
-                case '\t':
-                    os << '\\' << 't';
-                    break;
-                default:
-                    os << *s;
-                    break;
-            }
-            ++s;
-        }
-        os << '"';
-    }
+std::istream& operator>>(std::istream& is, Value& value) {
+  std::string text{std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}};
+  value = parse_json(text);
+  return is;
 }
 
+
 std::ostream& operator<<(std::ostream& os, const Value& value) {
-    switch (value.type()) {
-        case ValueType::_undefined:
-        case ValueType::_binary:
-        case ValueType::_null:
-            os << "null";
-            break;
-        case ValueType::_string:
-            quoted_string(os, value._c_str());
-            break;
-        case ValueType::_document: {
-            os << '{';
-            int index = 0;
-            for (const auto &i : value) {
-                if (index++ != 0)
-                    os << ',';
-                quoted_string(os, i.name());
-                os << ':' << i;
-            }
-            os << '}';
-            break;
-        }
-        case ValueType::_array: {
-            os << '[';
-            int index = 0;
-            for (const auto &i : value) {
-                if (index++ != 0)
-                    os << ',';
-                os << i;
-            }
-            os << ']';
-            break;
-        }
-        case ValueType::_ObjectId:
-            quoted_string(os, value._ObjectId().str().c_str());
-            break;
-        case ValueType::_boolean:
-            os << (value._bool() ? "true" : "false");
-            break;
-        case ValueType::_int32:
-            os << value._int32();
-            break;
-        case ValueType::_double:
-            os << value._double();
-            break;
-    }
-    return os;
+  std::string output{};
+  write_json(output, value);
+  return os.write(output.data(), static_cast<std::streamsize>(output.size()));
 }
-
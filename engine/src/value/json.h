@@ -7,8 +7,18 @@
 #include "./value.h"
 #include <istream>
 #include <ostream>
+#include <string>
+#include <string_view>
 
 
+// Parses the text directly into a value buffer, numbers are read as
+// doubles, throws std::invalid_argument if the text is not json
+[[nodiscard]] Value parse_json(std::string_view text);
+
+// Appends the json text of the value
+void write_json(std::string& output, const Value& value);
+
+// reads the stream to the end, see parse_json
 std::istream& operator>>(std::istream&, Value&);
 std::ostream& operator<<(std::ostream&, const Value&);
 
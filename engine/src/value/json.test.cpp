@@ -3,6 +3,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include "./json.h"
+#include <cmath>
 
 
 BOOST_AUTO_TEST_SUITE(value_json)
@@ -124,4 +125,55 @@ BOOST_AUTO_TEST_SUITE(value_json)
         BOOST_CHECK_EQUAL(os.str(), "[\"\\\\\\/\\b\\f\\n\\r\\t\"]");
     }
 
+    BOOST_AUTO_TEST_CASE(parse_values) {
+        auto document = parse_json(R"( {"a": [1, -2.5e2, 0.1, 1e-3, 12345678901234567890], "b": {"c": null},} )");
+        BOOST_CHECK(document.is_document());
+        std::vector<double> numbers{};
+        for (const auto& number : document["a"_value]) {
+            numbers.push_back(number._double());
+        }
+        BOOST_CHECK((numbers == std::vector<double>{1.0, -250.0, 0.1, 0.001, 12345678901234567890.0}));
+        BOOST_CHECK(document["b"_value]["c"_value].is_null());
+
+        auto array = parse_json("[true, false, \"x\"]");
+        BOOST_CHECK(array.is_array());
+        std::string text{};
+        write_json(text, array);
+        BOOST_CHECK_EQUAL(text, R"([true,false,"x"])");
+
+        BOOST_CHECK_EQUAL(parse_json(" 42 ")._double(), 42.0);
+        BOOST_CHECK_EQUAL(std::string{parse_json(R"("a\u00e5\ud83d\ude00\/")")._c_str()}, "a\xc3\xa5\xf0\x9f\x98\x80/");
+    }
+
+    BOOST_AUTO_TEST_CASE(parse_long_numbers) {
+        auto document = parse_json(R"([1.7976931348623157e308, 0.1000000000000000055511151231257827, -1e400, 1e-400])");
+        std::vector<double> numbers{};
+        for (const auto& number : document) {
+            numbers.push_back(number._double());
+        }
+        BOOST_REQUIRE_EQUAL(numbers.size(), 4u);
+        BOOST_CHECK_EQUAL(numbers[0], 1.7976931348623157e308);
+        BOOST_CHECK_EQUAL(numbers[1], 0.1);
+        BOOST_CHECK_EQUAL(numbers[2], -HUGE_VAL);
+        BOOST_CHECK_EQUAL(numbers[3], 0.0);
+    }
+
+    BOOST_AUTO_TEST_CASE(parse_errors) {
+        BOOST_CHECK_THROW(parse_json(R"({"a" 1})"), std::invalid_argument);
+        BOOST_CHECK_THROW(parse_json(R"({"a": tru})"), std::invalid_argument);
+        BOOST_CHECK_THROW(parse_json(R"(["a)"), std::invalid_argument);
+        BOOST_CHECK_THROW(parse_json("[1] 2"), std::invalid_argument);
+        BOOST_CHECK_THROW(parse_json("-"), std::invalid_argument);
+        BOOST_CHECK_THROW(parse_json(std::string(1000, '[')), std::invalid_argument);
+    }
+
+    BOOST_AUTO_TEST_CASE(write_long_strings) {
+        std::string s = "a long string \"with quotes\" and a path/to/file\nand a newline";
+        auto value = Struct{} << "s" << s << "d" << 1234567.0 << "n" << -0.5 << ValueEnd{};
+        std::string text{};
+        write_json(text, value);
+        BOOST_CHECK_EQUAL(text, R"({"s":"a long string \"with quotes\" and a path\/to\/file\nand a newline","d":1.23457e+06,"n":-0.5})");
+        BOOST_CHECK_EQUAL(parse_json(text)["s"_str], s);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
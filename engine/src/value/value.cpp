@@ -2,8 +2,10 @@
 // Licensed under GNU General Public License version 3 or later.
 
 #include "./buffer.h"
+#include "./field-index.h"
 #include "./value.h"
 #include <ctime>
+#include <optional>
 #include <thread>
 #include <random>
 
@@ -43,6 +45,52 @@ void ValueBuffer::add_value(const Value& value) {
 }
 
 
+ValueBuffer::ValueBuffer(ValueBuffer&& other) noexcept :
+    field_index_{other.field_index_.exchange(nullptr, std::memory_order_relaxed)},
+    lookups_{other.lookups_.exchange(0, std::memory_order_relaxed)},
+    value_{std::move(other.value_)},
+    level_{other.level_} {
+}
+
+
+ValueBuffer& ValueBuffer::operator=(ValueBuffer&& other) noexcept {
+    delete field_index_.exchange(other.field_index_.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+    lookups_.store(other.lookups_.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    value_ = std::move(other.value_);
+    level_ = other.level_;
+    return *this;
+}
+
+
+ValueBuffer::~ValueBuffer() {
+    delete field_index_.load(std::memory_order_relaxed);
+}
+
+
+ValueFieldIndex* ValueBuffer::field_index() const {
+    auto index = field_index_.load(std::memory_order_acquire);
+    if (!index) {
+        if (lookups_.fetch_add(1, std::memory_order_relaxed) + 1 < ValueFieldIndex::Lookups) {
+            return nullptr;
+        }
+        auto created = new ValueFieldIndex{};
+        if (field_index_.compare_exchange_strong(index, created, std::memory_order_acq_rel)) {
+            index = created;
+        } else {
+            delete created;
+        }
+    }
+    return index;
+}
+
+
+// only while the buffer has a single owner, e.g. when returned to a pool
+void ValueBuffer::clear_field_index() {
+    delete field_index_.exchange(nullptr, std::memory_order_relaxed);
+    lookups_.store(0, std::memory_order_relaxed);
+}
+
+
 double ValueBuffer::get_double(const void* data) {
     double value;
     std::memcpy(&value, data, 8);
@@ -160,6 +208,12 @@ ValueBase::ValueBase(const char* ptr, const char* end) {
 
 Value::Value(const ValueElement& e) {
     assert(e.bufptr_);
+    if (!*e.bufptr_ && e.ptr_) {
+        // the element points into inline storage, which is copied
+        *this = make_element(e.ptr_, e.next_ - e.ptr_);
+        assert(ptr_ != e.ptr_);
+        return;
+    }
     buffer_ = *e.bufptr_;
     ptr_ = e.ptr_;
     end_ = e.end_;
@@ -168,6 +222,86 @@ Value::Value(const ValueElement& e) {
 }
 
 
+Value::Value(const Value& other) : ValueBase{other} {
+    copy_inline(other);
+}
+
+
+Value::Value(Value&& other) noexcept : ValueBase{std::move(other)} {
+    copy_inline(other);
+    static_cast<ValueBase&>(other) = ValueBase{};
+}
+
+
+Value& Value::operator=(const Value& other) {
+    if (this != &other) {
+        ValueBase::operator=(other);
+        copy_inline(other);
+    }
+    return *this;
+}
+
+
+Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        ValueBase::operator=(std::move(other));
+        copy_inline(other);
+        static_cast<ValueBase&>(other) = ValueBase{};
+    }
+    return *this;
+}
+
+
+void Value::copy_inline(const Value& other) {
+    if (!buffer_ && ptr_) {
+        std::memcpy(inline_, other.inline_, InlineSize);
+        ptr_ = inline_ + (other.ptr_ - other.inline_);
+        end_ = inline_ + (other.end_ - other.inline_);
+        data_ = inline_ + (other.data_ - other.inline_);
+        next_ = inline_ + (other.next_ - other.inline_);
+    }
+}
+
+
+Value Value::make_element(const void* data, std::size_t size) {
+    auto ptr = reinterpret_cast<const char*>(data);
+    if (size == 0) {
+        return Value{};
+    }
+    if (size > InlineSize || !is_inline_type(static_cast<ValueType>(*ptr))) {
+        auto buffer = std::make_shared<ValueBuffer>(data, size);
+        auto p = reinterpret_cast<const char*>(buffer->data());
+        return Value{buffer, p, p + size};
+    }
+    Value result{};
+    std::memcpy(result.inline_, data, size);
+    auto end = result.inline_ + size;
+    auto element = result.inline_ + 1 + strnlen(result.inline_ + 1, size - 1) + 1;
+    auto next = ValueElement::find_next(static_cast<ValueType>(*ptr), element);
+    if (element <= end && next && next <= end) {
+        result.ptr_ = result.inline_;
+        result.end_ = end;
+        result.data_ = element;
+        result.next_ = next;
+    }
+    return result;
+}
+
+
+bool Value::is_inline_type(ValueType type) {
+    switch (type) {
+        case ValueType::_null:
+        case ValueType::_boolean:
+        case ValueType::_int32:
+        case ValueType::_double:
+        case ValueType::_ObjectId:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
 Value::Value(std::shared_ptr<ValueBuffer> buffer) {
     buffer_ = std::move(buffer);
     if (buffer_) {
@@ -227,7 +361,40 @@ ValueIterator ValueBase::end() const {
 }
 
 
+/*
+ * Documents of at least ValueFieldIndex::Threshold bytes are looked up
+ * through the field index of their buffer, once it has one. Returns the
+ * element, or nullptr if there is no such field, or nothing if the
+ * document is not indexed and must be walked.
+ */
+template <typename T>
+static std::optional<const char*> find_indexed(const ValueBuffer* buffer, const T& document, const char* name) {
+    if (!buffer || document.size() < ValueFieldIndex::Threshold || !(document.is_document() || document.is_array()))
+        return std::nullopt;
+
+    auto base = static_cast<const char*>(buffer->data());
+    auto data = static_cast<const char*>(document.data());
+    if (data < base || data >= base + buffer->size())
+        return std::nullopt;
+
+    auto index = buffer->field_index();
+    if (!index)
+        return std::nullopt;
+
+    auto offset = index->find(static_cast<std::size_t>(data - base), name, [&](ValueFieldIndex::Fields& fields) {
+        for (auto i = document.begin(), e = document.end(); i != e; ++i)
+            fields.try_emplace(i->name(), static_cast<std::size_t>(i->name() - 1 - base));
+    });
+    if (offset == ValueFieldIndex::NotIndexed)
+        return std::nullopt;
+    return offset != ValueFieldIndex::NotFound ? base + offset : nullptr;
+}
+
+
 ValueElement ValueBase::operator[](const char* name) const {
+    if (auto element = find_indexed(buffer_.get(), *this, name))
+        return ValueElement{&buffer_, *element ? *element : end_, end_};
+
     for (auto i = begin(), e = end(); i != e; ++i)
         if (std::strcmp(name, i->name()) == 0)
             return *i;
@@ -332,6 +499,9 @@ ValueIterator ValueElement::end() const {
 
 
 ValueElement ValueElement::operator[](const char* name) const {
+    if (auto element = find_indexed(bufptr_ ? bufptr_->get() : nullptr, *this, name))
+        return *element ? ValueElement{bufptr_, *element, end_} : ValueElement{&buffer_, end_, end_};
+
     for (auto i = begin(), e = end(); i != e; ++i)
         if (std::strcmp(name, i->name()) == 0)
             return *i;
@@ -105,20 +105,50 @@ public:
     [[nodiscard]] glm::vec4 _vec4() const;
 };
 
+// Scalar elements (null, boolean, int32, double and ObjectId) of up to
+// InlineSize bytes are stored inline, without a shared buffer, when made
+// with Value::make_element(). All other values refer to a shared buffer.
+
 class Value : public ValueBase {
+public:
+    static constexpr std::size_t InlineSize = 24;
+
+private:
+    alignas(8) char inline_[InlineSize];
+
 public:
     Value() = default;
     explicit Value(std::shared_ptr<ValueBuffer> buffer);
     Value(std::shared_ptr<ValueBuffer> buffer, const char* ptr, const char* end);
 
-    Value(const Value&) = default;
+    Value(const Value& other);
+    Value(Value&& other) noexcept;
     Value(const ValueElement& e);
 
-    Value& operator=(const Value&) = default;
+    Value& operator=(const Value& other);
+    Value& operator=(Value&& other) noexcept;
     Value& operator=(const ValueElement&) = delete;
 
+    // copies a single element (type, name and data)
+    [[nodiscard]] static Value make_element(const void* data, std::size_t size);
+    [[nodiscard]] static bool is_inline_type(ValueType type);
+
+    // the element bytes of a value made from an element, or empty
+    [[nodiscard]] Binary element() const {
+        return ptr_ ? Binary{ptr_, static_cast<std::size_t>(next_ - ptr_)} : Binary{};
+    }
+
+    [[nodiscard]] bool is_inline() const { return !buffer_ && ptr_; }
+
+private:
+    void copy_inline(const Value& other);
 };
 
+// An element refers into the Value it was found in, to its shared buffer,
+// or to its inline storage, and must not outlive that Value. A Value made
+// from an element shares the buffer, or copies an element that has no
+// buffer, so it does not depend on the Value the element was found in.
+
 class ValueElement : public ValueBase {
     friend class Value;
     friend class ValueBase;
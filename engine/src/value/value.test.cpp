@@ -3,6 +3,9 @@
 
 #include <boost/test/unit_test.hpp>
 #include "./value.h"
+#include <atomic>
+#include <thread>
+#include <vector>
 
 
 BOOST_AUTO_TEST_SUITE(value_struct)
@@ -91,4 +94,98 @@ BOOST_AUTO_TEST_SUITE(value_struct)
 		BOOST_CHECK_EQUAL(47, doc["x"]["y"]["z"_int]);
 	}
 
+	BOOST_AUTO_TEST_CASE(inline_element)
+	{
+		auto doc = Struct() << "" << 47 << ValueEnd();
+		auto element = Value{*doc.begin()}.element();
+		auto value = Value::make_element(element.data, element.size);
+
+		BOOST_CHECK_EQUAL(true, value.is_inline());
+		BOOST_CHECK_EQUAL(47, value._int());
+
+		auto copy = value;
+		value = Value{};
+		BOOST_CHECK_EQUAL(true, copy.is_inline());
+		BOOST_CHECK_EQUAL(47, copy._int());
+
+		auto moved = std::move(copy);
+		BOOST_CHECK_EQUAL(47, moved._int());
+		BOOST_CHECK_EQUAL(true, copy.is_undefined());
+	}
+
+	BOOST_AUTO_TEST_CASE(value_from_inline_element)
+	{
+		std::shared_ptr<ValueBuffer> none{};
+		Value value{};
+		{
+			auto doc = Struct() << "" << 47 << ValueEnd();
+			auto element = Value{*doc.begin()}.element();
+			auto source = Value::make_element(element.data, element.size);
+			auto ptr = static_cast<const char*>(source.element().data);
+			value = Value{ValueElement{&none, ptr, ptr + source.element().size}};
+		}
+		BOOST_CHECK_EQUAL(true, value.is_inline());
+		BOOST_CHECK_EQUAL(47, value._int());
+	}
+
+	BOOST_AUTO_TEST_CASE(buffered_element)
+	{
+		auto doc = Struct() << "" << "a string is not stored inline" << ValueEnd();
+		auto element = Value{*doc.begin()}.element();
+		auto value = Value::make_element(element.data, element.size);
+
+		BOOST_CHECK_EQUAL(false, value.is_inline());
+		BOOST_CHECK_EQUAL(std::string("a string is not stored inline"), value._c_str());
+	}
+
+	BOOST_AUTO_TEST_CASE(indexed_large_document)
+	{
+		auto nested = build_document();
+		auto builder = build_document();
+		for (int i = 0; i != 100; ++i) {
+			auto name = "field" + std::to_string(i);
+			nested = std::move(nested) << name.c_str() << 2 * i;
+			builder = std::move(builder) << name.c_str() << i;
+		}
+		auto doc = std::move(builder) << "field0" << -1 << "nested" << (std::move(nested) << ValueEnd()) << ValueEnd();
+
+		for (int repeat = 0; repeat != 2; ++repeat) {
+			for (int i = 0; i != 100; ++i) {
+				auto name = "field" + std::to_string(i);
+				BOOST_CHECK_EQUAL(i, doc[name.c_str()]._int());
+				BOOST_CHECK_EQUAL(2 * i, doc["nested"][name.c_str()]._int());
+			}
+			BOOST_CHECK_EQUAL(0, doc["field0"_int]); // the first of duplicate fields
+			BOOST_CHECK_EQUAL(true, doc["missing"].is_undefined());
+			BOOST_CHECK_EQUAL(true, doc["nested"]["missing"].is_undefined());
+		}
+	}
+
+	BOOST_AUTO_TEST_CASE(indexed_large_document_on_many_threads)
+	{
+		auto builder = build_document();
+		for (int i = 0; i != 100; ++i) {
+			auto name = "field" + std::to_string(i);
+			builder = std::move(builder) << name.c_str() << i;
+		}
+		auto doc = std::move(builder) << ValueEnd();
+
+		std::atomic_int failures{};
+		std::vector<std::thread> threads{};
+		for (int t = 0; t != 4; ++t) {
+			threads.emplace_back([&doc, &failures]() {
+				for (int repeat = 0; repeat != 10; ++repeat) {
+					for (int i = 0; i != 100; ++i) {
+						auto name = "field" + std::to_string(i);
+						if (doc[name.c_str()]._int() != i)
+							++failures;
+					}
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		BOOST_CHECK_EQUAL(0, failures.load());
+	}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+// Copyright Felix Ungman. All rights reserved.
+// Licensed under GNU General Public License version 3 or later.
+
+#ifndef WARSTAGE__VALUE__VISITOR_H
+#define WARSTAGE__VALUE__VISITOR_H
+
+#include "./buffer.h"
+#include "./object-id.h"
+#include <vector>
+
+
+// Receives the elements of a value as they are decoded, see
+// ValueDecompressor::visit. Names are element names in documents and
+// indices ("0", "1", ...) in arrays, and like string and binary data
+// they are only valid during the call. Strings are not nul terminated.
+
+class ValueVisitor {
+public:
+    virtual ~ValueVisitor() = default;
+
+    virtual void begin_document(const char* name) {}
+    virtual void begin_array(const char* name) {}
+    virtual void end() {} // ends the innermost document or array
+
+    virtual void visit_null(const char* name) {}
+    virtual void visit_boolean(const char* name, bool value) {}
+    virtual void visit_int32(const char* name, std::int32_t value) {}
+    virtual void visit_double(const char* name, double value) {}
+    virtual void visit_string(const char* name, const char* data, std::size_t size) {}
+    virtual void visit_binary(const char* name, const void* data, std::size_t size) {}
+    virtual void visit_ObjectId(const char* name, ObjectId value) {}
+};
+
+
+// Writes visited elements to a buffer as bson. A document or array
+// begun with a null name is written without type and name, as the
+// root of the buffer.
+
+class ValueWriter final : public ValueVisitor {
+    ValueBuffer buffer_{};
+    std::vector<std::size_t> starts_{};
+
+public:
+    [[nodiscard]] ValueBuffer& buffer() { return buffer_; }
+    [[nodiscard]] const ValueBuffer& buffer() const { return buffer_; }
+
+    void clear() {
+        buffer_.value_.clear();
+        buffer_.level_ = 0;
+        starts_.clear();
+    }
+
+    void begin_document(const char* name) override {
+        begin(ValueType::_document, name);
+    }
+    void begin_array(const char* name) override {
+        begin(ValueType::_array, name);
+    }
+    void end() override {
+        buffer_.add_byte(0);
+        buffer_.set_int32(starts_.back(), buffer_.diff(starts_.back()));
+        starts_.pop_back();
+    }
+
+    void visit_null(const char* name) override {
+        add_header(ValueType::_null, name);
+    }
+    void visit_boolean(const char* name, bool value) override {
+        add_header(ValueType::_boolean, name);
+        buffer_.add_byte(value ? 1 : 0);
+    }
+    void visit_int32(const char* name, std::int32_t value) override {
+        add_header(ValueType::_int32, name);
+        buffer_.add_int32(value);
+    }
+    void visit_double(const char* name, double value) override {
+        add_header(ValueType::_double, name);
+        buffer_.add_double(value);
+    }
+    void visit_string(const char* name, const char* data, std::size_t size) override {
+        add_header(ValueType::_string, name);
+        buffer_.add_int32(static_cast<std::int32_t>(size + 1));
+        buffer_.add_binary(data, size);
+        buffer_.add_byte(0);
+    }
+    void visit_binary(const char* name, const void* data, std::size_t size) override {
+        add_header(ValueType::_binary, name);
+        buffer_.add_int32(static_cast<std::int32_t>(size));
+        buffer_.add_byte(0);
+        buffer_.add_binary(data, size);
+    }
+    void visit_ObjectId(const char* name, ObjectId value) override {
+        add_header(ValueType::_ObjectId, name);
+        buffer_.add_binary(value.data(), value.size());
+    }
+
+private:
+    void begin(ValueType type, const char* name) {
+        if (name) {
+            add_header(type, name);
+        }
+        starts_.push_back(buffer_.size());
+        buffer_.add_int32(0);
+    }
+    void add_header(ValueType type, const char* name) {
+        buffer_.add_byte(static_cast<char>(type));
+        buffer_.add_string(name);
+    }
+};
+
+#endif